@@ -30,14 +30,72 @@
 
 #include "erg.h"
 
-#include <map>
+#include <list>
+#include <unordered_map>
 #include <iostream>
 #include <string>
 #include <cctype>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <exception>
+#include <cerrno>
+#include <limits>
+#include <type_traits>
+#include <cmath>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define ERG_HAVE_MMAP
+    #define ERG_HAVE_PREAD
+#endif
+
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #define ERG_HAVE_INOTIFY
+    #define ERG_HAVE_FADVISE
+    #define ERG_HAVE_DIRECT
+#endif
 
 
 #define HEADER_SIZE     16
 
+// Bytes of records loaded from the file by each bulk read.
+#define BLOCK_SIZE      (1024*1024)
+// Records transposed at once: a tile must stay in the L1/L2 cache while all
+// the quantities are extracted from it.
+#define TILE_RECORDS    256
+#define CACHE_LINE_SIZE 64
+// Strided reads with a larger gap between the selected records read each record
+// on its own instead of the whole span.
+#define SPARSE_GAP      (16*1024)
+// Reads spanning at least this percentage of the records add the whole columns
+// to the decoded column cache.
+#define CACHE_FILL_PERCENT  50
+// Alignment of the offsets, sizes and buffers of the O_DIRECT reads.
+#define DIRECT_ALIGNMENT 4096
+// Identifier and version of the column-major sidecar files.
+#define SIDECAR_MAGIC   "ERG-COL"
+#define SIDECAR_VERSION 2
+// Records transcoded at once when the sidecar file is built.
+#define SIDECAR_CHUNK   65536
+// Identifier and version of the time index files.
+#define TIME_INDEX_MAGIC    "ERG-TIX"
+#define TIME_INDEX_VERSION  1
+// Identifier and version of the zone map files.
+#define ZONE_MAP_MAGIC      "ERG-ZMP"
+#define ZONE_MAP_VERSION    1
+// Records evaluated at once by the filtered reads.
+#define FILTER_CHUNK    65536
+// Maximum records reduced at once by each thread of the statistics.
+#define STATS_CHUNK     8192
+// Records interpolated at once by the resampling reads.
+#define RESAMPLE_CHUNK  16384
+
 
 namespace erg
 {
@@ -150,24 +208,61 @@ static constexpr uint64_t le2h64(const uint64_t val)
 
 
 /*!
- * \brief Remove start and trailing spaces from a string.
- * \param str Input string
- * \return A new string from the input
+ * \brief Slice of a character buffer, used to parse the companion file without copies.
  */
-std::string trim(const std::string& str)
+struct Token
 {
-    auto front = std::find_if_not(str.begin(), str.end(), [](int c){ return ::isspace(c); });
-    auto back = std::find_if_not(str.rbegin(), str.rend(), [](int c){ return ::isspace(c); }).base();
+    const char* data;
+    size_t size;
 
-    if(back <= front)
-        return std::string();
+    bool operator==(const Token& other) const noexcept(true)
+    {
+        return size==other.size && std::memcmp(data, other.data, size)==0;
+    }
 
-    return std::string(front, back);
-}
+    bool startsWith(const char* prefix, const size_t length) const noexcept(true)
+    {
+        return size>=length && std::memcmp(data, prefix, length)==0;
+    }
+
+    bool endsWith(const char* suffix, const size_t length) const noexcept(true)
+    {
+        return size>=length && std::memcmp(data + size - length, suffix, length)==0;
+    }
+
+    bool equals(const char* str, const size_t length) const noexcept(true)
+    {
+        return size==length && std::memcmp(data, str, length)==0;
+    }
+
+    std::string str() const { return std::string(data, size); }
+};
+
+//! FNV-1a hash of a token
+struct TokenHash
+{
+    size_t operator()(const Token& token) const noexcept(true)
+    {
+        uint64_t h = 14695981039346656037ull;
+        for(size_t i=0; i<token.size; ++i)
+            h = (h ^ static_cast<uint8_t>(token.data[i])) * 1099511628211ull;
+        return static_cast<size_t>(h);
+    }
+};
 
-std::string trimComments(const std::string& str)
+/*!
+ * \brief Remove start and trailing spaces from a range of characters.
+ * \param begin First character
+ * \param end Past the last character
+ * \return The trimmed token, empty if there are only spaces.
+ */
+static Token trimToken(const char* begin, const char* end) noexcept(true)
 {
-    return str.substr(0, str.find('#'));
+    while(begin<end && ::isspace(static_cast<unsigned char>(*begin)))
+        ++begin;
+    while(end>begin && ::isspace(static_cast<unsigned char>(end[-1])))
+        --end;
+    return Token{begin, static_cast<size_t>(end - begin)};
 }
 
 
@@ -238,438 +333,3105 @@ void Reader::arrayBe2Host(uint8_t* data, const size_t elementSize, const size_t
 
 
 
-
-Reader::Reader() noexcept(true)
+#ifdef ERG_HAVE_PREAD
+/*!
+ * \brief Positional read retried until all the data is read or the end of the file.
+ * \param fd File descriptor.
+ * \param buffer Destination buffer.
+ * \param size Number of bytes to read.
+ * \param offset Position in the file.
+ * \return The number of bytes that has been read.
+ */
+static size_t preadFully(const int fd, uint8_t* buffer, const size_t size, const size_t offset)
 {
+    size_t done = 0;
+    while(done<size)
+    {
+        const ssize_t n = ::pread(fd, buffer + done, size - done, offset + done);
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n<=0)
+            break;
+        done += n;
+    }
+    return done;
 }
+#endif
 
-Reader::Reader(const std::string& filename)  noexcept(false)
+/*!
+ * \brief Write a file through a temporary file and a rename.
+ *
+ * Readers never see a partial file. The temporary file has a unique name, so
+ * processes writing the same file at once don't mix their content.
+ *
+ * \param filename Name of the file.
+ * \param write Writes the content of the file.
+ * \throws If the file can't be written.
+ */
+static void writeFileAtomically(const std::string& filename, const std::function<void(std::ofstream&)>& write)
 {
-    open(filename);
-}
-
+#ifdef ERG_HAVE_PREAD
+    std::string tmpFilename = filename+".XXXXXX";
+    const int fd = ::mkstemp(&tmpFilename[0]);
+    if(fd<0)
+        throw std::runtime_error("Can't write "+filename+" file.");
+    // Same permissions of the other files, instead of the private ones of mkstemp()
+    ::fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    ::close(fd);
+#else
+    const std::string tmpFilename = filename+".tmp";
+#endif
+    {
+        std::ofstream out(tmpFilename, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        if(!out.is_open())
+            throw std::runtime_error("Can't write "+tmpFilename+" file.");
+        try {
+            write(out);
+        } catch(...) {
+            out.close();
+            std::remove(tmpFilename.c_str());
+            throw;
+        }
+        out.close();
+        if(out.fail()) {
+            std::remove(tmpFilename.c_str());
+            throw std::runtime_error("Can't write "+tmpFilename+" file.");
+        }
+    }
 
-Reader::~Reader()
-{
-    close();
+    if(std::rename(tmpFilename.c_str(), filename.c_str())!=0) {
+        std::remove(tmpFilename.c_str());
+        throw std::runtime_error("Can't write "+filename+" file.");
+    }
 }
 
-
-void Reader::open(const std::string& filename)
+/*!
+ * \brief Read-only memory mapping of a whole file.
+ *
+ * The mapping is released when the last reference to the object goes away.
+ */
+class MappedFile
 {
-    static_assert(sizeof(header_t) == HEADER_SIZE, "Header size must be 16 bytes");
+public:
+    /*!
+     * \brief Map the file
+     * \param filename Name of the file to map.
+     * \throws If the file can't be mapped.
+     */
+    explicit MappedFile(const std::string& filename) noexcept(false)
+        : mData(nullptr), mSize(0)
+    {
+#ifdef ERG_HAVE_MMAP
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if(fd<0)
+            throw std::runtime_error("Can't open "+filename+" file.");
+
+        struct stat st;
+        if(::fstat(fd, &st)!=0 || st.st_size<=0) {
+            ::close(fd);
+            throw std::runtime_error("Can't map an empty file: "+filename);
+        }
 
-    // Clear data
-    close();
+        void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        // The mapping is still valid after the file descriptor is closed.
+        ::close(fd);
+        if(addr==MAP_FAILED)
+            throw std::runtime_error("Can't map "+filename+" file.");
+
+        mData = reinterpret_cast<const uint8_t*>(addr);
+        mSize = st.st_size;
+#else
+        throw std::runtime_error("Memory mapped files are not supported on this platform.");
+#endif
+    }
 
-    mFilename = filename;
+    ~MappedFile()
+    {
+#ifdef ERG_HAVE_MMAP
+        if(mData!=nullptr)
+            ::munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+    }
 
-    // Parse companion file.
-    parseInfoFile();
+    const uint8_t* data() const noexcept(true) { return mData; }
+    size_t size() const noexcept(true) { return mSize; }
 
-    mFile.open(filename, std::ios_base::in | std::ios_base::binary);
-    if(mFile.is_open()==false) {
-        close();
-        throw std::runtime_error("Can't open "+filename+" file.");
+    /*!
+     * \brief Ask the kernel to read a range of the file ahead.
+     * \param offset Offset of the range in the file.
+     * \param size Size of the range.
+     */
+    void willNeed(const size_t offset, const size_t size) const noexcept(true)
+    {
+#ifdef ERG_HAVE_MMAP
+        advise(offset, size, MADV_WILLNEED);
+#endif
     }
 
-    if(mFormat==Format::Erg)
-        parseErgFormat();
-    else
-        parseFortranFormat();
-}
+    /*!
+     * \brief Forward an access pattern hint for a range of the file.
+     * \param offset Offset of the range in the file.
+     * \param size Size of the range.
+     * \param advice The `madvise()` advice.
+     */
+    void advise(const size_t offset, const size_t size, const int advice) const noexcept(true)
+    {
+#ifdef ERG_HAVE_MMAP
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        const size_t start = offset - offset % page;
+        const size_t end = std::min(mSize, offset + size);
+        if(start<end)
+            ::madvise(const_cast<uint8_t*>(mData) + start, end - start, advice);
+#else
+        (void)offset;
+        (void)size;
+        (void)advice;
+#endif
+    }
 
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
 
-size_t Reader::readAll(std::vector<uint8_t*>& values, const std::vector<size_t>& sizes)
-{
-    if(values.size()!=sizes.size())
-        throw std::runtime_error("Wrong input size");
+    const uint8_t* mData;
+    size_t mSize;
+};
 
-    const size_t nds = numQuanities();
-    if(nds<values.size())
-        throw std::runtime_error("No data for all the datasets");
 
-    for(size_t i=0; i<nds; ++i) {
-        if(sizes[i] < quantitySize(i))
-            throw std::runtime_error("Not enought space for dataset "+mQuantities[i].name);
+/*!
+ * \brief Heap memory block aligned to a cache line, or to a larger power of two.
+ */
+class AlignedBuffer
+{
+public:
+    explicit AlignedBuffer(const size_t size, const size_t alignment=CACHE_LINE_SIZE) noexcept(false)
+        : mStorage(new uint8_t[size + alignment]), mSize(size)
+    {
+        // Not initialized: the buffer is always filled before it is read
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(mStorage.get());
+        mData = mStorage.get() + (alignment - addr % alignment) % alignment;
     }
 
+    uint8_t* data() noexcept(true) { return mData; }
+    size_t size() const noexcept(true) { return mSize; }
 
-    mFile.seekg(initialSkipBytes(), std::ios_base::beg);
+private:
+    std::unique_ptr<uint8_t[]> mStorage;
+    size_t mSize;
+    uint8_t* mData;
+};
 
-    std::vector<uint8_t> row(mRecordSize, 0);
-    uint8_t* data = row.data();
-    size_t readRows = 0;
-    for(size_t rid=0; rid<mRecordsCount; ++rid)
-    {
-        mFile.read(reinterpret_cast<char*>(data), mRecordSize);
-        if(mFile.eof())
-            break;
 
-        readRows += 1;
+#ifdef ERG_HAVE_DIRECT
+/*!
+ * \brief Read from an `O_DIRECT` descriptor through an aligned bounce buffer.
+ *
+ * The bounce buffer of each thread is reused by the next reads.
+ * \param fd File descriptor opened with `O_DIRECT`.
+ * \param offset Position in the file.
+ * \param buffer Destination buffer, with any alignment.
+ * \param size Number of bytes to read.
+ * \return The number of bytes that has been read.
+ */
+static size_t readDirectBounced(const int fd, const size_t offset, uint8_t* buffer, const size_t size)
+{
+    static thread_local std::unique_ptr<AlignedBuffer> bounce;
+
+    const size_t start = offset - offset % DIRECT_ALIGNMENT;
+    const size_t end = (offset + size + DIRECT_ALIGNMENT - 1) / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+    if(!bounce || bounce->size()<end - start)
+        bounce.reset(new AlignedBuffer(end - start, DIRECT_ALIGNMENT));
+
+    const size_t done = preadFully(fd, bounce->data(), end - start, start);
+    if(done<=offset - start)
+        return 0;
+    const size_t copied = std::min(size, done - (offset - start));
+    std::memcpy(buffer, bounce->data() + (offset - start), copied);
+    return copied;
+}
+#endif
 
-        for(size_t ds=0; ds<nds; ++ds)
-        {
-            const size_t outOffset = rid * mQuantities[ds].size;
-            const size_t inOffset = mQuantities[ds].offset;
-            uint8_t* outData = values[ds];
-            std::memcpy(outData + outOffset,  data + inOffset, mQuantities[ds].size);
-        }
+/*!
+ * \brief Lock-free queue with a single producer and a single consumer thread.
+ */
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(const size_t capacity) noexcept(false)
+        : mSlots(capacity + 1), mHead(0), mTail(0)
+    {}
+
+    /*!
+     * \brief Append a value. Only the producer thread can call it.
+     * \return `false` if the queue is full.
+     */
+    bool push(const T& value) noexcept(true)
+    {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) % mSlots.size();
+        if(next==mHead.load(std::memory_order_acquire))
+            return false;
+        mSlots[tail] = value;
+        mTail.store(next, std::memory_order_release);
+        return true;
     }
 
-    // Correct endianess
-    for(size_t ds=0; ds<nds; ++ds)
+    /*!
+     * \brief Extract the oldest value. Only the consumer thread can call it.
+     * \return `false` if the queue is empty.
+     */
+    bool pop(T& value) noexcept(true)
     {
-        uint8_t* outData = values[ds];
-        if(mByteOrder==ByteOrder::LittelEndian)
-            arrayLe2Host(outData, mQuantities[ds].size, readRows);
-        else
-            arrayBe2Host(outData, mQuantities[ds].size, readRows);
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if(head==mTail.load(std::memory_order_acquire))
+            return false;
+        value = mSlots[head];
+        mHead.store((head + 1) % mSlots.size(), std::memory_order_release);
+        return true;
     }
 
-    return readRows;
+private:
+    std::vector<T> mSlots;
+    std::atomic<size_t> mHead;  //!< Next slot to read, owned by the consumer
+    std::atomic<size_t> mTail;  //!< Next slot to write, owned by the producer
+};
+
+/*!
+ * \brief Back off while waiting on a SpscQueue.
+ * \param spins Number of failed attempts so far.
+ */
+static void waitQueue(const size_t spins)
+{
+    if(spins<64)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
 }
 
-size_t Reader::read(const size_t qindex, uint8_t* dst, const size_t size)
+
+/*!
+ * \brief Least recently used cache of decoded columns, bounded by a memory budget.
+ *
+ * All the methods are thread safe.
+ */
+class ColumnCache
 {
-    return read(qindex, 0, mRecordsCount, dst, size);
-    /*
-    if(qindex>=mQuantities.size())
-        throw std::runtime_error("Index "+std::to_string(qindex)+" is out of bounds.");
+public:
+    ColumnCache() noexcept(true)
+        : mBudget(0), mBytes(0), mHits(0), mMisses(0), mEvictions(0)
+    {}
+
+    /*!
+     * \brief Find a cached column and mark it as the most recently used.
+     * \param qindex Index of the quantity.
+     * \return The decoded column in host byte order or `nullptr` if it is not cached.
+     */
+    std::shared_ptr<const std::vector<uint8_t> > find(const size_t qindex) noexcept(true)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mEntries.find(qindex);
+        if(it==mEntries.end()) {
+            ++mMisses;
+            return nullptr;
+        }
+        ++mHits;
+        mOrder.splice(mOrder.begin(), mOrder, it->second.position);
+        return it->second.data;
+    }
 
-    const Quantity& qt = mQuantities[qindex];
+    /*!
+     * \brief Add a decoded column, evicting the least recently used ones.
+     * \param qindex Index of the quantity.
+     * \param data The whole decoded column.
+     */
+    void insert(const size_t qindex, const std::shared_ptr<const std::vector<uint8_t> >& data) noexcept(false)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const size_t size = data->size();
+        if(size>mBudget || mEntries.count(qindex)>0)
+            return;
+
+        while(mBytes+size>mBudget)
+            evictLast();
+
+        Entry entry;
+        entry.data = data;
+        mOrder.push_front(qindex);
+        entry.position = mOrder.begin();
+        mEntries[qindex] = entry;
+        mBytes += size;
+    }
 
-    if((qt.size*mRecordsCount)>size)
-        throw std::runtime_error("Not enough data allocated");
+    void clear() noexcept(true)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.clear();
+        mOrder.clear();
+        mBytes = 0;
+    }
 
-    memset(outData, 0, size);
-    const size_t inOffset = qt.offset;
+    void setBudget(const size_t bytes) noexcept(true)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mBudget = bytes;
+        while(mBytes>mBudget)
+            evictLast();
+    }
 
-    mFile.seekg(initialSkipBytes(), std::ios_base::beg);
+    size_t budget() const noexcept(true)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mBudget;
+    }
 
-    std::vector<uint8_t> row(mRecordSize, 0);
-    uint8_t* rowData = row.data();
-    size_t readRows = 0;
-    for(size_t rid=0; rid<mRecordsCount; ++rid)
+    CacheStats stats() const noexcept(true)
     {
-        mFile.read(reinterpret_cast<char*>(rowData), mRecordSize);
-        if(mFile.eof())
-            break;
+        std::lock_guard<std::mutex> lock(mMutex);
+        CacheStats s;
+        s.hits = mHits;
+        s.misses = mMisses;
+        s.evictions = mEvictions;
+        s.bytes = mBytes;
+        s.columns = mEntries.size();
+        return s;
+    }
 
-        readRows += 1;
+private:
+    struct Entry
+    {
+        std::shared_ptr<const std::vector<uint8_t> > data;  //!< Decoded column in host byte order
+        std::list<size_t>::iterator position;               //!< Position in mOrder
+    };
 
-        const size_t outOffset = rid * qt.size;
-        std::memcpy(outData + outOffset,  rowData + inOffset, qt.size);
+    //! Remove the least recently used column. The mutex must be locked.
+    void evictLast() noexcept(true)
+    {
+        const size_t qindex = mOrder.back();
+        mBytes -= mEntries[qindex].data->size();
+        mEntries.erase(qindex);
+        mOrder.pop_back();
+        ++mEvictions;
     }
 
-    if(mByteOrder==ByteOrder::LittelEndian)
-        arrayLe2Host(outData, qt.size, readRows);
-    else
-        arrayBe2Host(outData, qt.size, readRows);
+    mutable std::mutex mMutex;
+    std::unordered_map<size_t, Entry> mEntries;
+    std::list<size_t> mOrder;   //!< Most recently used first
+    size_t mBudget;
+    size_t mBytes;
+    size_t mHits;
+    size_t mMisses;
+    size_t mEvictions;
+};
 
-    return readRows;
-    */
+/*!
+ * \brief Copy a field of `N` bytes from each record into a contiguous array.
+ * \param records First record
+ * \param recordSize Distance in bytes between two records
+ * \param rows Number of records
+ * \param dst Destination array
+ */
+template<size_t N>
+static void transposeField(const uint8_t* records, const size_t recordSize, const size_t rows, uint8_t* dst)
+{
+    // The fixed size memcpy is compiled to a single load/store pair.
+    for(size_t i=0; i<rows; ++i)
+        std::memcpy(dst + i*N, records + i*recordSize, N);
 }
 
-size_t Reader::read(const size_t qindex, const size_t from, const size_t count, uint8_t* dst, const size_t size)
+/*!
+ * \brief Copy a quantity from each record into a contiguous array.
+ * \param records First record
+ * \param recordSize Distance in bytes between two records
+ * \param rows Number of records
+ * \param q The quantity to copy
+ * \param dst Destination array
+ */
+static void transposeQuantity(const uint8_t* records, const size_t recordSize, const size_t rows,
+                              const Quantity& q, uint8_t* dst)
 {
-    if(qindex>=mQuantities.size())
-        throw std::runtime_error("Index "+std::to_string(qindex)+" is out of bounds.");
-
-    const Quantity& qt = mQuantities[qindex];
+    const uint8_t* src = records + q.offset;
+    switch (q.size) {
+    case 1:
+        transposeField<1>(src, recordSize, rows, dst);
+        break;
+    case 2:
+        transposeField<2>(src, recordSize, rows, dst);
+        break;
+    case 4:
+        transposeField<4>(src, recordSize, rows, dst);
+        break;
+    case 8:
+        transposeField<8>(src, recordSize, rows, dst);
+        break;
+    default:
+        for(size_t i=0; i<rows; ++i)
+            std::memcpy(dst + i*q.size, src + i*recordSize, q.size);
+        break;
+    }
+}
 
-    size_t expectedSize = qt.size * count;
-    if(expectedSize>size)
-        throw std::runtime_error("Not enough data allocated: "+std::to_string(size)+\
-                                 " instead of "+std::to_string(expectedSize)+" bytes.");
 
-    memset(dst, 0, size);
-    const size_t inOffset = qt.offset;
+static inline uint8_t bswap(const uint8_t x) { return x; }
+static inline uint16_t bswap(const uint16_t x) { return bswap16(x); }
+static inline uint32_t bswap(const uint32_t x) { return bswap32(x); }
+static inline uint64_t bswap(const uint64_t x) { return bswap64(x); }
 
-    // Skip initial bytes
-    size_t bytesToSkip = initialSkipBytes() + mRecordSize * from;
-    mFile.seekg(bytesToSkip, std::ios_base::beg);
+/*!
+ * \brief Unsigned integer with the same size of a datatype.
+ */
+template<size_t N> struct UintOfSize;
+template<> struct UintOfSize<1> { typedef uint8_t type; };
+template<> struct UintOfSize<2> { typedef uint16_t type; };
+template<> struct UintOfSize<4> { typedef uint32_t type; };
+template<> struct UintOfSize<8> { typedef uint64_t type; };
 
-    std::vector<uint8_t> row(mRecordSize, 0);
-    uint8_t* rowData = row.data();
-    size_t readRows = 0;
-    for(size_t index=0; index<count; ++index)
-    {
-        mFile.read(reinterpret_cast<char*>(rowData), mRecordSize);
-        if(mFile.eof())
-            break;
+/*!
+ * \brief Load a value from unaligned memory, swapping its bytes if needed.
+ * \param src Memory of the value
+ * \return The value
+ */
+template<typename S, bool Swap>
+static inline S loadValue(const uint8_t* src)
+{
+    typedef typename UintOfSize<sizeof(S)>::type U;
+    U bits;
+    std::memcpy(&bits, src, sizeof(S));
+    if(Swap)
+        bits = bswap(bits);
+    S value;
+    std::memcpy(&value, &bits, sizeof(S));
+    return value;
+}
 
-        readRows += 1;
+/*!
+ * \brief Conversion of a value of type `S` to type `T`.
+ */
+template<typename S, typename T,
+         bool FloatToInt = std::is_floating_point<S>::value && std::is_integral<T>::value>
+struct ConvertValue
+{
+    static inline T apply(const S value) { return static_cast<T>(value); }
+};
 
-        const size_t outOffset = index * qt.size;
-        std::memcpy(dst + outOffset,  rowData + inOffset, qt.size);
+/*!
+ * \brief Conversion of a floating point value to an integer type.
+ *
+ * The value is saturated to the range of `T` and nan becomes zero: a plain
+ * cast of these values is undefined.
+ */
+template<typename S, typename T>
+struct ConvertValue<S, T, true>
+{
+    static inline T apply(const S value)
+    {
+        if(value!=value)
+            return 0;
+        // The limits converted to S are exact or rounded up to the next power of two
+        if(value<=static_cast<S>(std::numeric_limits<T>::min()))
+            return std::numeric_limits<T>::min();
+        if(value>=static_cast<S>(std::numeric_limits<T>::max()))
+            return std::numeric_limits<T>::max();
+        return static_cast<T>(value);
     }
+};
 
-    if(mByteOrder==ByteOrder::LittelEndian)
-        arrayLe2Host(dst, qt.size, readRows);
-    else
-        arrayBe2Host(dst, qt.size, readRows);
-
-    return readRows;
-}
-
-size_t Reader::index(const std::string &qname) const noexcept(false)
+/*!
+ * \brief Conversion kernel: extract a field of type `S` from each record and
+ * store it as type `T`.
+ * \param records Field in the first record
+ * \param stride Distance in bytes between two records
+ * \param rows Number of records
+ * \param dst Destination array of `T`
+ */
+template<typename S, typename T, bool Swap>
+static void convertField(const uint8_t* records, const size_t stride, const size_t rows, uint8_t* dst)
 {
-    auto nameIt = std::find_if(mQuantities.cbegin(),
-                               mQuantities.cend(),
-                               [&qname](const Quantity& q)->bool{ return q.name==qname; });
-    if(nameIt==mQuantities.cend())
-        throw std::runtime_error("The quantity "+qname+" does not exists.");
-    return std::distance(mQuantities.cbegin(), nameIt);
+    T* out = reinterpret_cast<T*>(dst);
+    for(size_t i=0; i<rows; ++i)
+        out[i] = ConvertValue<S, T>::apply(loadValue<S, Swap>(records + i*stride));
 }
 
-bool Reader::has(const std::string &qname) const noexcept(true)
+template<typename T, bool Swap>
+Reader::ConvertFunction Reader::convertKernel(const Type type) noexcept(false)
 {
-    try {
-        index(qname);
-        return true;
-    } catch(...) {
-        return false;
+    switch (type)
+    {
+    case Type::Int8:
+        return &convertField<int8_t, T, Swap>;
+    case Type::Int16:
+        return &convertField<int16_t, T, Swap>;
+    case Type::Int32:
+        return &convertField<int32_t, T, Swap>;
+    case Type::Int64:
+        return &convertField<int64_t, T, Swap>;
+    case Type::Uint8:
+        return &convertField<uint8_t, T, Swap>;
+    case Type::Uint16:
+        return &convertField<uint16_t, T, Swap>;
+    case Type::Uint32:
+        return &convertField<uint32_t, T, Swap>;
+    case Type::Uint64:
+        return &convertField<uint64_t, T, Swap>;
+    case Type::Float:
+        return &convertField<float, T, Swap>;
+    case Type::Double:
+        return &convertField<double, T, Swap>;
+    case Type::Void:
+    default:
+        throw std::runtime_error("Unknown data type.");
     }
 }
 
-void Reader::close() noexcept(true)
+
+/*!
+ * \brief Name of the companion file of an `.erg` file.
+ * \param filename Name of the `.erg` file.
+ * \return `<filename>.info` or, if missing, `<filename>` with the `.info` extension; empty if none exists.
+ */
+static std::string companionFilename(const std::string& filename) noexcept(false)
 {
-    if(mFile.is_open())
-        mFile.close();
+    // Test for "filename.erg.info" companion file
+    std::string infoFilename = filename+".info";
+    if (std::ifstream(infoFilename).is_open())
+        return infoFilename;
 
-    mFilename.clear();
-    mFileSize = 0;
-    mRecordsCount = 0;
-    mRecordSize = 0;
-    mFormat = Format::Erg;
-    mByteOrder = ByteOrder::LittelEndian;
-    mQuantities.clear();
-}
+    // Test for "filename.info" companion file
+    infoFilename = filename.substr(0, filename.find_last_of('.')) + ".info";
+    if (std::ifstream(infoFilename).is_open())
+        return infoFilename;
 
+    return std::string();
+}
 
-void Reader::parseInfoFile()
+/*!
+ * \brief Content of a companion file.
+ *
+ * The file is mapped, or read with a single call where it can't be mapped,
+ * and it is tokenized in place.
+ */
+class InfoFile
 {
-    std::ifstream info;
-    // Test for "filename.erg.info" companion file
-    info.open(mFilename+".info");
-    if (info.is_open()==false)
-    {
-        // Test for "filename.info" companion file
-        int i = mFilename.find_last_of('.');
-        std::string filename = mFilename.substr(0, i) + ".info";
-        info.open(filename);
-        if (info.is_open()==false)
-        {
-            close();
-            throw std::runtime_error("Can't open "+mFilename+" companion file.");
+public:
+    /*!
+     * \brief Load the file
+     * \param filename Name of the companion file.
+     * \throws If the file can't be opened.
+     */
+    explicit InfoFile(const std::string& filename) noexcept(false)
+        : mBegin(nullptr), mEnd(nullptr)
+    {
+        try {
+            mMapped.reset(new MappedFile(filename));
+            mBegin = reinterpret_cast<const char*>(mMapped->data());
+            mEnd = mBegin + mMapped->size();
+            return;
+        } catch(std::runtime_error&) {
         }
+
+        std::ifstream info(filename, std::ios_base::binary);
+        if(info.is_open()==false)
+            throw std::runtime_error("Can't open "+filename+" file.");
+        info.seekg(0, std::ios_base::end);
+        const std::streamoff size = info.tellg();
+        mContent.resize(size>0 ? static_cast<size_t>(size) : 0);
+        info.seekg(0, std::ios_base::beg);
+        info.read(mContent.data(), mContent.size());
+        mContent.resize(static_cast<size_t>(std::max<std::streamsize>(0, info.gcount())));
+        mBegin = mContent.data();
+        mEnd = mBegin + mContent.size();
     }
 
-    std::string line;
-    std::map<std::string, std::string> infoMap;
+    const char* begin() const noexcept(true) { return mBegin; }
+    const char* end() const noexcept(true) { return mEnd; }
+
+private:
+    InfoFile(const InfoFile&) = delete;
+    InfoFile& operator=(const InfoFile&) = delete;
+
+    std::unique_ptr<MappedFile> mMapped;
+    std::vector<char> mContent;
+    const char* mBegin;
+    const char* mEnd;
+};
+
+/*!
+ * \brief Compare a token with a string, ignoring the case.
+ * \param token The token.
+ * \param str Lowercase string.
+ * \param length Length of the string.
+ * \return `true` if they are equal.
+ */
+static bool equalsLower(const Token& token, const char* str, const size_t length) noexcept(true)
+{
+    if(token.size!=length)
+        return false;
+    for(size_t i=0; i<length; ++i)
+        if(::tolower(static_cast<unsigned char>(token.data[i]))!=str[i])
+            return false;
+    return true;
+}
 
-    // Read all file as key, value pairs
-    while(info.eof()==false)
+/*!
+ * \brief Read the format and the byte order of the data from a companion file.
+ *
+ * The lines are scanned in place: as in parseInfoFile(), a later definition
+ * of a key replaces the previous one.
+ *
+ * \param info Content of the companion file.
+ * \param infoFilename Name of the companion file, for the error messages.
+ * \param checkHeader Require the `#INFOFILE` header on the first line.
+ * \param format Format of the data.
+ * \param byteOrder Byte order of the data.
+ * \throws If a key is missing or its value is unknown.
+ */
+static void readInfoFormat(const InfoFile& info, const std::string& infoFilename, const bool checkHeader,
+                           Format& format, ByteOrder& byteOrder) noexcept(false)
+{
+    const char* begin = info.begin();
+    const char* end = info.end();
+    if(checkHeader && (end - begin<9 || std::memcmp(begin, "#INFOFILE", 9)!=0))
+        throw std::runtime_error("Not an info file: "+infoFilename);
+
+    Token formatStr{nullptr, 0};
+    Token byteOrderStr{nullptr, 0};
+    for(const char* line=begin; line<end; )
     {
-        // Start to read a parameter
-        std::getline(info, line);
-        size_t i = line.find('=');
-        if(i!=std::string::npos)
-        {
-            line = trimComments(line);
-            std::string key = trim(line.substr(0, i));
-            std::string val = trim(line.substr(i+1));
-            infoMap[key] = val;
+        const char* lineEnd = reinterpret_cast<const char*>(std::memchr(line, '\n', end - line));
+        if(lineEnd==nullptr)
+            lineEnd = end;
+        const char* next = lineEnd + 1;
+
+        const char* eq = reinterpret_cast<const char*>(std::memchr(line, '=', lineEnd - line));
+        const char* comment = reinterpret_cast<const char*>(std::memchr(line, '#', lineEnd - line));
+        if(eq!=nullptr && (comment==nullptr || comment>eq)) {
+            const Token key = trimToken(line, eq);
+            if(key.equals("File.Format", 11))
+                formatStr = trimToken(eq + 1, comment!=nullptr ? comment : lineEnd);
+            else if(key.equals("File.ByteOrder", 14))
+                byteOrderStr = trimToken(eq + 1, comment!=nullptr ? comment : lineEnd);
         }
+        line = next;
     }
 
     // Decode file format
-    {
-        auto formatStrIt = infoMap.find("File.Format");
-        if(formatStrIt==infoMap.end())
-            throw std::runtime_error("Format not specified.");
-        std::string format = trim(formatStrIt->second);
-        std::transform(format.begin(), format.end(), format.begin(), ::tolower);
-        if(format=="erg") {
-            mFormat = Format::Erg;
-        } else if(format=="fortran_binary_data") {
-            mFormat = Format::Fortran;
-        } else {
-            close();
-            throw std::runtime_error("Unknown format "+format+".");
-        }
-    }
+    if(formatStr.data==nullptr)
+        throw std::runtime_error("Format not specified.");
+    if(equalsLower(formatStr, "erg", 3))
+        format = Format::Erg;
+    else if(equalsLower(formatStr, "fortran_binary_data", 19))
+        format = Format::Fortran;
+    else
+        throw std::runtime_error("Unknown format "+formatStr.str()+".");
 
     // Decode byte order
-    {
-        auto byteOrderStrIt = infoMap.find("File.ByteOrder");
-        if(byteOrderStrIt==infoMap.end())
-            throw std::runtime_error("Format not specified.");
-        std::string byteOrder = trim(byteOrderStrIt->second);
-        std::transform(byteOrder.begin(), byteOrder.end(), byteOrder.begin(), ::tolower);
-        if(byteOrder=="littleendian") {
-            mByteOrder = ByteOrder::LittelEndian;
-        } else if(byteOrder=="bigendian") {
-            mByteOrder = ByteOrder::BigEndian;
-        } else {
-            close();
-            throw std::runtime_error("Unknown byte order "+byteOrder+".");
+    if(byteOrderStr.data==nullptr)
+        throw std::runtime_error("Byte order not specified.");
+    if(equalsLower(byteOrderStr, "littleendian", 12))
+        byteOrder = ByteOrder::LittelEndian;
+    else if(equalsLower(byteOrderStr, "bigendian", 9))
+        byteOrder = ByteOrder::BigEndian;
+    else
+        throw std::runtime_error("Unknown byte order "+byteOrderStr.str()+".");
+}
+
+/*!
+ * \brief Check the header of an `ERG` file against the companion file.
+ * \param header The header read from the file.
+ * \param byteOrder Byte order from the companion file.
+ * \param filename Name of the file, for the error messages.
+ * \return The record size stored in the header.
+ * \throws If the header is not valid.
+ */
+static size_t checkErgHeader(const header_t& header, const ByteOrder byteOrder,
+                             const std::string& filename) noexcept(false)
+{
+    if(std::strncmp(reinterpret_cast<const char*>(header.identifier), "CM-ERG", sizeof("CM-ERG"))!=0)
+        throw std::runtime_error("Not an erg file: "+filename);
+
+    if(header.version!=1)
+        throw std::runtime_error("Unsupported version: " + std::to_string(header.version));
+
+    // Check endianess according to the companion file.
+    const ByteOrder headerByteOrder = header.byte_order==0 ? ByteOrder::LittelEndian : ByteOrder::BigEndian;
+    if(headerByteOrder!=byteOrder)
+        throw std::runtime_error("Unexpected endianess specified in .erg file.");
+
+    const size_t recordSize = byteOrder==ByteOrder::LittelEndian ? le2h16(header.record_size) : be2h16(header.record_size);
+    if(recordSize==0)
+        throw std::runtime_error("Unexpected record size specified in .erg file.");
+    return recordSize;
+}
+
+ProbeInfo probe(const std::string& filename) noexcept(false)
+{
+    const std::string infoFilename = companionFilename(filename);
+    if(infoFilename.empty())
+        throw std::runtime_error("Can't open "+filename+" companion file.");
+
+    ProbeInfo info;
+    readInfoFormat(InfoFile(infoFilename), infoFilename, true, info.format, info.byteOrder);
+
+    std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
+    if(file.is_open()==false)
+        throw std::runtime_error("Can't open "+filename+" file.");
+    file.seekg(0, std::ios_base::end);
+    const std::streamoff fileSize = file.tellg();
+    file.seekg(0, std::ios_base::beg);
+
+    if(info.format==Format::Erg) {
+        header_t header;
+        std::memset(&header, 0, sizeof(header_t));
+        file.read(reinterpret_cast<char*>(&header), sizeof(header_t));
+        info.recordSize = checkErgHeader(header, info.byteOrder, filename);
+        info.records = (static_cast<size_t>(fileSize) - sizeof(header_t)) / info.recordSize;
+    } else {
+        uint32_t rowSize = 0;
+        if(!file.read(reinterpret_cast<char*>(&rowSize), sizeof(uint32_t)))
+            throw std::runtime_error("Not a fortran binary data file: "+filename);
+        rowSize = info.byteOrder==ByteOrder::LittelEndian ? le2h32(rowSize) : be2h32(rowSize);
+        info.recordSize = rowSize + 2 * sizeof(uint32_t);
+        info.records = static_cast<size_t>(fileSize) / info.recordSize;
+    }
+    return info;
+}
+
+Reader::Reader() noexcept(true)
+    : mFd(-1), mThreads(1), mPrefetch(0), mAccess(Access::Normal), mDirectFd(-1),
+      mCache(std::make_shared<ColumnCache>()), mSidecar(Sidecar::Use), mColFd(-1), mTimeBlock(0), mZoneBlock(0),
+      mLazyOpen(false), mLoaded(true), mLoading(false)
+{
+    close();
+}
+
+Reader::Reader(const std::string& filename, const Backend backend)  noexcept(false)
+    : mFd(-1), mThreads(1), mPrefetch(0), mAccess(Access::Normal), mDirectFd(-1),
+      mCache(std::make_shared<ColumnCache>()), mSidecar(Sidecar::Use), mColFd(-1), mTimeBlock(0), mZoneBlock(0),
+      mLazyOpen(false), mLoaded(true), mLoading(false)
+{
+    open(filename, backend);
+}
+
+
+Reader::~Reader()
+{
+    close();
+}
+
+
+void Reader::open(const std::string& filename, const Backend backend)
+{
+    static_assert(sizeof(header_t) == HEADER_SIZE, "Header size must be 16 bytes");
+
+    // Clear data
+    close();
+
+    mFilename = filename;
+
+    // Format of the data from the companion file: the quantities are parsed
+    // from the same content by loadQuantities().
+    const std::string infoFilename = companionFilename(filename);
+    if(infoFilename.empty()) {
+        close();
+        throw std::runtime_error("Can't open "+filename+" companion file.");
+    }
+    try {
+        mInfo = std::make_shared<InfoFile>(infoFilename);
+        readInfoFormat(*mInfo, infoFilename, false, mFormat, mByteOrder);
+    } catch(std::runtime_error&) {
+        close();
+        throw;
+    }
+
+    mFile.open(filename, std::ios_base::in | std::ios_base::binary);
+    if(mFile.is_open()==false) {
+        close();
+        throw std::runtime_error("Can't open "+filename+" file.");
+    }
+
+#ifdef ERG_HAVE_PREAD
+    // Descriptor for positional reads, which can run concurrently
+    mFd = ::open(filename.c_str(), O_RDONLY);
+    if(mFd<0) {
+        close();
+        throw std::runtime_error("Can't open "+filename+" file.");
+    }
+#endif
+
+    if(mFormat==Format::Erg)
+        parseErgFormat();
+    else
+        parseFortranFormat();
+
+    mBackend = Backend::Stream;
+    mOpenBackend = backend;
+    if(backend!=Backend::Stream && mAccess!=Access::Direct && mapFile()==false && backend==Backend::Mmap) {
+        close();
+        throw std::runtime_error("Can't map "+filename+" file.");
+    }
+    applyAccess();
+
+    mLoaded = false;
+    mLoadError = nullptr;
+    if(mLazyOpen==false) {
+        try {
+            quantities();
+        } catch(std::runtime_error&) {
+            close();
+            throw;
+        }
+    }
+}
+
+const std::vector<Quantity>& Reader::quantities() const noexcept(false)
+{
+    if(mLoaded.load(std::memory_order_acquire)==false) {
+        // The sidecar and the indices opened by loadQuantities() read the
+        // quantities again from the same thread.
+        std::lock_guard<std::recursive_mutex> lock(mLoadMutex);
+        // A failed parsing is not retried until the next open()
+        if(mLoadError)
+            std::rethrow_exception(mLoadError);
+        if(mLoaded.load(std::memory_order_relaxed)==false && mLoading==false)
+            const_cast<Reader*>(this)->loadQuantities();
+    }
+    return mQuantities;
+}
+
+void Reader::loadQuantities() noexcept(false)
+{
+    mLoading = true;
+    try {
+        parseInfoFile();
+    } catch(...) {
+        mQuantities.clear();
+        mNameIndex.clear();
+        mLoading = false;
+        mLoadError = std::current_exception();
+        throw;
+    }
+
+    if(mSidecar!=Sidecar::Ignore && openSidecar()==false && mSidecar==Sidecar::Build) {
+        // The sidecar file is only an optimization: the reads work without it.
+        try {
+            buildSidecar();
+        } catch(std::runtime_error&) {
+        }
+    }
+    openTimeIndex();
+    openZoneMap();
+
+    mLoading = false;
+    mLoaded.store(true, std::memory_order_release);
+}
+
+
+size_t Reader::readAll(std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const
+{
+    const std::vector<Quantity>& qs = quantities();
+    if(values.size()!=sizes.size())
+        throw std::runtime_error("Wrong input size");
+
+    const size_t nds = numQuanities();
+    if(nds<values.size())
+        throw std::runtime_error("No data for all the datasets");
+
+    for(size_t i=0; i<nds; ++i) {
+        if(sizes[i] < quantitySize(i))
+            throw std::runtime_error("Not enought space for dataset "+qs[i].name);
+    }
+
+
+    std::vector<Column> columns(nds);
+    for(size_t ds=0; ds<nds; ++ds)
+        columns[ds] = rawColumn(ds, values[ds]);
+
+    return readColumns(columns, 0, mRecordsCount, 1);
+}
+
+size_t Reader::read(const size_t qindex, uint8_t* dst, const size_t size) const
+{
+    return read(qindex, 0, mRecordsCount, dst, size);
+    /*
+    if(qindex>=quantities().size())
+        throw std::runtime_error("Index "+std::to_string(qindex)+" is out of bounds.");
+
+    const Quantity& qt = quantities()[qindex];
+
+    if((qt.size*mRecordsCount)>size)
+        throw std::runtime_error("Not enough data allocated");
+
+    memset(outData, 0, size);
+    const size_t inOffset = qt.offset;
+
+    mFile.seekg(initialSkipBytes(), std::ios_base::beg);
+
+    std::vector<uint8_t> row(mRecordSize, 0);
+    uint8_t* rowData = row.data();
+    size_t readRows = 0;
+    for(size_t rid=0; rid<mRecordsCount; ++rid)
+    {
+        mFile.read(reinterpret_cast<char*>(rowData), mRecordSize);
+        if(mFile.eof())
+            break;
+
+        readRows += 1;
+
+        const size_t outOffset = rid * qt.size;
+        std::memcpy(outData + outOffset,  rowData + inOffset, qt.size);
+    }
+
+    if(mByteOrder==ByteOrder::LittelEndian)
+        arrayLe2Host(outData, qt.size, readRows);
+    else
+        arrayBe2Host(outData, qt.size, readRows);
+
+    return readRows;
+    */
+}
+
+size_t Reader::read(const size_t qindex, const size_t from, const size_t count, uint8_t* dst, const size_t size) const
+{
+    return read(qindex, from, count, 1, dst, size);
+}
+
+size_t Reader::read(const size_t qindex, const size_t from, const size_t count, const size_t step,
+                    uint8_t* dst, const size_t size) const
+{
+    std::vector<size_t> qindices(1, qindex);
+    std::vector<uint8_t*> values(1, dst);
+    std::vector<size_t> sizes(1, size);
+    return read(qindices, from, count, step, values, sizes);
+}
+
+size_t Reader::read(const std::vector<size_t>& qindices, const size_t from, const size_t count,
+                    std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const
+{
+    return read(qindices, from, count, 1, values, sizes);
+}
+
+size_t Reader::read(const std::vector<size_t>& qindices, const size_t from, const size_t count, const size_t step,
+                    std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const
+{
+    if(values.size()!=qindices.size() || sizes.size()!=qindices.size())
+        throw std::runtime_error("Wrong input size");
+
+    if(step==0)
+        throw std::runtime_error("The step must be greater than zero.");
+
+    const size_t rows = rangeSize(from, count, step);
+    for(size_t i=0; i<qindices.size(); ++i)
+    {
+        if(qindices[i]>=quantities().size())
+            throw std::runtime_error("Index "+std::to_string(qindices[i])+" is out of bounds.");
+
+        const size_t expectedSize = quantities()[qindices[i]].size * rows;
+        if(expectedSize>sizes[i])
+            throw std::runtime_error("Not enough data allocated for dataset "+quantities()[qindices[i]].name+\
+                                     ": "+std::to_string(sizes[i])+" instead of "+\
+                                     std::to_string(expectedSize)+" bytes.");
+    }
+
+    std::vector<Column> columns(qindices.size());
+    for(size_t i=0; i<qindices.size(); ++i)
+        columns[i] = rawColumn(qindices[i], values[i]);
+
+    return readColumns(columns, from, rows, step);
+}
+
+size_t Reader::read(const std::vector<std::string>& qnames, const size_t from, const size_t count,
+                    std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const
+{
+    std::vector<size_t> qindices;
+    qindices.reserve(qnames.size());
+    for(const std::string& qname: qnames)
+        qindices.push_back(index(qname));
+
+    return read(qindices, from, count, 1, values, sizes);
+}
+
+size_t Reader::rangeSize(const size_t from, const size_t count, const size_t step) const noexcept(true)
+{
+    if(from>=mRecordsCount || step==0)
+        return 0;
+    return std::min(count, (mRecordsCount - from + step - 1) / step);
+}
+
+Chunks Reader::chunks(const size_t chunkRows, const std::vector<size_t>& qindices) const noexcept(false)
+{
+    if(!qindices.empty())
+        return Chunks(*this, chunkRows, qindices);
+
+    std::vector<size_t> all(quantities().size());
+    for(size_t i=0; i<all.size(); ++i)
+        all[i] = i;
+    return Chunks(*this, chunkRows, all);
+}
+
+Chunks Reader::chunks(const size_t chunkRows, const std::vector<std::string>& qnames) const noexcept(false)
+{
+    std::vector<size_t> qindices;
+    qindices.reserve(qnames.size());
+    for(const std::string& qname: qnames)
+        qindices.push_back(index(qname));
+
+    return Chunks(*this, chunkRows, qindices);
+}
+
+void Reader::load() const noexcept(false)
+{
+    quantities();
+}
+
+bool Reader::quantitiesLoaded() const noexcept(true)
+{
+    if(mLoaded.load(std::memory_order_acquire))
+        return true;
+
+    {
+        // A stored error is not thrown again just to be caught here
+        std::lock_guard<std::recursive_mutex> lock(mLoadMutex);
+        if(mLoadError)
+            return false;
+    }
+
+    try {
+        quantities();
+        return true;
+    } catch(std::exception&) {
+        return false;
+    }
+}
+
+size_t Reader::numQuanities() const noexcept(true)
+{
+    // A file whose quantities can't be parsed by the lazy open has none:
+    // the error is thrown again by load() and by the other accessors
+    return quantitiesLoaded() ? mQuantities.size() : 0;
+}
+
+size_t Reader::index(const std::string &qname) const noexcept(false)
+{
+    // Throw the parsing error of the lazy open, if any
+    const std::vector<Quantity>& qs = quantities();
+    const size_t qindex = find(qname);
+    if(qindex==qs.size())
+        throw std::runtime_error("The quantity "+qname+" does not exists.");
+    return qindex;
+}
+
+size_t Reader::find(const std::string& qname) const noexcept(true)
+{
+    if(quantitiesLoaded()==false)
+        return 0;
+
+    const size_t count = mQuantities.size();
+    if(mNameIndex.empty())
+        return count;
+
+    // Linear probing in a table at most half full
+    const size_t mask = mNameIndex.size() - 1;
+    for(size_t slot=TokenHash()(Token{qname.data(), qname.size()}) & mask; mNameIndex[slot]!=0; slot=(slot + 1) & mask)
+    {
+        const size_t qindex = mNameIndex[slot] - 1;
+        if(mQuantities[qindex].name==qname)
+            return qindex;
+    }
+    return count;
+}
+
+bool Reader::has(const std::string &qname) const noexcept(true)
+{
+    // find() parses the quantities, if needed
+    const size_t qindex = find(qname);
+    return qindex<mQuantities.size();
+}
+
+/*!
+ * \brief Match a name with a wildcard pattern.
+ * \param pattern Pattern where `*` matches any sequence of characters and `?` any character.
+ * \param name The name.
+ * \return `true` if the whole name matches.
+ */
+static bool wildcardMatch(const std::string& pattern, const std::string& name) noexcept(true)
+{
+    size_t p = 0;
+    size_t n = 0;
+    // Position of the last `*` and of the name where it started to match
+    size_t star = std::string::npos;
+    size_t starName = 0;
+    while(n<name.size())
+    {
+        if(p<pattern.size() && (pattern[p]=='?' || pattern[p]==name[n])) {
+            ++p;
+            ++n;
+        } else if(p<pattern.size() && pattern[p]=='*') {
+            star = p++;
+            starName = n;
+        } else if(star!=std::string::npos) {
+            // Let the last `*` match one more character
+            p = star + 1;
+            n = ++starName;
+        } else {
+            return false;
+        }
+    }
+    while(p<pattern.size() && pattern[p]=='*')
+        ++p;
+    return p==pattern.size();
+}
+
+std::vector<size_t> Reader::select(const std::string& pattern) const noexcept(true)
+{
+    std::vector<size_t> qindices;
+    if(pattern.find_first_of("*?")==std::string::npos) {
+        const size_t qindex = find(pattern);
+        if(qindex<numQuanities())
+            qindices.push_back(qindex);
+        return qindices;
+    }
+
+    // The quantities are loaded by numQuanities()
+    const size_t count = numQuanities();
+    for(size_t i=0; i<count; ++i)
+    {
+        if(wildcardMatch(pattern, mQuantities[i].name))
+            qindices.push_back(i);
+    }
+    return qindices;
+}
+
+std::vector<size_t> Reader::select(const std::regex& pattern) const noexcept(false)
+{
+    const std::vector<Quantity>& qs = quantities();
+    std::vector<size_t> qindices;
+    for(size_t i=0; i<qs.size(); ++i)
+    {
+        if(std::regex_match(qs[i].name, pattern))
+            qindices.push_back(i);
+    }
+    return qindices;
+}
+
+void Reader::buildNameIndex() noexcept(false)
+{
+    size_t slots = 1;
+    while(slots<2 * mQuantities.size())
+        slots *= 2;
+    mNameIndex.assign(slots, 0);
+
+    const size_t mask = slots - 1;
+    for(size_t i=0; i<mQuantities.size(); ++i)
+    {
+        const std::string& name = mQuantities[i].name;
+        size_t slot = TokenHash()(Token{name.data(), name.size()}) & mask;
+        while(mNameIndex[slot]!=0 && mQuantities[mNameIndex[slot] - 1].name!=name)
+            slot = (slot + 1) & mask;
+        // The first quantity wins if a name is repeated
+        if(mNameIndex[slot]==0)
+            mNameIndex[slot] = static_cast<uint32_t>(i + 1);
+    }
+}
+
+void Reader::close() noexcept(true)
+{
+    if(mFile.is_open())
+        mFile.close();
+#ifdef ERG_HAVE_PREAD
+    if(mFd>=0)
+        ::close(mFd);
+#endif
+    mFd = -1;
+#ifdef ERG_HAVE_DIRECT
+    if(mDirectFd>=0)
+        ::close(mDirectFd);
+#endif
+    mDirectFd = -1;
+    mMap.reset();
+    mCache->clear();
+    closeSidecar();
+    mTimeBlock = 0;
+    mTimeMin.clear();
+    mTimeMax.clear();
+    mZoneBlock = 0;
+    mZoneMin.clear();
+    mZoneMax.clear();
+    mBackend = Backend::Stream;
+    mOpenBackend = Backend::Auto;
+
+    mFilename.clear();
+    mFileSize = 0;
+    mRecordsCount = 0;
+    mFollowFrom = 0;
+    mRecordSize = 0;
+    mFormat = Format::Erg;
+    mByteOrder = ByteOrder::LittelEndian;
+    mQuantities.clear();
+    mNameIndex.clear();
+    mInfo.reset();
+    // Nothing to load until the next open()
+    mLoading = false;
+    mLoaded = true;
+    mLoadError = nullptr;
+}
+
+size_t Reader::refresh() noexcept(false)
+{
+    if(mRecordSize==0 || (mFd<0 && mFile.is_open()==false))
+        return 0;
+
+    const size_t fileSize = currentFileSize();
+    const size_t records = fileSize>initialSkipBytes() ? (fileSize - initialSkipBytes()) / mRecordSize : 0;
+    const size_t previous = mRecordsCount;
+    mFileSize = fileSize;
+    mRecordsCount = records;
+    // The cached columns are complete only for the previous record count
+    if(records!=previous) {
+        mCache->clear();
+        closeSidecar();
+        // Else they are opened with the quantities by the lazy open
+        if(mLoaded.load(std::memory_order_acquire)) {
+            openTimeIndex();
+            openZoneMap();
+        }
+    }
+    // The file has been truncated, e.g. by a new simulation run
+    mFollowFrom = std::min(mFollowFrom, records);
+
+    // The mapping must cover all the records
+    if(mMap && mMap->size()<initialSkipBytes()+records*mRecordSize) {
+        mMap.reset();
+        mBackend = Backend::Stream;
+    }
+    if(!mMap && mOpenBackend!=Backend::Stream && mAccess!=Access::Direct) {
+        if(mapFile())
+            applyAccess();
+        else if(mOpenBackend==Backend::Mmap)
+            throw std::runtime_error("Can't map "+mFilename+" file.");
+    }
+
+    return records>previous ? records - previous : 0;
+}
+
+bool Reader::waitForGrowth(const size_t timeoutMs) const noexcept(true)
+{
+    if(mRecordSize==0)
+        return false;
+
+    const size_t expectedSize = initialSkipBytes() + (mRecordsCount + 1) * mRecordSize;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+#ifdef ERG_HAVE_INOTIFY
+    int notifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(notifyFd>=0 && ::inotify_add_watch(notifyFd, mFilename.c_str(), IN_MODIFY | IN_CLOSE_WRITE)<0) {
+        ::close(notifyFd);
+        notifyFd = -1;
+    }
+#endif
+
+    bool grown = currentFileSize()>=expectedSize;
+    while(!grown)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if(now>=deadline)
+            break;
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+
+#ifdef ERG_HAVE_INOTIFY
+        if(notifyFd>=0) {
+            struct pollfd pfd;
+            pfd.fd = notifyFd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if(::poll(&pfd, 1, static_cast<int>(std::min<long long>(remaining, 1000)))>0) {
+                // Drain the events, only the file size matters
+                char events[4096];
+                while(::read(notifyFd, events, sizeof(events))>0) {}
+            }
+        } else
+#endif
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<long long>(remaining, 10)));
+        }
+
+        grown = currentFileSize()>=expectedSize;
+    }
+
+#ifdef ERG_HAVE_INOTIFY
+    if(notifyFd>=0)
+        ::close(notifyFd);
+#endif
+    return grown;
+}
+
+size_t Reader::readNew(const std::vector<size_t>& qindices, std::vector<uint8_t*>& values,
+                       const std::vector<size_t>& sizes) noexcept(false)
+{
+    const size_t rows = read(qindices, mFollowFrom, newRecords(), 1, values, sizes);
+    mFollowFrom += rows;
+    return rows;
+}
+
+size_t Reader::currentFileSize() const noexcept(true)
+{
+#ifdef ERG_HAVE_PREAD
+    struct stat st;
+    if(mFd>=0 && ::fstat(mFd, &st)==0)
+        return st.st_size;
+#endif
+    std::lock_guard<std::mutex> lock(mFileMutex);
+    mFile.clear();
+    mFile.seekg(0, std::ios_base::end);
+    const std::streamoff size = mFile.tellg();
+    return size>0 ? static_cast<size_t>(size) : 0;
+}
+
+void Reader::parseInfoFile()
+{
+    // The companion file has been loaded by open(): it isn't needed after the parsing
+    const std::shared_ptr<const InfoFile> info = std::move(mInfo);
+    if(!info)
+        throw std::runtime_error("Can't open "+mFilename+" companion file.");
+    const char* begin = info->begin();
+    const char* end = info->end();
+
+    // Name and type of the quantity "File.At.<index>"
+    struct Column
+    {
+        Token name;
+        Token type;
+    };
+    struct Field
+    {
+        size_t index;
+        bool isName;
+        Token value;
+    };
+    std::vector<Field> fields;
+    std::unordered_map<Token, Token, TokenHash> units;
+
+    // Single pass over the "key = value # comment" lines: a later definition
+    // of a key replaces the previous one, the other keys are skipped.
+    for(const char* line=begin; line<end; )
+    {
+        const char* lineEnd = reinterpret_cast<const char*>(std::memchr(line, '\n', end - line));
+        if(lineEnd==nullptr)
+            lineEnd = end;
+        const char* next = lineEnd + 1;
+
+        const char* eq = reinterpret_cast<const char*>(std::memchr(line, '=', lineEnd - line));
+        const char* comment = reinterpret_cast<const char*>(std::memchr(line, '#', lineEnd - line));
+        if(eq==nullptr || (comment!=nullptr && comment<eq)) {
+            line = next;
+            continue;
+        }
+
+        const Token key = trimToken(line, eq);
+        const Token value = trimToken(eq + 1, comment!=nullptr ? comment : lineEnd);
+        line = next;
+
+        if(key.startsWith("File.At.", 8)) {
+            // "File.At.<index>.Name" or "File.At.<index>.Type", with a decimal index
+            // The index can't exceed the size of the file: larger ones, which
+            // could also overflow, are skipped.
+            const size_t maxIndex = end - begin;
+            size_t index = 0;
+            size_t i = 8;
+            if(i>=key.size || key.data[i]<'1' || key.data[i]>'9')
+                continue;
+            while(i<key.size && key.data[i]>='0' && key.data[i]<='9' && index<=maxIndex)
+                index = index * 10 + (key.data[i++] - '0');
+            if(index>maxIndex)
+                continue;
+
+            const Token field{key.data + i, key.size - i};
+            const bool isName = field.equals(".Name", 5);
+            if(!isName && !field.equals(".Type", 5))
+                continue;
+
+            fields.push_back(Field{index, isName, value});
+        } else if(key.startsWith("Quantity.", 9) && key.endsWith(".Unit", 5) && key.size>14) {
+            units[Token{key.data + 9, key.size - 14}] = value;
+        }
+    }
+
+    // The list of quantities can't be longer than the number of keys: the
+    // indices above it are after a missing quantity and are ignored.
+    std::vector<Column> columns;
+    for(const Field& f: fields)
+    {
+        if(f.index>fields.size())
+            continue;
+        if(f.index>columns.size())
+            columns.resize(f.index, Column{Token{nullptr, 0}, Token{nullptr, 0}});
+        if(f.isName)
+            columns[f.index - 1].name = f.value;
+        else
+            columns[f.index - 1].type = f.value;
+    }
+
+    // The quantities are numbered from 1. Both name and type must be
+    // available; if not, the list ends and the next quantities are ignored.
+    mQuantities.reserve(columns.size());
+    for(const Column& column: columns)
+    {
+        if(column.type.data==nullptr)
+            break;
+
+        Quantity q;
+        q.typeStr = column.type.str();
+        q.type = dataType(q.typeStr);
+        if(q.type==Type::Void)
+        {
+            // Padding bytes: decode size and skipping...
+            q.size = strtol(q.typeStr.c_str(), nullptr, 10);
+            q.name = "";
+        }
+        else
+        {
+            if(column.name.data==nullptr)
+                break;
+
+            q.name = column.name.str();
+
+            // Decode unit if present
+            auto unitIt = units.find(column.name);
+            if(unitIt!=units.end())
+                q.unit = unitIt->second.str();
+
+            q.size = dataSize(q.type);
+        }
+
+        mQuantities.push_back(q);
+    }
+
+    // Check record size
+    const size_t numAllQuanties = mQuantities.size();
+    size_t recordBytes = 0;
+    for(size_t i=0; i<numAllQuanties; ++i)
+    {
+        mQuantities[i].offset = recordBytes;
+        recordBytes += mQuantities[i].size;
+    }
+
+    if(mFormat==Format::Erg) {
+        // The header of the .erg file has been checked by open()
+        if(recordBytes!=mRecordSize)
+            throw std::runtime_error("Unexpected record size specified in .erg file.");
+    } else {
+        // Update quantities offset to ignore the record size attribute
+        // in each row.
+        for(Quantity& q: mQuantities)
+            q.offset += sizeof(uint32_t);
+    }
+
+    // Remove the padding quantities if present
+    auto toRemoveIt = std::remove_if(mQuantities.begin(), mQuantities.end(),
+                                     [](Quantity& x){return x.type==Type::Void;});
+    mQuantities.erase(toRemoveIt, mQuantities.end());
+
+    buildNameIndex();
+}
+
+void Reader::parseFortranFormat()
+{
+    // Read the record size
+    uint32_t rowSize = 0;
+    mFile.read(reinterpret_cast<char*>(&rowSize), sizeof(uint32_t));
+    if(mByteOrder==ByteOrder::LittelEndian)
+        rowSize = le2h32(rowSize);
+    else
+        rowSize = be2h32(rowSize);
+
+    mRecordSize = rowSize + 2 * sizeof(uint32_t);
+
+    // Evaluate number of records
+    mFile.seekg(0, std::ios_base::end);
+    mFileSize = mFile.tellg();
+    mRecordsCount = mFileSize/mRecordSize;
+}
+
+void Reader::parseErgFormat()
+{
+    // Read the header of the file and check for bad format
+    header_t header;
+    std::memset(&header, 0, sizeof(header_t));
+    mFile.seekg(0, std::ios_base::beg);
+    mFile.read(reinterpret_cast<char*>(&header), sizeof(header_t));
+
+    // The record size is checked against the quantities by parseInfoFile()
+    try {
+        mRecordSize = checkErgHeader(header, mByteOrder, mFilename);
+    } catch(std::runtime_error&) {
+        close();
+        throw;
+    }
+
+    // Evaluate number of records
+    mFile.seekg(0, std::ios_base::end);
+    mFileSize = mFile.tellg();
+    mRecordsCount = mFileSize>sizeof(header_t) ? (mFileSize-sizeof(header_t))/mRecordSize : 0;
+}
+
+size_t Reader::loadRecords(const size_t from, const size_t rows, const size_t step, uint8_t* buffer,
+                           const uint8_t*& records, size_t& stride) const
+{
+    const size_t available = rangeSize(from, rows, step);
+    if(available==0)
+        return 0;
+
+    const uint8_t* mapped = mappedRecords();
+    if(mapped!=nullptr) {
+        records = mapped + from * mRecordSize;
+        stride = step * mRecordSize;
+        return available;
+    }
+
+    records = buffer;
+    const size_t offset = initialSkipBytes() + from * mRecordSize;
+    if(step * mRecordSize > SPARSE_GAP) {
+        // Sparse records: read only the selected ones
+        stride = mRecordSize;
+        for(size_t i=0; i<available; ++i)
+        {
+            if(readAt(offset + i * step * mRecordSize, buffer + i * mRecordSize, mRecordSize)<mRecordSize)
+                return i;
+        }
+        return available;
+    }
+
+    // Dense records: read the whole span and skip the records in between.
+    // The direct reads load the records at the alignment of their offset,
+    // where the whole pages are read in place.
+    if(mDirectFd>=0) {
+        buffer += offset % DIRECT_ALIGNMENT;
+        records = buffer;
+    }
+    stride = step * mRecordSize;
+    const size_t bytes = readAt(offset, buffer, ((available - 1) * step + 1) * mRecordSize);
+    if(bytes<mRecordSize)
+        return 0;
+    return (bytes / mRecordSize - 1) / step + 1;
+}
+
+size_t Reader::readAt(const size_t offset, uint8_t* buffer, const size_t size) const
+{
+    if(mDirectFd>=0)
+        return readDirect(offset, buffer, size);
+
+#ifdef ERG_HAVE_PREAD
+    const size_t done = preadFully(mFd, buffer, size, offset);
+    if(mAccess==Access::Once)
+        dropCache(offset, done);
+    return done;
+#else
+    std::lock_guard<std::mutex> lock(mFileMutex);
+    mFile.clear();
+    mFile.seekg(offset, std::ios_base::beg);
+    mFile.read(reinterpret_cast<char*>(buffer), size);
+    return static_cast<size_t>(mFile.gcount());
+#endif
+}
+
+size_t Reader::readColumns(const std::vector<Column>& columns, const size_t from, const size_t count,
+                           const size_t step) const
+{
+    if(mRecordSize==0)
+        return 0;
+
+    const size_t rows = rangeSize(from, count, step);
+    const size_t budget = mCache->budget();
+    if((budget==0 && mColFd<0) || rows==0)
+        return readParallel(columns, from, count, step);
+
+    // Serve the columns from the cache. A read of most of the file decodes the
+    // missing columns that fit the cache whole and adds them to it; the
+    // smaller reads of the missing columns read only their range.
+    const bool fill = ((rows - 1) * step + 1) * 100 >= mRecordsCount * CACHE_FILL_PERCENT;
+    std::vector< std::shared_ptr<const std::vector<uint8_t> > > cached(columns.size());
+    std::vector<Column> missing;
+    std::vector<size_t> missingAt;
+    std::vector< std::shared_ptr<std::vector<uint8_t> > > loaded;
+    for(size_t i=0; i<columns.size() && budget>0; ++i)
+    {
+        cached[i] = mCache->find(columns[i].qindex);
+        const size_t bytes = mQuantities[columns[i].qindex].size * mRecordsCount;
+        if(!cached[i] && fill && bytes<=budget) {
+            loaded.push_back(std::make_shared<std::vector<uint8_t> >(bytes));
+            missing.push_back(rawColumn(columns[i].qindex, loaded.back()->data()));
+            missingAt.push_back(i);
+        }
+    }
+    if(!missing.empty() && loadWholeColumns(missing)) {
+        for(size_t k=0; k<missing.size(); ++k)
+        {
+            cached[missingAt[k]] = loaded[k];
+            mCache->insert(missing[k].qindex, loaded[k]);
+        }
+    }
+
+    // The conversion kernels of the records expect the file byte order, so
+    // the typed columns are never read from the sidecar file.
+    std::vector<Column> pending;
+    size_t readRows = rows;
+    for(size_t i=0; i<columns.size(); ++i)
+    {
+        const Column& c = columns[i];
+        if(cached[i]) {
+            copyCached(c, *cached[i], from, rows, step);
+        } else if(c.convert==nullptr && mColFd>=0) {
+            readRows = std::min(readRows, readSidecar(c, from, rows, step));
+        } else {
+            pending.push_back(c);
+        }
+    }
+    if(pending.empty())
+        return readRows;
+
+    return std::min(readRows, readParallel(pending, from, count, step));
+}
+
+bool Reader::loadWholeColumns(const std::vector<Column>& columns) const
+{
+    if(mColFd>=0) {
+        for(const Column& c: columns)
+        {
+            if(readSidecar(c, 0, mRecordsCount, 1)<mRecordsCount)
+                return false;
+        }
+        return true;
+    }
+    return readParallel(columns, 0, mRecordsCount, 1)==mRecordsCount;
+}
+
+void Reader::copyCached(const Column& column, const std::vector<uint8_t>& cached, const size_t from,
+                        const size_t rows, const size_t step) const noexcept(true)
+{
+    const size_t size = mQuantities[column.qindex].size;
+    const uint8_t* src = cached.data() + from * size;
+    if(column.convert!=nullptr) {
+        column.convertHost(src, step * size, rows, column.dst);
+    } else if(step==1) {
+        std::memcpy(column.dst, src, rows * size);
+    } else {
+        for(size_t i=0; i<rows; ++i)
+            std::memcpy(column.dst + i * size, src + i * step * size, size);
+    }
+}
+
+size_t Reader::readParallel(const std::vector<Column>& columns, const size_t from, const size_t count,
+                            const size_t step) const
+{
+
+    const size_t rows = rangeSize(from, count, step);
+    const size_t blockRecords = std::max<size_t>(1, BLOCK_SIZE / mRecordSize);
+
+    // Each worker gets at least a block of records
+    const size_t workers = std::max<size_t>(1, std::min(threads(), rows / blockRecords));
+    if(workers==1)
+        return readBlocks(columns, from, rows, step);
+
+    // Split the records in contiguous chunks: each worker writes a disjoint
+    // slice of the destination arrays.
+    const size_t chunkRecords = (rows + workers - 1) / workers;
+    std::vector<size_t> readRows(workers, 0);
+    std::vector<std::exception_ptr> errors(workers);
+    std::vector< std::vector<Column> > chunkColumns(workers, columns);
+
+    auto worker = [&](const size_t w)
+    {
+        try {
+            const size_t start = w * chunkRecords;
+            for(Column& c: chunkColumns[w])
+                c.dst += start * c.elementSize;
+            readRows[w] = readBlocks(chunkColumns[w], from + start * step, std::min(chunkRecords, rows - start), step);
+        } catch(...) {
+            errors[w] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    try {
+        for(size_t w=1; w<workers; ++w)
+            pool.push_back(std::thread(worker, w));
+    } catch(...) {
+        // Joinable threads can't be destroyed: wait for the ones already started
+        for(std::thread& t: pool)
+            t.join();
+        throw;
+    }
+    worker(0);
+    for(std::thread& t: pool)
+        t.join();
+
+    for(std::exception_ptr& e: errors) {
+        if(e)
+            std::rethrow_exception(e);
+    }
+
+    // Count only the records read without gaps from the first one
+    size_t total = 0;
+    for(size_t w=0; w<workers; ++w)
+    {
+        total += readRows[w];
+        if(readRows[w]<std::min(chunkRecords, rows - w * chunkRecords))
+            break;
+    }
+    return total;
+}
+
+size_t Reader::readBlocks(const std::vector<Column>& columns, const size_t from, const size_t count,
+                          const size_t step) const
+{
+    const size_t blockRecords = std::max<size_t>(1, BLOCK_SIZE / mRecordSize);
+    if(mPrefetch>0 && mappedRecords()==nullptr && count>blockRecords)
+        return readPipelined(columns, from, count, step);
+
+    AlignedBuffer block(mappedRecords()==nullptr ? blockRecords * mRecordSize + DIRECT_ALIGNMENT : 0,
+                        DIRECT_ALIGNMENT);
+
+    // Records selected by each load: a dense load reads the records in
+    // between as well and must fit in the block.
+    const size_t loadRows = step * mRecordSize > SPARSE_GAP ? blockRecords : std::max<size_t>(1, blockRecords / step);
+
+    size_t readRows = 0;
+    while(readRows<count)
+    {
+        const uint8_t* records = nullptr;
+        size_t stride = mRecordSize;
+        const size_t rows = loadRecords(from + readRows * step, std::min(loadRows, count - readRows), step,
+                                        block.data(), records, stride);
+        if(rows==0)
+            break;
+
+        // Let the kernel read the next block while this one is transposed
+        if(mPrefetch>0 && mMap && rows<count - readRows)
+            mMap->willNeed(initialSkipBytes() + (from + (readRows + rows) * step) * mRecordSize,
+                           mPrefetch * loadRows * step * mRecordSize);
+
+        decodeBlock(columns, records, stride, rows, readRows);
+
+        if(mAccess==Access::Once && mMap)
+            dropCache(initialSkipBytes() + (from + readRows * step) * mRecordSize, rows * stride);
+
+        readRows += rows;
+        if(rows<std::min(loadRows, count - (readRows - rows)))
+            break;
+    }
+
+    return readRows;
+}
+
+size_t Reader::readPipelined(const std::vector<Column>& columns, const size_t from, const size_t count,
+                             const size_t step) const
+{
+    const size_t blockRecords = std::max<size_t>(1, BLOCK_SIZE / mRecordSize);
+    const size_t loadRows = step * mRecordSize > SPARSE_GAP ? blockRecords : std::max<size_t>(1, blockRecords / step);
+
+    // A block loaded by the I/O thread. The end of the stream has no buffer.
+    struct Load
+    {
+        size_t buffer;
+        size_t rows;
+        const uint8_t* records;
+        size_t stride;
+    };
+    const size_t endOfStream = static_cast<size_t>(-1);
+
+    std::vector< std::unique_ptr<AlignedBuffer> > buffers;
+    SpscQueue<size_t> freeBuffers(mPrefetch);
+    for(size_t i=0; i<mPrefetch; ++i)
+    {
+        buffers.push_back(std::unique_ptr<AlignedBuffer>(
+            new AlignedBuffer(blockRecords * mRecordSize + DIRECT_ALIGNMENT, DIRECT_ALIGNMENT)));
+        freeBuffers.push(i);
+    }
+    // One more slot for the end of the stream
+    SpscQueue<Load> loaded(mPrefetch + 1);
+    std::exception_ptr error;
+
+    std::thread io([&]() {
+        size_t queued = 0;
+        try {
+            while(queued<count)
+            {
+                size_t buffer = 0;
+                for(size_t spins=0; !freeBuffers.pop(buffer); ++spins)
+                    waitQueue(spins);
+
+                const size_t requested = std::min(loadRows, count - queued);
+                Load load = {buffer, 0, nullptr, mRecordSize};
+                load.rows = loadRecords(from + queued * step, requested, step, buffers[buffer]->data(),
+                                        load.records, load.stride);
+                if(load.rows==0)
+                    break;
+                while(!loaded.push(load))
+                    std::this_thread::yield();
+                queued += load.rows;
+                if(load.rows<requested)
+                    break;
+            }
+        } catch(...) {
+            error = std::current_exception();
+        }
+
+        const Load end = {endOfStream, 0, nullptr, 0};
+        while(!loaded.push(end))
+            std::this_thread::yield();
+    });
+
+    size_t readRows = 0;
+    while(true)
+    {
+        Load load;
+        for(size_t spins=0; !loaded.pop(load); ++spins)
+            waitQueue(spins);
+        if(load.buffer==endOfStream)
+            break;
+
+        decodeBlock(columns, load.records, load.stride, load.rows, readRows);
+        readRows += load.rows;
+        freeBuffers.push(load.buffer);
+    }
+
+    io.join();
+    if(error)
+        std::rethrow_exception(error);
+    return readRows;
+}
+
+void Reader::decodeBlock(const std::vector<Column>& columns, const uint8_t* records, const size_t stride,
+                         const size_t rows, const size_t offset) const
+{
+    // Tiled transposition: extract all the quantities from a group of
+    // records before moving to the next one.
+    for(size_t tile=0; tile<rows; tile+=TILE_RECORDS)
+    {
+        const size_t tileRows = std::min<size_t>(TILE_RECORDS, rows - tile);
+        const uint8_t* tileRecords = records + tile * stride;
+        for(const Column& c: columns)
+        {
+            // Loaded by the caller: the workers must not wait for the lazy open
+            const Quantity& q = mQuantities[c.qindex];
+            uint8_t* dst = c.dst + (offset + tile) * c.elementSize;
+            if(c.convert!=nullptr)
+                c.convert(tileRecords + q.offset, stride, tileRows, dst);
+            else
+                transposeQuantity(tileRecords, stride, tileRows, q, dst);
+        }
+    }
+
+    // Correct endianess of the raw columns while the block is still in cache.
+    // The conversion kernels swap the bytes by themselves.
+    for(const Column& c: columns)
+    {
+        if(c.convert!=nullptr)
+            continue;
+        uint8_t* outData = c.dst + offset * c.elementSize;
+        if(mByteOrder==ByteOrder::LittelEndian)
+            arrayLe2Host(outData, c.elementSize, rows);
+        else
+            arrayBe2Host(outData, c.elementSize, rows);
+    }
+}
+
+Reader::Column Reader::rawColumn(const size_t qindex, uint8_t* dst) const noexcept(true)
+{
+    Column c;
+    c.qindex = qindex;
+    c.elementSize = mQuantities[qindex].size;
+    c.convert = nullptr;
+    c.convertHost = nullptr;
+    c.dst = dst;
+    return c;
+}
+
+template<typename T>
+Reader::Column Reader::typedColumn(const size_t qindex, T* dst) const noexcept(false)
+{
+    const bool swap = (mByteOrder==ByteOrder::BigEndian) != isBigEndian();
+
+    Column c;
+    c.qindex = qindex;
+    c.elementSize = sizeof(T);
+    c.convert = swap ? convertKernel<T, true>(mQuantities[qindex].type) : convertKernel<T, false>(mQuantities[qindex].type);
+    c.convertHost = convertKernel<T, false>(mQuantities[qindex].type);
+    c.dst = reinterpret_cast<uint8_t*>(dst);
+    return c;
+}
+
+template<typename T>
+size_t Reader::read(const size_t qindex, const size_t from, const size_t count, T* dst) const
+{
+    return read<T>(qindex, from, count, 1, dst);
+}
+
+template<typename T>
+size_t Reader::read(const size_t qindex, const size_t from, const size_t count, const size_t step, T* dst) const
+{
+    std::vector<size_t> qindices(1, qindex);
+    std::vector<T*> values(1, dst);
+    return read<T>(qindices, from, count, step, values);
+}
+
+template<typename T>
+size_t Reader::read(const std::vector<size_t>& qindices, const size_t from, const size_t count, const size_t step,
+                    std::vector<T*>& values) const
+{
+    if(values.size()!=qindices.size())
+        throw std::runtime_error("Wrong input size");
+
+    if(step==0)
+        throw std::runtime_error("The step must be greater than zero.");
+
+    std::vector<Column> columns(qindices.size());
+    for(size_t i=0; i<qindices.size(); ++i)
+    {
+        if(qindices[i]>=quantities().size())
+            throw std::runtime_error("Index "+std::to_string(qindices[i])+" is out of bounds.");
+        columns[i] = typedColumn<T>(qindices[i], values[i]);
+    }
+
+    return readColumns(columns, from, rangeSize(from, count, step), step);
+}
+
+template<typename T>
+size_t Reader::readAll(std::vector<T*>& values) const
+{
+    if(values.size()!=numQuanities())
+        throw std::runtime_error("Wrong input size");
+
+    std::vector<size_t> qindices(values.size());
+    for(size_t ds=0; ds<qindices.size(); ++ds)
+        qindices[ds] = ds;
+
+    return read<T>(qindices, 0, mRecordsCount, 1, values);
+}
+
+// Typed reads are available for all the ERG datatypes.
+#define ERG_INSTANTIATE_TYPED_READ(T) \
+    template size_t Reader::read<T>(const size_t, const size_t, const size_t, T*) const; \
+    template size_t Reader::read<T>(const size_t, const size_t, const size_t, const size_t, T*) const; \
+    template size_t Reader::read<T>(const std::vector<size_t>&, const size_t, const size_t, const size_t, \
+                                    std::vector<T*>&) const; \
+    template size_t Reader::readAll<T>(std::vector<T*>&) const;
+
+ERG_INSTANTIATE_TYPED_READ(int8_t)
+ERG_INSTANTIATE_TYPED_READ(int16_t)
+ERG_INSTANTIATE_TYPED_READ(int32_t)
+ERG_INSTANTIATE_TYPED_READ(int64_t)
+ERG_INSTANTIATE_TYPED_READ(uint8_t)
+ERG_INSTANTIATE_TYPED_READ(uint16_t)
+ERG_INSTANTIATE_TYPED_READ(uint32_t)
+ERG_INSTANTIATE_TYPED_READ(uint64_t)
+ERG_INSTANTIATE_TYPED_READ(float)
+ERG_INSTANTIATE_TYPED_READ(double)
+
+void Reader::setThreads(const size_t threads) noexcept(true)
+{
+    mThreads = threads;
+}
+
+void Reader::setAccess(const Access access) noexcept(true)
+{
+    const bool wasDirect = mAccess==Access::Direct;
+    mAccess = access;
+    if(mRecordSize==0)
+        return;
+
+    if(wasDirect && access!=Access::Direct && mOpenBackend!=Backend::Stream)
+        mapFile();
+    applyAccess();
+}
+
+void Reader::applyAccess() noexcept(true)
+{
+    if(mAccess==Access::Direct) {
+        // Reads from the mapping would go through the page cache
+        mMap.reset();
+        mBackend = Backend::Stream;
+#ifdef ERG_HAVE_DIRECT
+        if(mDirectFd<0)
+            mDirectFd = ::open(mFilename.c_str(), O_RDONLY | O_DIRECT);
+#endif
+        if(mDirectFd<0)
+            mAccess = Access::Once;
+    } else {
+#ifdef ERG_HAVE_DIRECT
+        if(mDirectFd>=0)
+            ::close(mDirectFd);
+#endif
+        mDirectFd = -1;
+    }
+
+#ifdef ERG_HAVE_FADVISE
+    int advice = POSIX_FADV_NORMAL;
+    if(mAccess==Access::Sequential)
+        advice = POSIX_FADV_SEQUENTIAL;
+    else if(mAccess==Access::Random || mAccess==Access::Once)
+        advice = POSIX_FADV_RANDOM;
+    if(mFd>=0)
+        ::posix_fadvise(mFd, 0, 0, advice);
+#endif
+
+#ifdef ERG_HAVE_MMAP
+    if(mMap) {
+        int madvice = MADV_NORMAL;
+        if(mAccess==Access::Sequential)
+            madvice = MADV_SEQUENTIAL;
+        else if(mAccess==Access::Random || mAccess==Access::Once)
+            madvice = MADV_RANDOM;
+        mMap->advise(0, mMap->size(), madvice);
+    }
+#endif
+}
+
+void Reader::dropCache(const size_t offset, const size_t size) const noexcept(true)
+{
+#ifdef ERG_HAVE_MMAP
+    // Unmap the pages first: mapped pages are never evicted
+    if(mMap)
+        mMap->advise(offset, size, MADV_DONTNEED);
+#endif
+#ifdef ERG_HAVE_FADVISE
+    if(mFd>=0)
+        ::posix_fadvise(mFd, offset, size, POSIX_FADV_DONTNEED);
+#else
+    (void)offset;
+    (void)size;
+#endif
+}
+
+size_t Reader::readDirect(const size_t offset, uint8_t* buffer, const size_t size) const
+{
+#ifdef ERG_HAVE_DIRECT
+    // O_DIRECT needs aligned offsets, sizes and memory
+    const size_t first = (offset + DIRECT_ALIGNMENT - 1) / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+    const size_t last = (offset + size) / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+    if(reinterpret_cast<uintptr_t>(buffer) % DIRECT_ALIGNMENT==offset % DIRECT_ALIGNMENT && first<last) {
+        size_t done = 0;
+        if(first>offset) {
+            done = readDirectBounced(mDirectFd, offset, buffer, first - offset);
+            if(done<first - offset)
+                return done;
+        }
+        const size_t pages = preadFully(mDirectFd, buffer + (first - offset), last - first, first);
+        done += pages;
+        if(pages<last - first || last==offset + size)
+            return done;
+        return done + readDirectBounced(mDirectFd, last, buffer + (last - offset), offset + size - last);
+    }
+    return readDirectBounced(mDirectFd, offset, buffer, size);
+#else
+    (void)offset;
+    (void)buffer;
+    (void)size;
+    return 0;
+#endif
+}
+
+std::vector<uint64_t> Reader::sidecarHeader() const noexcept(false)
+{
+    const std::vector<Quantity>& qs = quantities();
+    uint64_t magic = 0;
+    std::memcpy(&magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+
+    // Identity of the source file: the modification time in nanoseconds, the
+    // inode and the status change time detect a file rewritten with the same
+    // size, also within the same second.
+    uint64_t identity[6] = {0, 0, 0, 0, 0, 0};
+#ifdef ERG_HAVE_PREAD
+    struct stat st;
+    if(mFd>=0 && ::fstat(mFd, &st)==0) {
+#ifdef __APPLE__
+        const struct timespec& mtim = st.st_mtimespec;
+        const struct timespec& ctim = st.st_ctimespec;
+#else
+        const struct timespec& mtim = st.st_mtim;
+        const struct timespec& ctim = st.st_ctim;
+#endif
+        identity[0] = static_cast<uint64_t>(mtim.tv_sec);
+        identity[1] = static_cast<uint64_t>(mtim.tv_nsec);
+        identity[2] = static_cast<uint64_t>(st.st_ino);
+        identity[3] = static_cast<uint64_t>(st.st_dev);
+        identity[4] = static_cast<uint64_t>(ctim.tv_sec);
+        identity[5] = static_cast<uint64_t>(ctim.tv_nsec);
+    }
+#endif
+
+    uint64_t header[2] = {0, 0};
+    readAt(0, reinterpret_cast<uint8_t*>(header), std::min<size_t>(sizeof(header), mFileSize));
+
+    std::vector<uint64_t> words = {magic, SIDECAR_VERSION, 0x0102030405060708ULL, mFileSize,
+                                   identity[0], identity[1], identity[2], identity[3], identity[4], identity[5],
+                                   mRecordsCount, mRecordSize, header[0], header[1], qs.size()};
+    for(const Quantity& q: qs)
+    {
+        words.push_back(q.offset);
+        words.push_back(q.size);
+    }
+    return words;
+}
+
+bool Reader::openSidecar() noexcept(true)
+{
+    closeSidecar();
+#ifdef ERG_HAVE_PREAD
+    if(mRecordsCount==0 || mFd<0)
+        return false;
+
+    try {
+        const std::vector<uint64_t> expected = sidecarHeader();
+        const int fd = ::open(sidecarFilename(mFilename).c_str(), O_RDONLY);
+        if(fd<0)
+            return false;
+
+        std::vector<uint64_t> header(expected.size() + quantities().size(), 0);
+        const size_t headerSize = header.size() * sizeof(uint64_t);
+        struct stat st;
+        bool valid = preadFully(fd, reinterpret_cast<uint8_t*>(header.data()), headerSize, 0)==headerSize &&
+                     std::equal(expected.begin(), expected.end(), header.begin()) &&
+                     ::fstat(fd, &st)==0;
+        for(size_t i=0; valid && i<quantities().size(); ++i)
+        {
+            const uint64_t offset = header[expected.size() + i];
+            valid = offset + quantities()[i].size * mRecordsCount <= static_cast<uint64_t>(st.st_size);
+        }
+        if(!valid) {
+            ::close(fd);
+            return false;
+        }
+
+        mColOffsets.assign(header.begin() + expected.size(), header.end());
+        mColFd = fd;
+        return true;
+    } catch(std::exception&) {
+        return false;
+    }
+#else
+    return false;
+#endif
+}
+
+void Reader::closeSidecar() noexcept(true)
+{
+#ifdef ERG_HAVE_PREAD
+    if(mColFd>=0)
+        ::close(mColFd);
+#endif
+    mColFd = -1;
+    mColOffsets.clear();
+}
+
+void Reader::buildSidecar() noexcept(false)
+{
+    const std::vector<Quantity>& qs = quantities();
+#ifdef ERG_HAVE_PREAD
+    if(mRecordSize==0)
+        throw std::runtime_error("No file is open.");
+
+    // Never read the sidecar file that is being replaced
+    closeSidecar();
+
+    std::vector<uint64_t> header = sidecarHeader();
+    uint64_t offset = (header.size() + qs.size()) * sizeof(uint64_t);
+    for(const Quantity& q: qs)
+    {
+        // Each column starts on a cache line
+        offset = (offset + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+        header.push_back(offset);
+        offset += q.size * mRecordsCount;
+    }
+    const std::vector<uint64_t> offsets(header.end() - qs.size(), header.end());
+
+    writeFileAtomically(sidecarFilename(mFilename), [&](std::ofstream& out) {
+        out.write(reinterpret_cast<const char*>(header.data()), header.size() * sizeof(uint64_t));
+
+        Chunks chunks = this->chunks(SIDECAR_CHUNK);
+        while(chunks.next())
+        {
+            for(size_t i=0; i<qs.size(); ++i)
+            {
+                out.seekp(offsets[i] + chunks.from() * qs[i].size);
+                out.write(reinterpret_cast<const char*>(chunks.data(i)), chunks.rows() * qs[i].size);
+            }
+        }
+    });
+    openSidecar();
+#else
+    throw std::runtime_error("Sidecar files are not supported on this platform.");
+#endif
+}
+
+size_t Reader::readSidecar(const Column& column, const size_t from, const size_t rows, const size_t step) const
+{
+#ifdef ERG_HAVE_PREAD
+    const size_t size = column.elementSize;
+    const size_t offset = mColOffsets[column.qindex] + from * size;
+    if(step==1)
+        return preadFully(mColFd, column.dst, rows * size, offset) / size;
+
+    if(step * size > SPARSE_GAP) {
+        for(size_t i=0; i<rows; ++i)
+        {
+            if(preadFully(mColFd, column.dst + i * size, size, offset + i * step * size)<size)
+                return i;
+        }
+        return rows;
+    }
+
+    // Dense strides: read the span of a group of values and pick the selected ones
+    const size_t blockValues = std::max<size_t>(1, BLOCK_SIZE / (step * size));
+    AlignedBuffer block(((blockValues - 1) * step + 1) * size);
+    size_t done = 0;
+    while(done<rows)
+    {
+        const size_t n = std::min(blockValues, rows - done);
+        const size_t bytes = preadFully(mColFd, block.data(), ((n - 1) * step + 1) * size,
+                                        offset + done * step * size);
+        const size_t available = std::min(n, (bytes / size + step - 1) / step);
+        for(size_t i=0; i<available; ++i)
+            std::memcpy(column.dst + (done + i) * size, block.data() + i * step * size, size);
+        done += available;
+        if(available<n)
+            break;
+    }
+    return done;
+#else
+    (void)column;
+    (void)from;
+    (void)rows;
+    (void)step;
+    return 0;
+#endif
+}
+
+size_t Reader::recordAt(const double time) const noexcept(false)
+{
+    const size_t qindex = index("Time");
+    if(hasTimeIndex())
+        return scanTimeIndex(qindex, 0, time, std::numeric_limits<double>::infinity(), true);
+    return searchTime(qindex, 0, time, false);
+}
+
+size_t Reader::timeRange(const double t0, const double t1, size_t& from) const noexcept(false)
+{
+    const size_t qindex = index("Time");
+    from = recordAt(t0);
+    if(from>=mRecordsCount || t1<t0)
+        return 0;
+
+    const size_t end = hasTimeIndex() ? scanTimeIndex(qindex, from, t0, t1, false)
+                                      : searchTime(qindex, from, t1, true);
+    return end - from;
+}
+
+size_t Reader::readTimeRange(const std::vector<size_t>& qindices, const double t0, const double t1,
+                             std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const
+{
+    size_t from = 0;
+    const size_t count = timeRange(t0, t1, from);
+    if(count==0)
+        return 0;
+    return read(qindices, from, count, 1, values, sizes);
+}
+
+size_t Reader::gridSize(const double t0, const double t1, const double dt) noexcept(true)
+{
+    if(!(dt>0.0) || !(t1>=t0))
+        return 0;
+    // Tolerate the rounding of a t1 that is on the grid
+    return static_cast<size_t>(std::floor((t1 - t0) / dt + 1e-9)) + 1;
+}
+
+size_t Reader::resample(const std::vector<size_t>& qindices, const double t0, const double t1, const double dt,
+                        const Interpolation method, std::vector<double*>& values) const noexcept(false)
+{
+    if(values.size()!=qindices.size())
+        throw std::runtime_error("Wrong input size");
+    if(!(dt>0.0))
+        throw std::runtime_error("The time step must be positive.");
+    for(size_t qindex: qindices)
+    {
+        if(qindex>=quantities().size())
+            throw std::runtime_error("Index "+std::to_string(qindex)+" is out of bounds.");
+    }
+
+    const size_t points = gridSize(t0, t1, dt);
+    if(points==0 || mRecordsCount==0)
+        return 0;
+
+    // Time is read with the quantities as the first column
+    std::vector<size_t> columns(1, index("Time"));
+    columns.insert(columns.end(), qindices.begin(), qindices.end());
+
+    // The first row of the buffers holds the last record of the previous chunk
+    std::vector<std::vector<double>> buffers(columns.size(), std::vector<double>(RESAMPLE_CHUNK + 1));
+    std::vector<double*> pointers(columns.size());
+    std::vector<size_t> lower;
+    std::vector<size_t> upper;
+    std::vector<double> weights;
+
+    const size_t start = recordAt(t0);
+    size_t record = start>0 ? start - 1 : 0;
+    size_t carried = 0;
+    size_t k = 0;
+    while(k<points && record<mRecordsCount)
+    {
+        const size_t n = std::min<size_t>(RESAMPLE_CHUNK, mRecordsCount - record);
+        for(size_t c=0; c<columns.size(); ++c)
+            pointers[c] = buffers[c].data() + carried;
+        if(read<double>(columns, record, n, 1, pointers)<n)
+            throw std::runtime_error("Can't read the records "+std::to_string(record)+" to "+
+                                     std::to_string(record + n)+".");
+        record += n;
+        const size_t rows = carried + n;
+        const bool last = record>=mRecordsCount;
+        const double* t = buffers[0].data();
+
+        // Records and weight of each grid point inside the chunk. The points
+        // after the last record of the chunk wait for the next chunk.
+        lower.clear();
+        upper.clear();
+        weights.clear();
+        size_t j = 0;
+        while(k + lower.size()<points)
+        {
+            const double g = t0 + (k + lower.size()) * dt;
+            if(!last && g>=t[rows - 1])
+                break;
+            while(j + 1<rows && t[j + 1]<=g)
+                ++j;
+
+            size_t j0 = j;
+            size_t j1 = j;
+            double w = 0.0;
+            if(g>t[j] && j + 1<rows) {
+                if(method==Interpolation::Linear) {
+                    j1 = j + 1;
+                    w = (g - t[j]) / (t[j + 1] - t[j]);
+                } else if(method==Interpolation::Nearest && t[j + 1] - g<g - t[j]) {
+                    j0 = j1 = j + 1;
+                }
+            }
+            lower.push_back(j0);
+            upper.push_back(j1);
+            weights.push_back(w);
+        }
+
+        for(size_t c=1; c<columns.size(); ++c)
+        {
+            const double* a = buffers[c].data();
+            double* dst = values[c - 1] + k;
+            for(size_t i=0; i<lower.size(); ++i)
+                dst[i] = weights[i]==0.0 ? a[lower[i]] : a[lower[i]] + weights[i] * (a[upper[i]] - a[lower[i]]);
         }
+        k += lower.size();
+
+        for(std::vector<double>& b: buffers)
+            b[0] = b[rows - 1];
+        carried = 1;
     }
+    return k;
+}
 
-    size_t colIndex = 0;
-    std::string num;
-    std::string targetName;
-    std::string targetType;
-    std::string targetUnit;
+double Reader::timeAt(const size_t qindex, const size_t record) const noexcept(false)
+{
+    const Quantity& q = quantities()[qindex];
+    const size_t offset = record * mRecordSize + q.offset;
+
+    uint8_t raw[sizeof(uint64_t)];
+    const uint8_t* src = raw;
+    const uint8_t* records = mappedRecords();
+    if(q.size>sizeof(raw))
+        throw std::runtime_error("Unsupported type for the quantity "+q.name+".");
+    if(records!=nullptr)
+        src = records + offset;
+    else if(readAt(initialSkipBytes() + offset, raw, q.size)<q.size)
+        throw std::runtime_error("Can't read the record "+std::to_string(record)+".");
+
+    double value = 0.0;
+    const Column column = typedColumn<double>(qindex, &value);
+    column.convert(src, q.size, 1, column.dst);
+    return value;
+}
 
-    // Search for all the quantities with brute force approach
-    // by searching all the names an types in format
-    // "File.At.<index>.Name" and "File.At.<index>.Type".
-    // Both name and type must be available; if not, the search end
-    // and the next quantities are ignored.
-    bool done = false;
-    while(!done)
+size_t Reader::searchTime(const size_t qindex, const size_t from, const double time, const bool after) const noexcept(false)
+{
+    size_t first = from;
+    size_t last = mRecordsCount;
+    while(first<last)
     {
-        colIndex += 1;
-        targetName.clear();
-        targetType.clear();
-        targetUnit.clear();
-        num = std::to_string(colIndex);
+        const size_t middle = first + (last - first) / 2;
+        const double value = timeAt(qindex, middle);
+        if(after ? value<=time : value<time)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first;
+}
 
-        targetName.append("File.At.").append(num).append(".Name");
-        targetType.append("File.At.").append(num).append(".Type");
+size_t Reader::scanTimeIndex(const size_t qindex, const size_t from, const double t0, const double t1,
+                             const bool inside) const noexcept(false)
+{
+    std::vector<double> times;
+    for(size_t block=from/mTimeBlock; block<mTimeMin.size(); ++block)
+    {
+        // Skip the blocks where no record can match
+        const bool anyInside = mTimeMax[block]>=t0 && mTimeMin[block]<=t1;
+        const bool allInside = mTimeMin[block]>=t0 && mTimeMax[block]<=t1;
+        if(inside ? !anyInside : allInside)
+            continue;
 
-        Quantity q;
+        const size_t first = std::max(from, block * mTimeBlock);
+        const size_t rows = std::min(mRecordsCount, (block + 1) * mTimeBlock) - first;
+        times.resize(rows);
+        if(read<double>(qindex, first, rows, times.data())<rows)
+            throw std::runtime_error("Can't read the records of the time index block "+std::to_string(block)+".");
 
-        auto typeIt = infoMap.find(targetType);
-        if(typeIt==infoMap.end())
+        for(size_t i=0; i<rows; ++i)
         {
-            done = true;
-            continue;
+            if((times[i]>=t0 && times[i]<=t1)==inside)
+                return first + i;
         }
+    }
+    return mRecordsCount;
+}
 
-        q.typeStr = typeIt->second;
-        q.type = dataType(q.typeStr);
-        if(q.type==Type::Void)
+std::vector<uint64_t> Reader::indexHeader(const char* magic, const uint64_t version) const noexcept(false)
+{
+    // Same validation of the source file as the sidecar file
+    std::vector<uint64_t> words = sidecarHeader();
+    words[0] = 0;
+    std::memcpy(&words[0], magic, std::min(std::strlen(magic) + 1, sizeof(uint64_t)));
+    words[1] = version;
+    return words;
+}
+
+bool Reader::openTimeIndex() noexcept(true)
+{
+    mTimeBlock = 0;
+    mTimeMin.clear();
+    mTimeMax.clear();
+    if(mRecordsCount==0 || has("Time")==false)
+        return false;
+
+    try {
+        std::ifstream in(timeIndexFilename(mFilename), std::ios_base::in | std::ios_base::binary);
+        if(!in.is_open())
+            return false;
+
+        const std::vector<uint64_t> expected = indexHeader(TIME_INDEX_MAGIC, TIME_INDEX_VERSION);
+        std::vector<uint64_t> header(expected.size() + 1, 0);
+        in.read(reinterpret_cast<char*>(header.data()), header.size() * sizeof(uint64_t));
+        const uint64_t blockRecords = header.back();
+        if(!in || !std::equal(expected.begin(), expected.end(), header.begin()) || blockRecords==0)
+            return false;
+
+        const size_t blocks = (mRecordsCount + blockRecords - 1) / blockRecords;
+        std::vector<double> minTimes(blocks);
+        std::vector<double> maxTimes(blocks);
+        in.read(reinterpret_cast<char*>(minTimes.data()), blocks * sizeof(double));
+        in.read(reinterpret_cast<char*>(maxTimes.data()), blocks * sizeof(double));
+        if(!in)
+            return false;
+
+        mTimeMin.swap(minTimes);
+        mTimeMax.swap(maxTimes);
+        mTimeBlock = blockRecords;
+        return true;
+    } catch(std::exception&) {
+        return false;
+    }
+}
+
+void Reader::buildTimeIndex(const size_t blockRecords) noexcept(false)
+{
+    if(mRecordSize==0)
+        throw std::runtime_error("No file is open.");
+    if(blockRecords==0)
+        throw std::runtime_error("The blocks of the time index must contain at least one record.");
+    const size_t qindex = index("Time");
+
+    // Never search with the index that is being replaced
+    mTimeBlock = 0;
+
+    const size_t blocks = (mRecordsCount + blockRecords - 1) / blockRecords;
+    std::vector<double> minTimes(blocks);
+    std::vector<double> maxTimes(blocks);
+    std::vector<double> times(std::max<size_t>(1, SIDECAR_CHUNK / blockRecords) * blockRecords);
+    for(size_t from=0; from<mRecordsCount; from+=times.size())
+    {
+        const size_t rows = std::min(times.size(), mRecordsCount - from);
+        if(read<double>(qindex, from, rows, times.data())<rows)
+            throw std::runtime_error("Can't read the Time quantity.");
+
+        for(size_t i=0; i<rows; i+=blockRecords)
         {
-            // Padding bytes: decode size and skipping...
-            q.size = strtol(q.typeStr.c_str(), nullptr, 10);
-            q.name = "";
+            const auto minMax = std::minmax_element(times.begin() + i, times.begin() + std::min(rows, i + blockRecords));
+            minTimes[(from + i) / blockRecords] = *minMax.first;
+            maxTimes[(from + i) / blockRecords] = *minMax.second;
         }
-        else
-        {
-            auto nameIt = infoMap.find(targetName);
-            if(nameIt==infoMap.end())
-            {
-                done = true;
-                continue;
-            }
+    }
 
-            q.name = nameIt->second;
+    std::vector<uint64_t> header = indexHeader(TIME_INDEX_MAGIC, TIME_INDEX_VERSION);
+    header.push_back(blockRecords);
 
-            // Decode unit if present
-            targetUnit.append("Quantity.").append(q.name).append(".Unit");
-            auto quantityIt = infoMap.find(targetUnit);
-            if(quantityIt!=infoMap.end())
-                q.unit = quantityIt->second;
+    writeFileAtomically(timeIndexFilename(mFilename), [&](std::ofstream& out) {
+        out.write(reinterpret_cast<const char*>(header.data()), header.size() * sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(minTimes.data()), blocks * sizeof(double));
+        out.write(reinterpret_cast<const char*>(maxTimes.data()), blocks * sizeof(double));
+    });
+    openTimeIndex();
+}
 
-            q.type = dataType(q.typeStr);
-            q.size = dataSize(q.type);
+/*!
+ * \brief Match of a predicate with the range of the values of a block.
+ * \param predicate The predicate.
+ * \param min Minimum of the block, `-inf` if unknown.
+ * \param max Maximum of the block, `+inf` if unknown.
+ * \return `0` if no value can match, `1` if some values can match, `2` if all the values match.
+ */
+static int zoneMatch(const Predicate& predicate, const double min, const double max)
+{
+    const double v = predicate.operand;
+    switch(predicate.op)
+    {
+    case Compare::Less:
+        return max<v ? 2 : (min<v ? 1 : 0);
+    case Compare::LessEqual:
+        return max<=v ? 2 : (min<=v ? 1 : 0);
+    case Compare::Greater:
+        return min>v ? 2 : (max>v ? 1 : 0);
+    case Compare::GreaterEqual:
+        return min>=v ? 2 : (max>=v ? 1 : 0);
+    case Compare::Equal:
+        return (min==v && max==v) ? 2 : ((min<=v && v<=max) ? 1 : 0);
+    case Compare::NotEqual:
+        return (v<min || v>max) ? 2 : ((min==v && max==v) ? 0 : 1);
+    }
+    return 1;
+}
+
+/*!
+ * \brief Clear the mask of the values that don't satisfy a comparison.
+ *
+ * The loop has no branches, so it is vectorized by the compiler.
+ */
+template<typename Op>
+static void applyPredicate(const double* values, const size_t rows, const double operand, uint8_t* mask, Op op)
+{
+    for(size_t i=0; i<rows; ++i)
+        mask[i] &= static_cast<uint8_t>(op(values[i], operand));
+}
+
+void Reader::scanWhere(const std::vector<Predicate>& predicates,
+                       const std::function<void(const std::vector<size_t>&)>& visit) const noexcept(false)
+{
+    // Each quantity of the predicates is read once
+    std::vector<size_t> qindices;
+    std::vector<size_t> slots;
+    for(const Predicate& p: predicates)
+    {
+        if(p.qindex>=quantities().size())
+            throw std::runtime_error("Index "+std::to_string(p.qindex)+" is out of bounds.");
+        const auto it = std::find(qindices.begin(), qindices.end(), p.qindex);
+        slots.push_back(std::distance(qindices.begin(), it));
+        if(it==qindices.end())
+            qindices.push_back(p.qindex);
+    }
+
+    const size_t block = hasZoneMap() ? mZoneBlock : FILTER_CHUNK;
+    const size_t blocks = (mRecordsCount + block - 1) / block;
+    const size_t runBlocks = std::max<size_t>(1, FILTER_CHUNK / block);
+    auto blockMatch = [&](const size_t b)->int {
+        if(predicates.empty())
+            return 2;
+        if(!hasZoneMap())
+            return 1;
+        int match = 2;
+        for(const Predicate& p: predicates)
+            match = std::min(match, zoneMatch(p, mZoneMin[p.qindex * blocks + b], mZoneMax[p.qindex * blocks + b]));
+        return match;
+    };
+
+    const size_t runRows = std::min(mRecordsCount, runBlocks * block);
+    std::vector<std::vector<double>> values(qindices.size(), std::vector<double>(runRows));
+    std::vector<double*> pointers;
+    for(std::vector<double>& v: values)
+        pointers.push_back(v.data());
+    std::vector<uint8_t> mask;
+    std::vector<size_t> matches;
+
+    size_t b = 0;
+    while(b<blocks)
+    {
+        const int match = blockMatch(b);
+        if(match==0) {
+            ++b;
+            continue;
         }
 
-        mQuantities.push_back(q);
+        // Evaluate together the following blocks with the same match
+        size_t end = b + 1;
+        while(end<blocks && end - b<runBlocks && blockMatch(end)==match)
+            ++end;
+        const size_t from = b * block;
+        const size_t rows = std::min(mRecordsCount, end * block) - from;
+        b = end;
+
+        matches.clear();
+        if(match==2) {
+            for(size_t i=0; i<rows; ++i)
+                matches.push_back(from + i);
+        } else {
+            if(read<double>(qindices, from, rows, 1, pointers)<rows)
+                throw std::runtime_error("Can't read the records "+std::to_string(from)+" to "+
+                                         std::to_string(from + rows)+".");
+
+            mask.assign(rows, 1);
+            for(size_t k=0; k<predicates.size(); ++k)
+            {
+                const double* x = values[slots[k]].data();
+                const double v = predicates[k].operand;
+                switch(predicates[k].op)
+                {
+                case Compare::Less:         applyPredicate(x, rows, v, mask.data(), std::less<double>()); break;
+                case Compare::LessEqual:    applyPredicate(x, rows, v, mask.data(), std::less_equal<double>()); break;
+                case Compare::Greater:      applyPredicate(x, rows, v, mask.data(), std::greater<double>()); break;
+                case Compare::GreaterEqual: applyPredicate(x, rows, v, mask.data(), std::greater_equal<double>()); break;
+                case Compare::Equal:        applyPredicate(x, rows, v, mask.data(), std::equal_to<double>()); break;
+                case Compare::NotEqual:     applyPredicate(x, rows, v, mask.data(), std::not_equal_to<double>()); break;
+                }
+            }
+            for(size_t i=0; i<rows; ++i)
+            {
+                if(mask[i])
+                    matches.push_back(from + i);
+            }
+        }
+
+        if(!matches.empty())
+            visit(matches);
     }
+}
 
-    // Check record size
-    const size_t numAllQuanties = mQuantities.size();
-    size_t recordBytes = 0;
-    for(size_t i=0; i<numAllQuanties; ++i)
+std::vector<size_t> Reader::where(const std::vector<Predicate>& predicates) const noexcept(false)
+{
+    std::vector<size_t> records;
+    scanWhere(predicates, [&records](const std::vector<size_t>& matches) {
+        records.insert(records.end(), matches.begin(), matches.end());
+    });
+    return records;
+}
+
+size_t Reader::readWhere(const std::vector<Predicate>& predicates, const std::vector<size_t>& qindices,
+                         std::vector<std::vector<uint8_t>>& values) const noexcept(false)
+{
+    for(size_t qindex: qindices)
     {
-        mQuantities[i].offset = recordBytes;
-        recordBytes += mQuantities[i].size;
+        if(qindex>=quantities().size())
+            throw std::runtime_error("Index "+std::to_string(qindex)+" is out of bounds.");
     }
 
-    mRecordSize = recordBytes;
+    values.assign(qindices.size(), std::vector<uint8_t>());
+    std::vector<std::vector<uint8_t>> buffers(qindices.size());
+    std::vector<uint8_t*> pointers(qindices.size());
+    std::vector<size_t> sizes(qindices.size());
+    size_t count = 0;
+    scanWhere(predicates, [&](const std::vector<size_t>& matches) {
+        // Read only the span of the matching records
+        const size_t first = matches.front();
+        const size_t span = matches.back() - first + 1;
+        for(size_t i=0; i<qindices.size(); ++i)
+        {
+            buffers[i].resize(span * quantities()[qindices[i]].size);
+            pointers[i] = buffers[i].data();
+            sizes[i] = buffers[i].size();
+        }
+        if(read(qindices, first, span, 1, pointers, sizes)<span)
+            throw std::runtime_error("Can't read the records "+std::to_string(first)+" to "+
+                                     std::to_string(first + span)+".");
 
-    // Remove the padding quantities if present
-    auto toRemoveIt = std::remove_if(mQuantities.begin(), mQuantities.end(),
-                                     [](Quantity& x){return x.type==Type::Void;});
-    mQuantities.erase(toRemoveIt, mQuantities.end());
+        for(size_t i=0; i<qindices.size(); ++i)
+        {
+            const size_t size = quantities()[qindices[i]].size;
+            values[i].resize((count + matches.size()) * size);
+            uint8_t* dst = values[i].data() + count * size;
+            if(span==matches.size()) {
+                std::memcpy(dst, buffers[i].data(), span * size);
+                continue;
+            }
+            for(size_t j=0; j<matches.size(); ++j)
+                std::memcpy(dst + j * size, buffers[i].data() + (matches[j] - first) * size, size);
+        }
+        count += matches.size();
+    });
+    return count;
 }
 
-void Reader::parseFortranFormat()
+bool Reader::openZoneMap() noexcept(true)
 {
-    // Read the record size
-    uint32_t rowSize = 0;
-    mFile.read(reinterpret_cast<char*>(&rowSize), sizeof(header_t));
-    if(mByteOrder==ByteOrder::LittelEndian)
-        rowSize = le2h32(rowSize);
-    else
-        rowSize = be2h32(rowSize);
+    mZoneBlock = 0;
+    mZoneMin.clear();
+    mZoneMax.clear();
+    if(mRecordsCount==0)
+        return false;
 
-    mRecordSize = rowSize + 2 * sizeof(uint32_t);
+    try {
+        std::ifstream in(zoneMapFilename(mFilename), std::ios_base::in | std::ios_base::binary);
+        if(!in.is_open())
+            return false;
+
+        const std::vector<uint64_t> expected = indexHeader(ZONE_MAP_MAGIC, ZONE_MAP_VERSION);
+        std::vector<uint64_t> header(expected.size() + 1, 0);
+        in.read(reinterpret_cast<char*>(header.data()), header.size() * sizeof(uint64_t));
+        const uint64_t blockRecords = header.back();
+        if(!in || !std::equal(expected.begin(), expected.end(), header.begin()) || blockRecords==0)
+            return false;
+
+        const size_t values = (mRecordsCount + blockRecords - 1) / blockRecords * quantities().size();
+        std::vector<double> minValues(values);
+        std::vector<double> maxValues(values);
+        in.read(reinterpret_cast<char*>(minValues.data()), values * sizeof(double));
+        in.read(reinterpret_cast<char*>(maxValues.data()), values * sizeof(double));
+        if(!in)
+            return false;
+
+        mZoneMin.swap(minValues);
+        mZoneMax.swap(maxValues);
+        mZoneBlock = blockRecords;
+        return true;
+    } catch(std::exception&) {
+        return false;
+    }
+}
 
-    // Evaluate number of records
-    mFile.seekg(0, std::ios_base::end);
-    mFileSize = mFile.tellg();
-    mRecordsCount = mFileSize/mRecordSize;
+void Reader::buildZoneMap(const size_t blockRecords, const bool persist) noexcept(false)
+{
+    const std::vector<Quantity>& qs = quantities();
+    if(mRecordSize==0)
+        throw std::runtime_error("No file is open.");
+    if(blockRecords==0)
+        throw std::runtime_error("The blocks of the zone map must contain at least one record.");
+
+    // Never filter with the zone map that is being replaced
+    mZoneBlock = 0;
+
+    // The range of the quantities without a numeric type is unknown
+    const double inf = std::numeric_limits<double>::infinity();
+    const size_t blocks = (mRecordsCount + blockRecords - 1) / blockRecords;
+    std::vector<double> minValues(blocks * qs.size(), -inf);
+    std::vector<double> maxValues(blocks * qs.size(), inf);
+    std::vector<size_t> qindices;
+    std::vector<ConvertFunction> kernels;
+    for(size_t i=0; i<qs.size(); ++i)
+    {
+        if(qs[i].type==Type::Void)
+            continue;
+        qindices.push_back(i);
+        kernels.push_back(convertKernel<double, false>(qs[i].type));
+    }
 
-    // Update quantities offset to ignore the record size attribute
-    // in each row.
-    for(Quantity& q: mQuantities)
-        q.offset += sizeof(uint32_t);
+    const size_t chunkRows = std::max<size_t>(1, SIDECAR_CHUNK / blockRecords) * blockRecords;
+    std::vector<double> values(std::min(chunkRows, mRecordsCount));
+    Chunks chunks = this->chunks(chunkRows, qindices);
+    while(chunks.next())
+    {
+        const size_t rows = chunks.rows();
+        for(size_t c=0; c<qindices.size(); ++c)
+        {
+            kernels[c](chunks.data(c), qs[qindices[c]].size, rows, reinterpret_cast<uint8_t*>(values.data()));
+            for(size_t i=0; i<rows; i+=blockRecords)
+            {
+                double low = inf;
+                double high = -inf;
+                bool nan = false;
+                for(size_t j=i; j<std::min(rows, i + blockRecords); ++j)
+                {
+                    nan |= values[j]!=values[j];
+                    low = std::min(low, values[j]);
+                    high = std::max(high, values[j]);
+                }
+                // NaN values match no comparison but `!=`: keep the range unknown
+                const size_t index = qindices[c] * blocks + (chunks.from() + i) / blockRecords;
+                minValues[index] = nan ? -inf : low;
+                maxValues[index] = nan ? inf : high;
+            }
+        }
+    }
+
+    if(persist) {
+        std::vector<uint64_t> header = indexHeader(ZONE_MAP_MAGIC, ZONE_MAP_VERSION);
+        header.push_back(blockRecords);
+        writeFileAtomically(zoneMapFilename(mFilename), [&](std::ofstream& out) {
+            out.write(reinterpret_cast<const char*>(header.data()), header.size() * sizeof(uint64_t));
+            out.write(reinterpret_cast<const char*>(minValues.data()), minValues.size() * sizeof(double));
+            out.write(reinterpret_cast<const char*>(maxValues.data()), maxValues.size() * sizeof(double));
+        });
+    }
+
+    mZoneMin.swap(minValues);
+    mZoneMax.swap(maxValues);
+    mZoneBlock = mRecordsCount>0 ? blockRecords : 0;
 }
 
-void Reader::parseErgFormat()
+/*!
+ * \brief Accumulator of the statistics of a quantity.
+ */
+class StatsAccumulator
 {
-    // Read the header of the file and check for bad format
-    header_t header;
-    std::memset(&header, 0, sizeof(header_t));
-    mFile.seekg(0, std::ios_base::beg);
-    mFile.read(reinterpret_cast<char*>(&header), sizeof(header_t));
+public:
+    explicit StatsAccumulator(const StatsOptions& options) noexcept(false)
+        : mOptions(options), mCount(0), mNans(0), mMin(std::numeric_limits<double>::infinity()),
+          mMax(-std::numeric_limits<double>::infinity()), mMean(0.0), mM2(0.0), mHistogram(options.bins, 0)
+    {
+    }
 
-    if(std::strncmp(reinterpret_cast<char*>(header.identifier), "CM-ERG", sizeof("CM-ERG"))!=0) {
-        close();
-        throw std::runtime_error("Not an erg file: "+mFilename);
+    /*!
+     * \brief Add a block of values.
+     *
+     * The mean and the squared deviations of the block are computed with two
+     * branch-free passes, which the compiler vectorizes, and merged.
+     */
+    void add(const double* values, const size_t rows) noexcept(true)
+    {
+        size_t n = 0;
+        double sum = 0.0;
+        double low = mMin;
+        double high = mMax;
+        for(size_t i=0; i<rows; ++i)
+        {
+            const double x = values[i];
+            const bool valid = x==x;
+            n += valid;
+            sum += valid ? x : 0.0;
+            low = std::min(low, x);     // NaN ignored: returns low
+            high = std::max(high, x);
+        }
+        mNans += rows - n;
+        mMin = low;
+        mMax = high;
+        if(n==0)
+            return;
+
+        const double mean = sum / n;
+        double m2 = 0.0;
+        for(size_t i=0; i<rows; ++i)
+        {
+            const double d = values[i] - mean;
+            m2 += values[i]==values[i] ? d * d : 0.0;
+        }
+        merge(n, mean, m2);
+
+        if(mOptions.bins>0 && mOptions.high>mOptions.low) {
+            const double scale = mOptions.bins / (mOptions.high - mOptions.low);
+            for(size_t i=0; i<rows; ++i)
+            {
+                // The upper edge belongs to the last bin
+                const double x = values[i];
+                if(x>=mOptions.low && x<=mOptions.high)
+                    ++mHistogram[std::min(static_cast<size_t>((x - mOptions.low) * scale), mOptions.bins - 1)];
+            }
+        }
     }
 
-    if(header.version!=1) {
-        close();
-        throw std::runtime_error("Unsupported version: " + std::to_string(header.version));
+    //! Merge the statistics of another accumulator.
+    void merge(const StatsAccumulator& other) noexcept(true)
+    {
+        merge(other.mCount, other.mMean, other.mM2);
+        mNans += other.mNans;
+        mMin = std::min(mMin, other.mMin);
+        mMax = std::max(mMax, other.mMax);
+        for(size_t i=0; i<mHistogram.size(); ++i)
+            mHistogram[i] += other.mHistogram[i];
     }
 
-    // Check endianess and record size according to the
-    // companion file.
-    size_t expectedRecordSize = 0;
-    if(header.byte_order==0)
+    Stats stats() const noexcept(false)
     {
-        if(mByteOrder!=ByteOrder::LittelEndian) {
-            close();
-            throw std::runtime_error("Unexpected endianess specified in .erg file.");
-        }
-        expectedRecordSize = le2h16(header.record_size);
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        Stats s;
+        s.count = mCount;
+        s.nans = mNans;
+        s.min = mCount>0 ? mMin : nan;
+        s.max = mCount>0 ? mMax : nan;
+        s.mean = mCount>0 ? mMean : nan;
+        s.stddev = mCount>0 ? std::sqrt(mM2 / mCount) : nan;
+        s.rms = mCount>0 ? std::sqrt(mM2 / mCount + mMean * mMean) : nan;
+        s.histogram = mHistogram;
+        return s;
     }
-    else
+
+private:
+    //! Parallel update of the mean and of the sum of the squared deviations
+    void merge(const size_t n, const double mean, const double m2) noexcept(true)
     {
-        if(mByteOrder!=ByteOrder::BigEndian) {
-            close();
-            throw std::runtime_error("Unexpected endianess specified in .erg file.");
+        if(n==0)
+            return;
+        const size_t total = mCount + n;
+        const double delta = mean - mMean;
+        mMean += delta * n / total;
+        mM2 += m2 + delta * delta * (static_cast<double>(mCount) * n / total);
+        mCount = total;
+    }
+
+    const StatsOptions& mOptions;
+    size_t mCount;
+    size_t mNans;
+    double mMin;
+    double mMax;
+    double mMean;
+    double mM2;     //!< Sum of the squared deviations from the mean
+    std::vector<size_t> mHistogram;
+};
+
+std::vector<Stats> Reader::stats(const std::vector<size_t>& qindices, const size_t from, const size_t count,
+                                 const StatsOptions& options) const noexcept(false)
+{
+    for(size_t qindex: qindices)
+    {
+        if(qindex>=quantities().size())
+            throw std::runtime_error("Index "+std::to_string(qindex)+" is out of bounds.");
+    }
+
+    const size_t rows = rangeSize(from, count);
+    const size_t blockRecords = mRecordSize>0 ? std::max<size_t>(1, BLOCK_SIZE / mRecordSize) : 1;
+    const size_t chunkRows = std::min<size_t>(blockRecords, STATS_CHUNK);
+
+    // Each worker reduces a contiguous slice of at least a block of records
+    const size_t workers = std::max<size_t>(1, std::min(threads(), rows / blockRecords));
+    const size_t sliceRecords = (rows + workers - 1) / workers;
+    std::vector< std::vector<StatsAccumulator> > accumulators(workers,
+        std::vector<StatsAccumulator>(qindices.size(), StatsAccumulator(options)));
+    std::vector<std::exception_ptr> errors(workers);
+
+    auto worker = [&](const size_t w)
+    {
+        try {
+            const size_t start = w * sliceRecords;
+            const size_t end = std::min(rows, start + sliceRecords);
+            std::vector<double> values(qindices.size() * chunkRows);
+            std::vector<Column> columns;
+            for(size_t i=0; i<qindices.size(); ++i)
+                columns.push_back(typedColumn<double>(qindices[i], values.data() + i * chunkRows));
+
+            for(size_t first=start; first<end; first+=chunkRows)
+            {
+                const size_t n = std::min(chunkRows, end - first);
+                if(readBlocks(columns, from + first, n, 1)<n)
+                    throw std::runtime_error("Can't read the records "+std::to_string(from + first)+" to "+
+                                             std::to_string(from + first + n)+".");
+                for(size_t i=0; i<qindices.size(); ++i)
+                    accumulators[w][i].add(values.data() + i * chunkRows, n);
+            }
+        } catch(...) {
+            errors[w] = std::current_exception();
         }
-        expectedRecordSize = be2h16(header.record_size);
+    };
+
+    std::vector<std::thread> pool;
+    try {
+        for(size_t w=1; w<workers; ++w)
+            pool.push_back(std::thread(worker, w));
+    } catch(...) {
+        // Joinable threads can't be destroyed: wait for the ones already started
+        for(std::thread& t: pool)
+            t.join();
+        throw;
     }
-    if(expectedRecordSize!=mRecordSize) {
-        close();
-        throw std::runtime_error("Unexpected record size specified in .erg file.");
+    worker(0);
+    for(std::thread& t: pool)
+        t.join();
+
+    for(std::exception_ptr& e: errors) {
+        if(e)
+            std::rethrow_exception(e);
     }
 
-    // Evaluate number of records
-    mFile.seekg(0, std::ios_base::end);
-    mFileSize = mFile.tellg();
-    mRecordsCount = (mFileSize-sizeof(header_t))/mRecordSize;
+    std::vector<Stats> result;
+    for(size_t i=0; i<qindices.size(); ++i)
+    {
+        for(size_t w=1; w<workers; ++w)
+            accumulators[0][i].merge(accumulators[w][i]);
+        result.push_back(accumulators[0][i].stats());
+    }
+    return result;
+}
+
+void Reader::setCacheSize(const size_t bytes) noexcept(true)
+{
+    mCache->setBudget(bytes);
+}
+
+size_t Reader::cacheSize() const noexcept(true)
+{
+    return mCache->budget();
+}
+
+CacheStats Reader::cacheStats() const noexcept(true)
+{
+    return mCache->stats();
+}
+
+void Reader::setPrefetch(const size_t buffers) noexcept(true)
+{
+    mPrefetch = buffers;
+}
+
+std::future<size_t> Reader::readAsync(const std::vector<size_t>& qindices, const size_t from, const size_t count,
+                                      const size_t step, const std::vector<uint8_t*>& values,
+                                      const std::vector<size_t>& sizes,
+                                      const std::function<void(size_t)>& callback) const
+{
+    return std::async(std::launch::async, [this, qindices, from, count, step, values, sizes, callback]() {
+        std::vector<uint8_t*> dst(values);
+        const size_t rows = read(qindices, from, count, step, dst, sizes);
+        if(callback)
+            callback(rows);
+        return rows;
+    });
+}
+
+size_t Reader::threads() const noexcept(true)
+{
+    if(mThreads>0)
+        return mThreads;
+    return std::max<unsigned>(1, std::thread::hardware_concurrency());
+}
+
+bool Reader::mapFile() noexcept(true)
+{
+    // Nothing to map if the file does not contain any record.
+    if(mRecordsCount==0)
+        return false;
+
+    try {
+        std::shared_ptr<MappedFile> map = std::make_shared<MappedFile>(mFilename);
+        if(map->size()<initialSkipBytes()+mRecordsCount*mRecordSize)
+            return false;
+        mMap = map;
+        mBackend = Backend::Mmap;
+        return true;
+    } catch(std::runtime_error&) {
+        return false;
+    }
+}
+
+const uint8_t* Reader::mappedRecords() const noexcept(true)
+{
+    if(!mMap)
+        return nullptr;
+    return mMap->data() + initialSkipBytes();
 }
 
+std::shared_ptr<const uint8_t> Reader::mappedData() const noexcept(true)
+{
+    if(!mMap)
+        return std::shared_ptr<const uint8_t>();
+    // Aliasing constructor: the pointer keeps the whole mapping alive.
+    return std::shared_ptr<const uint8_t>(mMap, mappedRecords());
+}
 
 size_t Reader::dataSize(const Type type) noexcept(false)
 {
@@ -732,6 +3494,86 @@ Type Reader::dataType(const char* typestr) noexcept(true)
     return Type::Void;
 }
 
+std::string Reader::typeName(const Type type) noexcept(false)
+{
+    switch (type)
+    {
+    case Type::Double:
+        return "Double";
+    case Type::Float:
+        return "Float";
+    case Type::Int64:
+        return "LongLong";
+    case Type::Uint64:
+        return "ULongLong";
+    case Type::Int32:
+        return "Int";
+    case Type::Uint32:
+        return "UInt";
+    case Type::Int16:
+        return "Short";
+    case Type::Uint16:
+        return "UShort";
+    case Type::Int8:
+        return "Char";
+    case Type::Uint8:
+        return "UChar";
+    case Type::Void:
+    default:
+        throw std::runtime_error("Unknown data type.");
+    }
+}
+
+
+Chunks::Chunks(const Reader& reader, const size_t chunkRows, const std::vector<size_t>& qindices) noexcept(false)
+    : mReader(&reader), mChunkRows(chunkRows), mFrom(0), mRows(0), mCapacity(0), mQIndices(qindices)
+{
+    if(chunkRows==0)
+        throw std::runtime_error("The chunk must contain at least one record.");
+
+    // No need for buffers larger than the whole file: next() grows them
+    // up to chunkRows if the file grows, as a followed file does.
+    mBuffers.resize(mQIndices.size());
+    mPointers.resize(mQIndices.size());
+    mSizes.resize(mQIndices.size());
+    reserve(std::min(chunkRows, reader.records()));
+}
+
+void Chunks::reserve(const size_t rows) noexcept(false)
+{
+    for(size_t i=0; i<mQIndices.size(); ++i)
+    {
+        mBuffers[i].resize(rows * Reader::dataSize(mReader->quantityType(mQIndices[i])));
+        mPointers[i] = mBuffers[i].data();
+        mSizes[i] = mBuffers[i].size();
+    }
+    mCapacity = rows;
+}
+
+bool Chunks::next() noexcept(false)
+{
+    const size_t from = mFrom + mRows;
+    const size_t count = mReader->rangeSize(from, mChunkRows);
+    if(count==0) {
+        mFrom = from;
+        mRows = 0;
+        return false;
+    }
+
+    if(count>mCapacity)
+        reserve(count);
+
+    mRows = mReader->read(mQIndices, from, count, 1, mPointers, mSizes);
+    mFrom = from;
+    return mRows>0;
+}
+
+void Chunks::rewind() noexcept(true)
+{
+    mFrom = 0;
+    mRows = 0;
+}
+
 
 }
 
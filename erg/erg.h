@@ -37,7 +37,14 @@
 #include <cstdint>
 #include <cstring>
 #include <stdexcept>
+#include <exception>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <regex>
 
 
 // Workaround for Mingw 4.7 std::tostring() method bug.
@@ -96,6 +103,50 @@ enum class Format
     Erg = 2
 };
 
+/*!
+ * \brief I/O backend used to access the data section of the `.erg` file.
+ */
+enum class Backend
+{
+    Auto,   //!< Memory map the file if possible, fallback to Stream otherwise.
+    Stream, //!< Read the file through a `std::ifstream`.
+    Mmap    //!< Memory map the file; open() throws if the file can't be mapped.
+};
+
+/*!
+ * \brief Expected access pattern to the data, forwarded to the kernel as I/O hints.
+ */
+enum class Access
+{
+    Normal,     //!< No hint, default kernel readahead.
+    Sequential, //!< Large scans of the file: aggressive readahead.
+    Random,     //!< Small windows of records: no readahead.
+    Once,       //!< Data read once: the pages are dropped from the page cache after each read.
+    Direct      //!< Bypass the page cache with `O_DIRECT` reads into aligned buffers. Uses Backend::Stream.
+};
+
+/*!
+ * \brief Use of the column-major sidecar file (`.erg.col`) next to the `.erg` file.
+ * \see Reader::buildSidecar()
+ */
+enum class Sidecar
+{
+    Ignore, //!< Never read the sidecar file.
+    Use,    //!< Read the sidecar file if it is valid for the `.erg` file.
+    Build   //!< Build the sidecar file in open() if it is missing or out of date.
+};
+
+/*!
+ * \brief Interpolation of the quantities on a time grid.
+ * \see Reader::resample()
+ */
+enum class Interpolation
+{
+    Nearest,    //!< Value of the nearest record.
+    Linear,     //!< Linear interpolation between the two enclosing records.
+    Previous    //!< Value of the last record at or before the time (zero-order hold).
+};
+
 /*!
  * \brief `ERG` version 2 header structure
  */
@@ -151,6 +202,104 @@ public:
     size_t offset;      //!< The offset in bytes from the start of the record.
 };
 
+class MappedFile;
+class InfoFile;
+class ColumnCache;
+class Chunks;
+
+/*!
+ * \brief Comparison operator of a Predicate.
+ */
+enum class Compare
+{
+    Less,           //!< `value < operand`
+    LessEqual,      //!< `value <= operand`
+    Greater,        //!< `value > operand`
+    GreaterEqual,   //!< `value >= operand`
+    Equal,          //!< `value == operand`
+    NotEqual        //!< `value != operand`
+};
+
+/*!
+ * \brief Condition on the value of a quantity in a filtered read.
+ *
+ * The values are converted to `double` before the comparison.
+ * \see Reader::where()
+ */
+struct Predicate
+{
+    size_t qindex;  //!< Index of the quantity
+    Compare op;     //!< Comparison operator
+    double operand; //!< Value compared with the quantity
+};
+
+/*!
+ * \brief Options of the statistics computed by Reader::stats().
+ */
+struct StatsOptions
+{
+    size_t bins = 0;    //!< Number of bins of the histogram, `0` for no histogram
+    double low = 0.0;   //!< Lower edge of the histogram
+    double high = 0.0;  //!< Upper edge of the histogram
+};
+
+/*!
+ * \brief Statistics of a quantity computed by Reader::stats().
+ *
+ * The NaN values are counted in `nans` and excluded from the other statistics.
+ * The statistics are NaN if there are no values.
+ */
+struct Stats
+{
+    size_t count;   //!< Number of values
+    size_t nans;    //!< Number of NaN values
+    double min;     //!< Minimum value
+    double max;     //!< Maximum value
+    double mean;    //!< Mean value
+    double stddev;  //!< Population standard deviation
+    double rms;     //!< Root mean square
+    std::vector<size_t> histogram;  //!< Values in each bin of `[low, high]`; the values outside are not counted
+};
+
+/*!
+ * \brief Statistics of the decoded column cache.
+ * \see Reader::setCacheSize()
+ */
+struct CacheStats
+{
+    size_t hits;        //!< Column reads served from the cache
+    size_t misses;      //!< Column reads served from the file
+    size_t evictions;   //!< Columns removed to stay within the budget
+    size_t bytes;       //!< Memory used by the cached columns
+    size_t columns;     //!< Number of cached columns
+};
+
+/*!
+ * \brief Description of a file returned by probe().
+ */
+struct ProbeInfo
+{
+    Format format;          //!< Format of the data file
+    ByteOrder byteOrder;    //!< Byte order of the data
+    size_t recordSize;      //!< Size in bytes of each record
+    size_t records;         //!< Number of complete records in the data file
+};
+
+/*!
+ * \brief Check if a file can be read without parsing the quantities.
+ *
+ * Only the first line of the companion file, its `File.Format` and
+ * `File.ByteOrder` keys and the header of the `.erg` file are read: the
+ * quantity definitions are not parsed, so the check is cheap also for
+ * files with many thousands of quantities. A file accepted by probe() can
+ * still fail in Reader::open() if its quantity definitions are inconsistent.
+ *
+ * \param filename Name of the `.erg` file.
+ * \return The format, the record size and the number of records of the file.
+ * \throws If a file can't be read or it is not a supported `ERG` file.
+ */
+ProbeInfo probe(const std::string& filename) noexcept(false);
+
 /*!
  * \brief Parser for version 1 and 2 `*.erg` files.
  *
@@ -168,6 +317,13 @@ public:
  * padding bytes at the end of the record, not between quantities. This will be
  * implemented later if needed.
  *
+ * The data read functions are `const` and can be called concurrently from many
+ * threads on the same Reader: they use positional reads or the mapped file and
+ * never change the state of the object. The quantities, the record size and the
+ * number of records do not change after open(); with the lazy open the first
+ * access that loads the quantities is serialized. open(), close() and the setters
+ * must not be called while a read is in progress.
+ *
  * \see header_t for the `ERG` version 2 header description.
  */
 class Reader
@@ -182,10 +338,11 @@ public:
     /*!
      * \brief Construct a new parser object and open the file
      * \param filename Name of the file to open.
+     * \param backend I/O backend used to read the data.
      * \throws If the file can't be read or the companion file is not found.
      * \see open().
      */
-    Reader(const std::string& filename) noexcept(false);
+    Reader(const std::string& filename, const Backend backend=Backend::Auto) noexcept(false);
 
     ~Reader();
 
@@ -195,10 +352,43 @@ public:
      * This function look for the `<filename>.info` in the same place of the
      * `.erg` file.
      *
+     * With Backend::Auto the data section is memory mapped when the platform
+     * supports it, and the records are transposed straight from the mapped pages;
+     * if the mapping fails the file is read through the stream.
+     *
      * \param filename Name of the `.erg` file to open.
+     * \param backend I/O backend used to read the data.
      * \throws If the file can't be read or the companion file is not found.
      */
-    void open(const std::string& filename)  noexcept(false);
+    void open(const std::string& filename, const Backend backend=Backend::Auto)  noexcept(false);
+
+    /*!
+     * \brief I/O backend selected when the file was opened.
+     *
+     * It is never Backend::Auto for an open file.
+     *
+     * \return The backend in use.
+     */
+    Backend backend() const noexcept(true) { return mBackend; }
+
+    /*!
+     * \brief Byte order of the data stored in the file.
+     * \return The byte order of the records.
+     */
+    ByteOrder byteOrder() const noexcept(true) { return mByteOrder; }
+
+    /*!
+     * \brief Records of the mapped file, without any copy.
+     *
+     * The value of the quantity `q` in the record `i` starts at
+     * `i*recordSize() + quantityOffset(q)` and it is stored with byteOrder().
+     * The returned pointer shares the ownership of the mapping, which stays
+     * valid after the file has been closed.
+     *
+     * \return The first record or `nullptr` if the file is not memory mapped.
+     * \see Backend::Mmap
+     */
+    std::shared_ptr<const uint8_t> mappedData() const noexcept(true);
 
     /*!
      * \brief Number of records/rows in th `.erg` file.
@@ -218,10 +408,24 @@ public:
      * \brief Number of quantities in the file
      *
      * The number of quantities is the number of columns that contains data in each record.
+     * After a lazy open whose quantities can't be parsed, the file has no
+     * quantities: load() throws the parsing error.
      *
      * \return Number of quantities.
      */
-    size_t numQuanities() const noexcept(true) { return mQuantities.size(); }
+    size_t numQuanities() const noexcept(true);
+
+    /*!
+     * \brief Parse the quantities now, if deferred by the lazy open.
+     *
+     * The error of a failed parsing is kept until the next open() and thrown
+     * again by each call, and by every accessor that can throw, without
+     * parsing the companion file again.
+     *
+     * \throws If the quantity definitions of the file are not valid.
+     * \see setLazyOpen()
+     */
+    void load() const noexcept(false);
 
     /*!
      * \brief Read all the datasets from the file.
@@ -233,7 +437,333 @@ public:
      * \return The number of rows that has been read.
      * \see quantitySize() to know the size of each quantity to preallocate memory.
      */
-    size_t readAll(std::vector<uint8_t*>& values, const std::vector<size_t>& sizes);
+    size_t readAll(std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const;
+
+    /*!
+     * \brief Set the number of threads used to read the data.
+     *
+     * Large reads are split in contiguous ranges of records that are read and
+     * transposed concurrently into disjoint slices of the destination memory.
+     *
+     * \param threads Number of threads, `0` to use all the hardware threads. Default is `1`.
+     */
+    void setThreads(const size_t threads) noexcept(true);
+
+    /*!
+     * \brief Number of threads used to read the data.
+     * \return The number of threads.
+     * \see setThreads()
+     */
+    size_t threads() const noexcept(true);
+
+    /*!
+     * \brief Set the expected access pattern to the data.
+     *
+     * The pattern is translated into `posix_fadvise()` and `madvise()` hints,
+     * or into `O_DIRECT` reads, where the platform supports them, and it is
+     * kept when another file is opened. Access::Direct unmaps the file; it
+     * falls back to Access::Once if the file system does not support `O_DIRECT`.
+     * Like open(), it must not be called while a read is in progress.
+     *
+     * \param access The access pattern. Default is Access::Normal.
+     */
+    void setAccess(const Access access) noexcept(true);
+
+    /*!
+     * \brief Access pattern to the data.
+     * \return The access pattern in use.
+     * \see setAccess()
+     */
+    Access access() const noexcept(true) { return mAccess; }
+
+    /*!
+     * \brief Set the memory budget of the decoded column cache.
+     *
+     * A read of the whole file, or of most of it, decodes the whole columns that
+     * fit the budget and keeps them in memory in host byte order. The following
+     * reads of any range of them, raw or typed, are served from the cache. The least
+     * recently used columns are evicted to stay within the budget. The cache is
+     * cleared by open(), close() and refresh().
+     *
+     * \param bytes Memory budget in bytes, `0` to disable the cache. Default is `0`.
+     */
+    void setCacheSize(const size_t bytes) noexcept(true);
+
+    /*!
+     * \brief Memory budget of the decoded column cache.
+     * \return The budget in bytes, `0` if the cache is disabled.
+     * \see setCacheSize()
+     */
+    size_t cacheSize() const noexcept(true);
+
+    /*!
+     * \brief Statistics of the decoded column cache.
+     *
+     * The hit and miss counters are kept when the cache is cleared.
+     *
+     * \return The cache statistics.
+     */
+    CacheStats cacheStats() const noexcept(true);
+
+    /*!
+     * \brief Set how the column-major sidecar file is used by open().
+     *
+     * The setting is used by the following open() calls.
+     *
+     * \param sidecar The sidecar policy. Default is Sidecar::Use.
+     */
+    void setSidecar(const Sidecar sidecar) noexcept(true) { mSidecar = sidecar; }
+
+    /*!
+     * \brief How the column-major sidecar file is used by open().
+     * \return The sidecar policy.
+     */
+    Sidecar sidecar() const noexcept(true) { return mSidecar; }
+
+    /*!
+     * \brief Defer the parsing of the quantities after open().
+     *
+     * With the lazy open, open() checks the companion file format and the
+     * `.erg` header, and the quantity table, the sidecar file and the indices
+     * are loaded by the first access to the quantities or to the data.
+     * The errors in the quantity definitions are then thrown by that access,
+     * and again by the following ones: see load().
+     * The setting is used by the following open() calls.
+     *
+     * \param lazy `true` to defer the parsing of the quantities. Default is `false`.
+     */
+    void setLazyOpen(const bool lazy) noexcept(true) { mLazyOpen = lazy; }
+
+    /*!
+     * \brief Check if open() defers the parsing of the quantities.
+     * \return `true` if the lazy open is enabled.
+     * \see setLazyOpen()
+     */
+    bool lazyOpen() const noexcept(true) { return mLazyOpen; }
+
+    /*!
+     * \brief Check if the reads are served by a sidecar file.
+     * \return `true` if a valid sidecar file is open.
+     */
+    bool hasSidecar() const noexcept(true) { return mColFd>=0; }
+
+    /*!
+     * \brief Name of the column-major sidecar file of an `.erg` file.
+     * \param filename Name of the `.erg` file.
+     * \return The name of the sidecar file.
+     */
+    static std::string sidecarFilename(const std::string& filename) noexcept(true) { return filename+".col"; }
+
+    /*!
+     * \brief Write the column-major sidecar file of the open file.
+     *
+     * The sidecar file stores each quantity as a contiguous array in host
+     * byte order, and the size, modification time, inode and header of the
+     * `.erg` file it has been built from. A valid sidecar file is used
+     * by open() to read the raw quantities with a single contiguous read each.
+     * The file is written in chunks of records, so the memory needed does not
+     * depend on the size of the file.
+     *
+     * \throws If the file is not open or the sidecar file can't be written.
+     */
+    void buildSidecar() noexcept(false);
+
+    /*!
+     * \brief Index of the first record at or after a time.
+     *
+     * The `Time` quantity is searched with a binary search that reads a single
+     * value for each step, so only O(log n) records are read: `Time` must be
+     * monotonic. When a valid time index is loaded the search uses it instead,
+     * and the result is the first record in file order at or after `time`
+     * also for non-monotonic or multi-segment files.
+     *
+     * \param time The time to search.
+     * \return The index of the record, records() if all the records are before `time`.
+     * \throws If the file has no `Time` quantity.
+     * \see buildTimeIndex()
+     */
+    size_t recordAt(const double time) const noexcept(false);
+
+    /*!
+     * \brief Range of the records in a time interval.
+     *
+     * The range starts at recordAt(t0) and ends before the first following
+     * record with a time outside `[t0, t1]`.
+     *
+     * \param t0 Start of the interval.
+     * \param t1 End of the interval, included.
+     * \param[out] from Index of the first record in the interval.
+     * \return Number of records in the interval.
+     * \throws If the file has no `Time` quantity.
+     */
+    size_t timeRange(const double t0, const double t1, size_t& from) const noexcept(false);
+
+    /*!
+     * \brief Read the records of a set of quantities in a time interval.
+     * \param qindices Indices of the quantities to read.
+     * \param t0 Start of the interval.
+     * \param t1 End of the interval, included.
+     * \param values Pointers to the destination data of each quantity.
+     * \param sizes Size of the memory allocated for each quantity.
+     * \return Number of records read.
+     * \throws If the file has no `Time` quantity, or on read errors.
+     * \see timeRange()
+     */
+    size_t readTimeRange(const std::vector<size_t>& qindices, const double t0, const double t1,
+                         std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const;
+
+    /*!
+     * \brief Number of points of a uniform time grid.
+     * \param t0 First time of the grid.
+     * \param t1 Last time of the grid, included if it is on the grid.
+     * \param dt Time step.
+     * \return The number of points `t0 + k*dt` in `[t0, t1]`.
+     */
+    static size_t gridSize(const double t0, const double t1, const double dt) noexcept(true);
+
+    /*!
+     * \brief Read a set of quantities resampled on a uniform time grid.
+     *
+     * The records are streamed in chunks from the one before `t0`, and
+     * interpolated against the `Time` quantity, which must be monotonic: the
+     * full rate quantities are never stored. The points before the first
+     * record and after the last one get the value of the first and of the
+     * last record.
+     *
+     * \param qindices Indices of the quantities to read.
+     * \param t0 First time of the grid.
+     * \param t1 Last time of the grid.
+     * \param dt Time step.
+     * \param method Interpolation method.
+     * \param values Destination of each quantity, with space for gridSize() values.
+     * \return Number of grid points written.
+     * \throws If the file has no `Time` quantity, `dt` is not positive, or on read errors.
+     */
+    size_t resample(const std::vector<size_t>& qindices, const double t0, const double t1, const double dt,
+                    const Interpolation method, std::vector<double*>& values) const noexcept(false);
+
+    /*!
+     * \brief Check if the time searches are served by a time index.
+     * \return `true` if a valid time index is loaded.
+     */
+    bool hasTimeIndex() const noexcept(true) { return mTimeBlock>0; }
+
+    /*!
+     * \brief Name of the time index file of an `.erg` file.
+     * \param filename Name of the `.erg` file.
+     * \return The name of the time index file.
+     */
+    static std::string timeIndexFilename(const std::string& filename) noexcept(true) { return filename+".tidx"; }
+
+    /*!
+     * \brief Write the sparse time index of the open file.
+     *
+     * The index stores the minimum and maximum `Time` of each block of
+     * records, and is validated against the `.erg` file like the sidecar
+     * file. A valid time index is loaded by open().
+     *
+     * \param blockRecords Number of records of each block.
+     * \throws If the file is not open, has no `Time` quantity or the index can't be written.
+     */
+    void buildTimeIndex(const size_t blockRecords = 4096) noexcept(false);
+
+    /*!
+     * \brief Indices of the records matching all the predicates.
+     *
+     * The records are scanned in blocks: when a zone map is loaded the blocks
+     * whose minimum and maximum can't match are skipped without reading them,
+     * and the blocks that match as a whole are not evaluated.
+     *
+     * \param predicates Conditions that must all be true. An empty list matches every record.
+     * \return The indices of the matching records in increasing order.
+     * \throws If a quantity index is out of range or on read errors.
+     * \see buildZoneMap()
+     */
+    std::vector<size_t> where(const std::vector<Predicate>& predicates) const noexcept(false);
+
+    /*!
+     * \brief Read the records matching all the predicates.
+     *
+     * Only the matching records are copied, so the output arrays have the
+     * size of the result.
+     *
+     * \param predicates Conditions that must all be true.
+     * \param qindices Indices of the quantities to read.
+     * \param[out] values Raw data of each quantity, resized to the matching records.
+     * \return Number of records read.
+     * \throws If a quantity index is out of range or on read errors.
+     * \see where()
+     */
+    size_t readWhere(const std::vector<Predicate>& predicates, const std::vector<size_t>& qindices,
+                     std::vector<std::vector<uint8_t>>& values) const noexcept(false);
+
+    /*!
+     * \brief Check if the filtered reads are served by a zone map.
+     * \return `true` if a valid zone map is loaded.
+     */
+    bool hasZoneMap() const noexcept(true) { return mZoneBlock>0; }
+
+    /*!
+     * \brief Name of the zone map file of an `.erg` file.
+     * \param filename Name of the `.erg` file.
+     * \return The name of the zone map file.
+     */
+    static std::string zoneMapFilename(const std::string& filename) noexcept(true) { return filename+".zmap"; }
+
+    /*!
+     * \brief Compute the zone map of the open file.
+     *
+     * The zone map stores the minimum and maximum of each quantity in each
+     * block of records, as `double`. The file is scanned once in chunks of
+     * records. A persisted zone map is validated against the `.erg` file like
+     * the sidecar file and loaded by open().
+     *
+     * \param blockRecords Number of records of each block.
+     * \param persist Write the zone map next to the `.erg` file.
+     * \throws If the file is not open or the zone map can't be written.
+     */
+    void buildZoneMap(const size_t blockRecords = 4096, const bool persist = true) noexcept(false);
+
+    /*!
+     * \brief Set the number of buffers read ahead of the transposition.
+     *
+     * With the stream backend a background thread loads the next blocks of
+     * records into a ring of buffers while the calling thread transposes the
+     * current one, so the I/O and the decoding overlap. With the memory
+     * mapped backend the kernel is asked to read the next block ahead.
+     *
+     * \param buffers Number of blocks loaded ahead, `0` to disable the pipeline. Default is `0`.
+     */
+    void setPrefetch(const size_t buffers) noexcept(true);
+
+    /*!
+     * \brief Number of buffers read ahead of the transposition.
+     * \return The number of buffers, `0` if the pipeline is disabled.
+     * \see setPrefetch()
+     */
+    size_t prefetch() const noexcept(true) { return mPrefetch; }
+
+    /*!
+     * \brief Read a range of records of a set of quantities in a background thread.
+     *
+     * The destination memory and the reader must stay valid until the read
+     * has completed.
+     *
+     * \param qindices Indices of the quantities to read.
+     * \param from Index of the first record to read.
+     * \param count Number of records to read.
+     * \param step Distance between two records.
+     * \param values Pointers to the destination data of each quantity.
+     * \param sizes Size of the memory allocated for each quantity.
+     * \param callback Optional function called in the background thread with the
+     * number of records read, when the read succeeds.
+     * \return Future with the number of records read. It rethrows the read errors.
+     * \see read()
+     */
+    std::future<size_t> readAsync(const std::vector<size_t>& qindices, const size_t from, const size_t count,
+                                  const size_t step, const std::vector<uint8_t*>& values,
+                                  const std::vector<size_t>& sizes,
+                                  const std::function<void(size_t)>& callback=nullptr) const;
 
     /*!
      * \brief Read a single dataset from the file
@@ -243,19 +773,197 @@ public:
      * \param size The size of the allocated memory
      * \return The number of records that has been read.
      */
-    size_t read(const size_t qindex, uint8_t* dst, const size_t size);
+    size_t read(const size_t qindex, uint8_t* dst, const size_t size) const;
 
     /*!
      * \brief Read a slice of single dataset from the file
      *
+     * The destination memory past the records that have been read is left untouched.
+     *
+     * \param qindex Index of the dataset to read
+     * \param from Index of the first record to read
+     * \param count Maximum number of records to read
+     * \param dst The pre-allocated destination memory
+     * \param size The size of the allocated memory
+     * \return The number of records that has been read.
+     */
+    size_t read(const size_t qindex, const size_t from, const size_t count, uint8_t* dst, const size_t size) const;
+
+    /*!
+     * \brief Read every `step` record of a slice of single dataset from the file
+     *
+     * The records `from`, `from+step`, `from+2*step`... are read. With large steps
+     * only the selected records are loaded from the file.
+     *
      * \param qindex Index of the dataset to read
      * \param from Index of the first record to read
      * \param count Maximum number of records to read
+     * \param step Distance between two read records, must be greater than zero
      * \param dst The pre-allocated destination memory
      * \param size The size of the allocated memory
      * \return The number of records that has been read.
+     * \see rangeSize() for the number of records that are read.
      */
-    size_t read(const size_t qindex, const size_t from, const size_t count, uint8_t* dst, const size_t size);
+    size_t read(const size_t qindex, const size_t from, const size_t count, const size_t step,
+                uint8_t* dst, const size_t size) const;
+
+    /*!
+     * \brief Read a slice of a set of datasets from the file in a single pass.
+     *
+     * The destination memory past the records that have been read is left untouched.
+     *
+     * \param qindices Indices of the datasets to read
+     * \param from Index of the first record to read
+     * \param count Maximum number of records to read
+     * \param values Vector of pointer to the destination data of each dataset in `qindices`.
+     * \param sizes Size of the memory allocated for each dataset.
+     * \return The number of records that has been read.
+     * \throws If a quantity index is out of range or not enough memory is allocated.
+     */
+    size_t read(const std::vector<size_t>& qindices, const size_t from, const size_t count,
+                std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const;
+
+    /*!
+     * \brief Read every `step` record of a slice of a set of datasets in a single pass.
+     *
+     * \param qindices Indices of the datasets to read
+     * \param from Index of the first record to read
+     * \param count Maximum number of records to read
+     * \param step Distance between two read records, must be greater than zero
+     * \param values Vector of pointer to the destination data of each dataset in `qindices`.
+     * \param sizes Size of the memory allocated for each dataset.
+     * \return The number of records that has been read.
+     * \throws If a quantity index is out of range, the step is zero or not enough memory is allocated.
+     */
+    size_t read(const std::vector<size_t>& qindices, const size_t from, const size_t count, const size_t step,
+                std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const;
+
+    /*!
+     * \brief Read a slice of a single dataset converted to type `T`.
+     *
+     * The conversion from the type stored in the file is performed while the
+     * records are transposed, without temporary copies of the data.
+     * `T` can be any of the fixed size integers, `float` or `double`.
+     * Floating point values converted to an integer type are saturated to
+     * its range, and nan is converted to zero.
+     *
+     * \param qindex Index of the dataset to read
+     * \param from Index of the first record to read
+     * \param count Maximum number of records to read
+     * \param dst The pre-allocated destination memory for rangeSize(from, count) elements
+     * \return The number of records that has been read.
+     * \throws If the quantity index is out of range.
+     */
+    template<typename T>
+    size_t read(const size_t qindex, const size_t from, const size_t count, T* dst) const;
+
+    /*!
+     * \brief Read every `step` record of a slice of a single dataset converted to type `T`.
+     *
+     * \param qindex Index of the dataset to read
+     * \param from Index of the first record to read
+     * \param count Maximum number of records to read
+     * \param step Distance between two read records, must be greater than zero
+     * \param dst The pre-allocated destination memory for rangeSize(from, count, step) elements
+     * \return The number of records that has been read.
+     * \throws If the quantity index is out of range or the step is zero.
+     * \see read(const size_t, const size_t, const size_t, T*) const
+     */
+    template<typename T>
+    size_t read(const size_t qindex, const size_t from, const size_t count, const size_t step, T* dst) const;
+
+    /*!
+     * \brief Read every `step` record of a slice of a set of datasets converted to type `T`.
+     *
+     * \param qindices Indices of the datasets to read
+     * \param from Index of the first record to read
+     * \param count Maximum number of records to read
+     * \param step Distance between two read records, must be greater than zero
+     * \param values Destination memory for rangeSize(from, count, step) elements of each dataset
+     * \return The number of records that has been read.
+     * \throws If a quantity index is out of range or the step is zero.
+     * \see read(const size_t, const size_t, const size_t, T*) const
+     */
+    template<typename T>
+    size_t read(const std::vector<size_t>& qindices, const size_t from, const size_t count, const size_t step,
+                std::vector<T*>& values) const;
+
+    /*!
+     * \brief Read all the datasets from the file converted to type `T`.
+     *
+     * \param values Destination memory for records() elements of each dataset.
+     * \return The number of rows that has been read.
+     * \see read(const size_t, const size_t, const size_t, T*) const
+     */
+    template<typename T>
+    size_t readAll(std::vector<T*>& values) const;
+
+    /*!
+     * \brief Read a slice of a set of datasets from the file in a single pass.
+     *
+     * \param qnames Names of the datasets to read
+     * \param from Index of the first record to read
+     * \param count Maximum number of records to read
+     * \param values Vector of pointer to the destination data of each dataset in `qnames`.
+     * \param sizes Size of the memory allocated for each dataset.
+     * \return The number of records that has been read.
+     * \throws If a quantity name is not found or not enough memory is allocated.
+     * \see read(const std::vector<size_t>&, const size_t, const size_t, std::vector<uint8_t*>&, const std::vector<size_t>&)
+     */
+    size_t read(const std::vector<std::string>& qnames, const size_t from, const size_t count,
+                std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const;
+
+    /*!
+     * \brief Number of records read by a range read.
+     * \param from Index of the first record
+     * \param count Maximum number of records
+     * \param step Distance between two records
+     * \return The number of records in the range that are inside the file.
+     */
+    size_t rangeSize(const size_t from, const size_t count, const size_t step=1) const noexcept(true);
+
+    /*!
+     * \brief Iterate over the file in chunks of records.
+     *
+     * Each chunk contains at most `chunkRows` records of the selected
+     * quantities, read in a single pass into buffers reused by all the chunks:
+     * the memory used does not depend on the size of the file.
+     *
+     * \param chunkRows Maximum number of records in each chunk.
+     * \param qindices Indices of the quantities to read, all the quantities if empty.
+     * \return The chunk iterator. The reader must outlive it.
+     * \throws If a quantity index is out of range or `chunkRows` is zero.
+     */
+    Chunks chunks(const size_t chunkRows, const std::vector<size_t>& qindices=std::vector<size_t>()) const noexcept(false);
+
+    /*!
+     * \brief Iterate over the file in chunks of records.
+     * \param chunkRows Maximum number of records in each chunk.
+     * \param qnames Names of the quantities to read.
+     * \return The chunk iterator. The reader must outlive it.
+     * \throws If a quantity name is not found in the file or `chunkRows` is zero.
+     * \see chunks()
+     */
+    Chunks chunks(const size_t chunkRows, const std::vector<std::string>& qnames) const noexcept(false);
+
+    /*!
+     * \brief Statistics of a range of records of a set of quantities.
+     *
+     * The records are read in blocks converted to `double` and reduced in a
+     * single pass, without storing the quantities: the memory used does not
+     * depend on the number of records. The mean and the variance of each block
+     * are merged with the parallel update of Chan et al., which is numerically
+     * stable. The range is split between threads().
+     *
+     * \param qindices Indices of the quantities.
+     * \param from Index of the first record.
+     * \param count Maximum number of records.
+     * \param options Histogram options.
+     * \return The statistics of each quantity.
+     * \throws If a quantity index is out of range, has no numeric type, or on read errors.
+     */
+    std::vector<Stats> stats(const std::vector<size_t>& qindices, const size_t from, const size_t count,
+                             const StatsOptions& options = StatsOptions()) const noexcept(false);
 
     /*!
      * \brief Size in bytes of the dataset at the current index.
@@ -267,9 +975,25 @@ public:
      */
     size_t quantitySize(const size_t qIndex) const noexcept(false)
     {
-        if (qIndex>=mQuantities.size())
+        const std::vector<Quantity>& qs = quantities();
+        if (qIndex>=qs.size())
+            throw std::runtime_error("The quantity with index "+std::to_string(qIndex)+" does not exists.");
+        return qs[qIndex].size * mRecordsCount;
+    }
+
+    /*!
+     * \brief Offset in bytes of the dataset from the start of each record.
+     * \param index Index of the dataset (column number in the record).
+     * \return Offset of the dataset inside the record.
+     * \throws If the quantity index is out of range.
+     * \see numQuanities()
+     */
+    size_t quantityOffset(const size_t qIndex) const noexcept(false)
+    {
+        const std::vector<Quantity>& qs = quantities();
+        if (qIndex>=qs.size())
             throw std::runtime_error("The quantity with index "+std::to_string(qIndex)+" does not exists.");
-        return mQuantities[qIndex].size * mRecordsCount;
+        return qs[qIndex].offset;
     }
 
     /*!
@@ -281,9 +1005,10 @@ public:
      */
     std::string quantityName(const size_t qIndex) const noexcept(false)
     {
-        if (qIndex>=mQuantities.size())
+        const std::vector<Quantity>& qs = quantities();
+        if (qIndex>=qs.size())
             throw std::runtime_error("The quantity with index "+std::to_string(qIndex)+" does not exists.");
-        return mQuantities[qIndex].name;
+        return qs[qIndex].name;
     }
 
     /*!
@@ -295,9 +1020,10 @@ public:
      */
     Type quantityType(const size_t qIndex) const noexcept(false)
     {
-        if (qIndex>=mQuantities.size())
+        const std::vector<Quantity>& qs = quantities();
+        if (qIndex>=qs.size())
             throw std::runtime_error("The quantity with index "+std::to_string(qIndex)+" does not exists.");
-        return mQuantities[qIndex].type;
+        return qs[qIndex].type;
     }
 
     /*!
@@ -309,9 +1035,10 @@ public:
      */
     std::string quantityUnit(const size_t qIndex) const noexcept(false)
     {
-        if (qIndex>=mQuantities.size())
+        const std::vector<Quantity>& qs = quantities();
+        if (qIndex>=qs.size())
             throw std::runtime_error("The quantity with index "+std::to_string(qIndex)+" does not exists.");
-        return mQuantities[qIndex].unit;
+        return qs[qIndex].unit;
     }
 
     /*!
@@ -322,6 +1049,17 @@ public:
      */
     size_t index(const std::string& qname) const noexcept(false);
 
+    /*!
+     * \brief Index of the quantity inside the data file, without exceptions.
+     *
+     * The names are looked up in a hash table built when the file is opened.
+     *
+     * \param qname Name of the quantity
+     * \return The index of the quantity, numQuanities() if the quantity is not found
+     *  or if the quantities of a lazy open can't be parsed.
+     */
+    size_t find(const std::string& qname) const noexcept(true);
+
     /*!
      * \brief Test if the quantity is present in the file.
      * \param qname Name of the quantity
@@ -329,11 +1067,74 @@ public:
      */
     bool has(const std::string& qname) const noexcept(true);
 
+    /*!
+     * \brief Quantities with the names that match a wildcard pattern.
+     *
+     * `*` matches any sequence of characters and `?` any single character,
+     * e.g. `Car.WheelSpd_*` or `Car.Tire??.Fx`.
+     *
+     * \param pattern The wildcard pattern.
+     * \return The indices of the matching quantities, in file order.
+     */
+    std::vector<size_t> select(const std::string& pattern) const noexcept(true);
+
+    /*!
+     * \brief Quantities with the names that match a regular expression.
+     * \param pattern The regular expression, which must match the whole name.
+     * \return The indices of the matching quantities, in file order.
+     */
+    std::vector<size_t> select(const std::regex& pattern) const noexcept(false);
+
     /*!
      * \brief Close the current file and clear the data.
      */
     void close() noexcept(true);
 
+    /*!
+     * \brief Update the number of records of a file that is still being written.
+     *
+     * Only the size of the file is checked, and the file is mapped again if it
+     * grew. A trailing partial record is ignored until it is complete. Like
+     * open(), it must not be called while a read is in progress.
+     *
+     * \return The number of records appended since the previous update.
+     * \throws If the file was opened with Backend::Mmap and can't be mapped again.
+     */
+    size_t refresh() noexcept(false);
+
+    /*!
+     * \brief Wait until records are appended to the file.
+     *
+     * The record count is not updated: call refresh() when the function
+     * returns `true`. On Linux the file is watched with inotify, on other
+     * platforms its size is polled. It can run concurrently with the reads.
+     *
+     * \param timeoutMs Maximum waiting time in milliseconds.
+     * \return `true` if the file contains new complete records.
+     */
+    bool waitForGrowth(const size_t timeoutMs) const noexcept(true);
+
+    /*!
+     * \brief Number of records not yet returned by readNew().
+     * \return The number of new records, up to the last refresh().
+     */
+    size_t newRecords() const noexcept(true) { return mRecordsCount>mFollowFrom ? mRecordsCount - mFollowFrom : 0; }
+
+    /*!
+     * \brief Read the records appended since the previous call.
+     *
+     * The first call returns all the records in the file. The memory for each
+     * quantity must hold newRecords() values.
+     *
+     * \param qindices Indices of the quantities to read.
+     * \param values Pointers to the destination data of each quantity.
+     * \param sizes Size of the memory allocated for each quantity.
+     * \return The number of records that has been read.
+     * \see refresh()
+     */
+    size_t readNew(const std::vector<size_t>& qindices, std::vector<uint8_t*>& values,
+                   const std::vector<size_t>& sizes) noexcept(false);
+
     /*!
      * \brief True if the format of the file is Erg (`erg`).
      * \return `true` if the file is an Erg (Erg v2).
@@ -370,18 +1171,94 @@ public:
      */
     static Type dataType(const char* typestr) noexcept(true);
 
+    /*!
+     * \brief String of a datatype in the companion file
+     * \param type The datatype
+     * \return The name of the type, as parsed by dataType()
+     * \throws If the datatype is Type::Void.
+     */
+    static std::string typeName(const Type type) noexcept(false);
+
 protected:
 
+    /*!
+     * \brief Kernel extracting a field from each record into a destination array.
+     * \param records The field in the first record
+     * \param stride Distance in bytes between two records
+     * \param rows Number of records
+     * \param dst Destination array
+     */
+    typedef void (*ConvertFunction)(const uint8_t* records, const size_t stride, const size_t rows, uint8_t* dst);
+
+    /*!
+     * \brief Destination of a quantity in a read.
+     */
+    struct Column
+    {
+        size_t qindex;              //!< Index of the quantity
+        size_t elementSize;         //!< Size in bytes of each destination element
+        ConvertFunction convert;    //!< Conversion kernel, `nullptr` to copy the raw bytes
+        ConvertFunction convertHost;    //!< Conversion kernel from host byte order values
+        uint8_t* dst;               //!< Destination memory
+    };
+
+    /*!
+     * \brief Column for a read of the raw data of a quantity.
+     */
+    Column rawColumn(const size_t qindex, uint8_t* dst) const noexcept(true);
+
+    /*!
+     * \brief Column for a read of a quantity converted to `T`.
+     */
+    template<typename T>
+    Column typedColumn(const size_t qindex, T* dst) const noexcept(false);
+
+    /*!
+     * \brief Conversion kernel from a stored type to `T`.
+     * \param type Type of the stored quantity
+     * \return The kernel, with the byte swap if `Swap` is true.
+     * \throws If the type is Type::Void.
+     */
+    template<typename T, bool Swap>
+    static ConvertFunction convertKernel(const Type type) noexcept(false);
+
     /*!
      * \brief Parse the `.erg.info` companion file
      *
-     * Open the companion file and parse it to load the definition
-     * of the quantities inside the data file.
+     * Parse the companion file loaded by open() to load the definition
+     * of the quantities inside the data file. The format, the byte order and
+     * the record size have already been read by open().
      *
      * \throws If the file can't be load and parsed.
      */
     void parseInfoFile() noexcept(false);
 
+    /*!
+     * \brief Build the hash table of the quantity names used by find().
+     */
+    void buildNameIndex() noexcept(false);
+
+    /*!
+     * \brief Quantities of the open file, loaded on the first call with the lazy open.
+     * \return The list of quantities.
+     * \throws If the companion file can't be parsed.
+     * \see setLazyOpen()
+     */
+    const std::vector<Quantity>& quantities() const noexcept(false);
+
+    /*!
+     * \brief Parse the quantities and open the sidecar file and the indices.
+     *
+     * On error the quantity table is left empty and the next access retries.
+     */
+    void loadQuantities() noexcept(false);
+
+    /*!
+     * \brief Parse the quantities if needed, without throwing the parsing error.
+     * \return `false` if the quantities can't be parsed.
+     */
+    bool quantitiesLoaded() const noexcept(true);
+
     /*!
      * \brief Parse a Fortran binary (Erg v1) file.
      */
@@ -416,16 +1293,363 @@ protected:
      */
     static void arrayBe2Host(uint8_t* data, const size_t elementSize, const size_t count) noexcept(true);
 
+    /*!
+     * \brief Load a block of records, every `step` records.
+     *
+     * With the memory mapped backend no data is copied and `records` points to
+     * the mapped pages; otherwise the records are read into `buffer`.
+     *
+     * \param from Index of the first record to load
+     * \param rows Maximum number of records to load
+     * \param step Distance between two loaded records
+     * \param buffer Memory used by the stream backend, aligned to `DIRECT_ALIGNMENT` and large enough
+     * for the span of the loaded records plus `DIRECT_ALIGNMENT` bytes
+     * \param records Set to the first loaded record
+     * \param stride Set to the distance in bytes between two loaded records
+     * \return The number of records loaded.
+     */
+    size_t loadRecords(const size_t from, const size_t rows, const size_t step, uint8_t* buffer,
+                       const uint8_t*& records, size_t& stride) const;
+
+    /*!
+     * \brief Read bytes at a given position of the `.erg` file.
+     *
+     * The read does not depend on the position of the stream, so it can be
+     * called concurrently from many threads.
+     *
+     * \param offset Offset in bytes from the start of the file
+     * \param buffer Destination memory
+     * \param size Number of bytes to read
+     * \return Number of bytes read.
+     */
+    size_t readAt(const size_t offset, uint8_t* buffer, const size_t size) const;
+
+    /*!
+     * \brief Read a range of records of a set of quantities in a single pass.
+     *
+     * The columns in the decoded column cache are copied or converted from it.
+     * If the range covers most of the file, the missing columns that fit the cache
+     * are decoded whole into it first; the others are read from the file. No bounds
+     * checks are performed.
+     *
+     * \param columns The quantities to read and their destination
+     * \param from Index of the first record to read
+     * \param count Maximum number of records to read
+     * \param step Distance between two read records
+     * \return The number of records that has been read.
+     */
+    size_t readColumns(const std::vector<Column>& columns, const size_t from, const size_t count,
+                       const size_t step) const;
+
+    /*!
+     * \brief Read all the records of a set of raw columns, from the sidecar file if available.
+     * \param columns The quantities to read and their destination, large enough for records() values
+     * \return `false` if the file is shorter than records().
+     */
+    bool loadWholeColumns(const std::vector<Column>& columns) const;
+
+    /*!
+     * \brief Copy or convert a range of a column of the decoded column cache.
+     * \param column The quantity and its destination
+     * \param cached The whole column, in host byte order
+     * \param from Index of the first record to copy
+     * \param rows Number of records to copy
+     * \param step Distance between two copied records
+     */
+    void copyCached(const Column& column, const std::vector<uint8_t>& cached, const size_t from,
+                    const size_t rows, const size_t step) const noexcept(true);
+
+    /*!
+     * \brief Read a range of records of a set of quantities from the file.
+     *
+     * The range is split among threads() workers. No bounds checks are performed.
+     *
+     * \see readColumns()
+     */
+    size_t readParallel(const std::vector<Column>& columns, const size_t from, const size_t count,
+                        const size_t step) const;
+
+    /*!
+     * \brief Open the sidecar file if it is valid for the open file.
+     * \return `true` if the sidecar file can be used.
+     */
+    bool openSidecar() noexcept(true);
+
+    /*!
+     * \brief Close the sidecar file.
+     */
+    void closeSidecar() noexcept(true);
+
+    /*!
+     * \brief Read a range of a raw column from the sidecar file.
+     * \param column The quantity and its destination.
+     * \param from Index of the first record to read.
+     * \param rows Number of records to read: they must be inside the file.
+     * \param step Distance between two read records.
+     * \return The number of records that has been read.
+     */
+    size_t readSidecar(const Column& column, const size_t from, const size_t rows, const size_t step) const;
+
+    /*!
+     * \brief Header describing the open file in its sidecar file.
+     * \return The sidecar header, without the data offsets.
+     */
+    std::vector<uint64_t> sidecarHeader() const noexcept(false);
+
+    /*!
+     * \brief Load the time index if it is valid for the open file.
+     * \return `true` if the time index can be used.
+     */
+    bool openTimeIndex() noexcept(true);
+
+    /*!
+     * \brief Header describing the open file in an index file.
+     * \param magic Identifier of the index file, at most 7 characters.
+     * \param version Version of the index file.
+     * \return The header: the sidecar header with the identifier and version of the index.
+     */
+    std::vector<uint64_t> indexHeader(const char* magic, const uint64_t version) const noexcept(false);
+
+    /*!
+     * \brief Load the zone map if it is valid for the open file.
+     * \return `true` if the zone map can be used.
+     */
+    bool openZoneMap() noexcept(true);
+
+    /*!
+     * \brief Scan the records matching all the predicates.
+     * \param predicates Conditions that must all be true.
+     * \param visit Called with the indices of the matching records of each
+     * range of records, in increasing order, if there is any.
+     */
+    void scanWhere(const std::vector<Predicate>& predicates,
+                   const std::function<void(const std::vector<size_t>&)>& visit) const noexcept(false);
+
+    /*!
+     * \brief Binary search of a time in a monotonic `Time` quantity.
+     * \param qindex Index of the `Time` quantity.
+     * \param from Index of the first record to search.
+     * \param time The time to search.
+     * \param after `true` for the first record after `time`, `false` for the first at or after `time`.
+     * \return The index of the record, records() if there is none.
+     */
+    size_t searchTime(const size_t qindex, const size_t from, const double time, const bool after) const noexcept(false);
+
+    /*!
+     * \brief Read the `Time` of a single record.
+     * \param qindex Index of the `Time` quantity.
+     * \param record Index of the record.
+     * \return The time of the record.
+     */
+    double timeAt(const size_t qindex, const size_t record) const noexcept(false);
+
+    /*!
+     * \brief Scan of the `Time` quantity that skips the blocks excluded by the time index.
+     * \param qindex Index of the `Time` quantity.
+     * \param from Index of the first record to check.
+     * \param t0 Start of the interval.
+     * \param t1 End of the interval, included.
+     * \param inside `true` for the first record inside `[t0, t1]`, `false` for the first outside.
+     * \return The index of the record, records() if there is none.
+     */
+    size_t scanTimeIndex(const size_t qindex, const size_t from, const double t0, const double t1,
+                         const bool inside) const noexcept(false);
+
+    /*!
+     * \brief Read a range of records of a set of quantities in the calling thread.
+     *
+     * The records are loaded in large blocks and transposed in tiles into the
+     * destination arrays. No bounds checks are performed.
+     *
+     * \see readColumns()
+     */
+    size_t readBlocks(const std::vector<Column>& columns, const size_t from, const size_t count,
+                      const size_t step) const;
+
+    /*!
+     * \brief Read a range of records with a background I/O thread.
+     *
+     * The I/O thread loads the blocks into a ring of prefetch() buffers while
+     * the calling thread transposes them.
+     *
+     * \see readBlocks()
+     */
+    size_t readPipelined(const std::vector<Column>& columns, const size_t from, const size_t count,
+                         const size_t step) const;
+
+    /*!
+     * \brief Transpose a block of records into the destination arrays.
+     * \param columns Destination of each quantity.
+     * \param records First record of the block.
+     * \param stride Distance in bytes between two records.
+     * \param rows Number of records in the block.
+     * \param offset Index of the first record in the destination arrays.
+     */
+    void decodeBlock(const std::vector<Column>& columns, const uint8_t* records, const size_t stride,
+                     const size_t rows, const size_t offset) const;
+
+    /*!
+     * \brief Memory map the open file.
+     * \return `true` if the file has been mapped.
+     */
+    bool mapFile() noexcept(true);
+
+    /*!
+     * \brief Current size of the open file.
+     * \return The size in bytes.
+     */
+    size_t currentFileSize() const noexcept(true);
+
+    /*!
+     * \brief Forward the access pattern to the kernel for the open file.
+     */
+    void applyAccess() noexcept(true);
+
+    /*!
+     * \brief Drop a range of the file from the page cache, for Access::Once.
+     * \param offset Offset of the range in the file.
+     * \param size Size of the range.
+     */
+    void dropCache(const size_t offset, const size_t size) const noexcept(true);
+
+    /*!
+     * \brief Read from the `O_DIRECT` descriptor.
+     *
+     * The whole pages are read in place if `buffer` has the same alignment as `offset`;
+     * the other bytes go through a bounce buffer reused by each thread.
+     * \see readAt()
+     */
+    size_t readDirect(const size_t offset, uint8_t* buffer, const size_t size) const;
+
+    /*!
+     * \brief Pointer to the first record in the mapped file.
+     * \return The first record or `nullptr` if the file is not mapped.
+     */
+    const uint8_t* mappedRecords() const noexcept(true);
+
 protected:
     std::string mFilename;  //!< Name of the open `.erg` file
-    std::ifstream mFile;    //!< Open `.erg` file
+    mutable std::ifstream mFile;    //!< Open `.erg` file
+    mutable std::mutex mFileMutex;  //!< Serialize the seek and read on mFile
+    int mFd;                //!< File descriptor for positional reads, `-1` if not available
+    size_t mThreads;        //!< Number of threads for the reads, `0` for all the hardware threads
+    size_t mPrefetch;       //!< Number of blocks read ahead, `0` to disable the pipeline
+    Access mAccess;         //!< Expected access pattern
+    int mDirectFd;          //!< `O_DIRECT` file descriptor for Access::Direct, `-1` if not used
+    Backend mBackend;       //!< I/O backend in use
+    Backend mOpenBackend;   //!< I/O backend requested in open()
+    std::shared_ptr<MappedFile> mMap;   //!< Mapped `.erg` file, if Backend::Mmap
+    std::shared_ptr<InfoFile> mInfo;    //!< Companion file, until the quantities are parsed
+    std::shared_ptr<ColumnCache> mCache;    //!< Decoded column cache
+    Sidecar mSidecar;       //!< Sidecar file policy
+    int mColFd;             //!< Descriptor of the sidecar file, `-1` if not used
+    std::vector<uint64_t> mColOffsets;  //!< Offset of each quantity in the sidecar file
+    size_t mTimeBlock;      //!< Records of each block of the time index, `0` if not loaded
+    std::vector<double> mTimeMin;   //!< Minimum `Time` of each block of the time index
+    std::vector<double> mTimeMax;   //!< Maximum `Time` of each block of the time index
+    size_t mZoneBlock;      //!< Records of each block of the zone map, `0` if not loaded
+    std::vector<double> mZoneMin;   //!< Minimum of each quantity in each block, by quantity
+    std::vector<double> mZoneMax;   //!< Maximum of each quantity in each block, by quantity
     size_t mFileSize;       //!< Size of the file
     size_t mRecordsCount;   //!< Number of records (rows)
+    size_t mFollowFrom;     //!< First record not yet returned by readNew()
     Format mFormat;
 
     size_t mRecordSize;     //!< Size in bytes of each record
     ByteOrder mByteOrder;   //!< Data byte order in the file
     std::vector<Quantity> mQuantities;  //!< List of quantities stored in the file
+    std::vector<uint32_t> mNameIndex;   //!< Open addressing table of the names: index+1 of a quantity, `0` if empty
+    bool mLazyOpen;         //!< Defer the parsing of the quantities after open()
+    mutable std::atomic<bool> mLoaded;  //!< The quantities have been parsed
+    bool mLoading;          //!< The quantities are being parsed, to not recurse into loadQuantities()
+    mutable std::recursive_mutex mLoadMutex;    //!< Serialize the lazy parsing of the quantities
+    std::exception_ptr mLoadError;  //!< Error of the lazy parsing of the quantities, thrown again by each access
+};
+
+
+/*!
+ * \brief Sequential reader of a file in chunks of records.
+ *
+ * Each call to next() reads the following chunk of records of the selected
+ * quantities into buffers owned by the object: the data of the previous chunk
+ * is overwritten.
+ *
+ * \code
+ * erg::Chunks chunks = reader.chunks(1000000, {"Time", "Vhcl.v"});
+ * while(chunks.next())
+ * {
+ *     const double* t = reinterpret_cast<const double*>(chunks.data(0));
+ *     // Process chunks.rows() values
+ * }
+ * \endcode
+ *
+ * \see Reader::chunks()
+ */
+class Chunks
+{
+public:
+    /*!
+     * \brief Construct the iterator and allocate the chunk buffers.
+     * \param reader The open reader. It must outlive the iterator.
+     * \param chunkRows Maximum number of records in each chunk.
+     * \param qindices Indices of the quantities to read.
+     * \throws If a quantity index is out of range or `chunkRows` is zero.
+     */
+    Chunks(const Reader& reader, const size_t chunkRows, const std::vector<size_t>& qindices) noexcept(false);
+
+    /*!
+     * \brief Read the next chunk.
+     * \return `false` if there are no more records.
+     * \throws If the read fails.
+     */
+    bool next() noexcept(false);
+
+    /*!
+     * \brief Restart from the first record of the file.
+     */
+    void rewind() noexcept(true);
+
+    /*!
+     * \brief Index of the first record in the current chunk.
+     * \return The index of the record.
+     */
+    size_t from() const noexcept(true) { return mFrom; }
+
+    /*!
+     * \brief Number of records in the current chunk.
+     * \return The number of records, `0` before the first next().
+     */
+    size_t rows() const noexcept(true) { return mRows; }
+
+    /*!
+     * \brief Indices of the quantities in each chunk.
+     * \return The quantity indices, in the same order of the data buffers.
+     */
+    const std::vector<size_t>& quantities() const noexcept(true) { return mQIndices; }
+
+    /*!
+     * \brief Data of a quantity in the current chunk.
+     * \param column Position of the quantity in quantities().
+     * \return The rows() values of the quantity, in the host byte order.
+     */
+    const uint8_t* data(const size_t column) const noexcept(true) { return mPointers[column]; }
+
+private:
+    /*!
+     * \brief Resize the chunk buffers.
+     * \param rows Number of records of each buffer.
+     */
+    void reserve(const size_t rows) noexcept(false);
+
+    const Reader* mReader;  //!< Reader of the file
+    size_t mChunkRows;      //!< Maximum number of records in each chunk
+    size_t mFrom;           //!< First record of the current chunk
+    size_t mRows;           //!< Number of records in the current chunk
+    size_t mCapacity;       //!< Number of records of the buffers
+    std::vector<size_t> mQIndices;  //!< Quantities to read
+    std::vector< std::vector<uint8_t> > mBuffers;   //!< Reused chunk buffers
+    std::vector<uint8_t*> mPointers;    //!< Data of each buffer
+    std::vector<size_t> mSizes;         //!< Size of each buffer
 };
 
 
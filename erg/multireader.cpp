@@ -0,0 +1,277 @@
+/**********************************************************************************
+ *   30/01/2015                                                                   *
+ *                                                                                *
+ *   www.henesis.eu                                                               *
+ *                                                                                *
+ *   Alessandro Bacchini - alessandro.bacchini@henesis.eu                         *
+ *                                                                                *
+ * Copyright (c) 2015, Henesis s.r.l. part of Camlin Group                        *
+ *                                                                                *
+ * The MIT License (MIT)                                                          *
+ *                                                                                *
+ * Permission is here by granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal  *
+ * in the Software without restriction, including without limitation the rights   *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ * copies of the Software, and to permit persons to whom the Software is          *
+ * furnished to do so, subject to the following conditions:                       *
+ *                                                                                *
+ * The above copyright notice and this permission notice shall be included in all *
+ * copies or substantial portions of the Software.                                *
+ *                                                                                *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ * SOFTWARE.                                                                      *
+ *********************************************************************************/
+
+#include "multireader.h"
+
+#include <algorithm>
+
+
+namespace erg
+{
+
+MultiReader::MultiReader(const std::vector<std::string>& filenames, const std::vector<std::string>& columns,
+                         const size_t workers, const size_t chunkRows) noexcept(false)
+    : mColumns(columns), mChunkRows(chunkRows), mTasks(0), mQueued(0), mStop(false), mReturned(0)
+{
+    if(chunkRows==0)
+        throw std::runtime_error("The chunk must contain at least one record.");
+
+    for(size_t i=0; i<filenames.size(); ++i)
+    {
+        std::unique_ptr<File> file(new File());
+        file->pending = 0;
+        file->result.index = i;
+        file->result.filename = filenames[i];
+        file->result.records = 0;
+        mFiles.push_back(std::move(file));
+    }
+
+    const size_t threads = std::max<size_t>(1, workers>0 ? workers : std::thread::hardware_concurrency());
+    mQueues.resize(threads);
+    for(size_t w=0; w<threads; ++w)
+        mQueueMutexes.push_back(std::unique_ptr<std::mutex>(new std::mutex()));
+
+    // The files are dealt to the threads, which steal them from each other when they run out
+    for(size_t i=0; i<mFiles.size(); ++i)
+        push(i % threads, Task{i, 0, 0});
+
+    try {
+        for(size_t w=0; w<threads; ++w)
+            mThreads.push_back(std::thread(&MultiReader::run, this, w));
+    } catch(...) {
+        // The destructor doesn't run: stop the threads already started
+        mStop = true;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mWork.notify_all();
+        }
+        for(std::thread& t: mThreads)
+            t.join();
+        throw;
+    }
+}
+
+MultiReader::~MultiReader() noexcept(true)
+{
+    mStop = true;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mWork.notify_all();
+    }
+    for(std::thread& t: mThreads)
+        t.join();
+}
+
+bool MultiReader::next(FileResult& result) noexcept(false)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if(mReturned==mFiles.size())
+        return false;
+    mDone.wait(lock, [this]{ return !mCompleted.empty(); });
+    const size_t file = mCompleted.front();
+    mCompleted.pop_front();
+    ++mReturned;
+    lock.unlock();
+
+    result = std::move(mFiles[file]->result);
+    mFiles[file].reset();
+    return true;
+}
+
+void MultiReader::run(const size_t worker) noexcept(true)
+{
+    while(!mStop)
+    {
+        Task task;
+        if(take(worker, task)) {
+            if(task.rows==0)
+                openFile(worker, task.file);
+            else
+                readChunk(task);
+
+            if(--mTasks==0) {
+                // Every file is complete: wake up the idle threads to let them exit
+                std::lock_guard<std::mutex> lock(mMutex);
+                mWork.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        // New tasks are queued only by running tasks, which notify them under the lock
+        mWork.wait(lock, [this]{ return mStop || mTasks==0 || mQueued>0; });
+        if(mTasks==0)
+            return;
+    }
+}
+
+bool MultiReader::take(const size_t worker, Task& task) noexcept(true)
+{
+    // The newest task of the thread, which continues the file it has opened
+    {
+        std::lock_guard<std::mutex> lock(*mQueueMutexes[worker]);
+        if(!mQueues[worker].empty()) {
+            task = mQueues[worker].back();
+            mQueues[worker].pop_back();
+            --mQueued;
+            return true;
+        }
+    }
+
+    // The oldest task of another thread
+    for(size_t i=1; i<mQueues.size(); ++i)
+    {
+        const size_t victim = (worker + i) % mQueues.size();
+        std::lock_guard<std::mutex> lock(*mQueueMutexes[victim]);
+        if(!mQueues[victim].empty()) {
+            task = mQueues[victim].front();
+            mQueues[victim].pop_front();
+            --mQueued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MultiReader::push(const size_t worker, const Task& task) noexcept(false)
+{
+    ++mTasks;
+    try {
+        std::lock_guard<std::mutex> lock(*mQueueMutexes[worker]);
+        mQueues[worker].push_back(task);
+        ++mQueued;
+    } catch(...) {
+        --mTasks;
+        throw;
+    }
+
+    // Under the lock: an idle thread checks the queued tasks before it waits
+    std::lock_guard<std::mutex> lock(mMutex);
+    mWork.notify_one();
+}
+
+void MultiReader::openFile(const size_t worker, const size_t file) noexcept(true)
+{
+    File& f = *mFiles[file];
+    FileResult& result = f.result;
+    size_t chunks = 0;
+    try {
+        f.reader.reset(new Reader());
+        // The pool already runs a read on each thread
+        f.reader->setThreads(1);
+        f.reader->open(result.filename);
+
+        if(mColumns.empty()) {
+            for(size_t i=0; i<f.reader->numQuanities(); ++i)
+                f.qindices.push_back(i);
+        } else {
+            for(const std::string& name: mColumns)
+                f.qindices.push_back(f.reader->index(name));
+        }
+
+        result.records = f.reader->records();
+        for(size_t qindex: f.qindices)
+        {
+            result.names.push_back(f.reader->quantityName(qindex));
+            result.types.push_back(f.reader->quantityType(qindex));
+            result.data.push_back(std::vector<uint8_t>(f.reader->quantitySize(qindex)));
+        }
+        chunks = (result.records + mChunkRows - 1) / mChunkRows;
+    } catch(std::exception& e) {
+        result.error = e.what();
+        chunks = 0;
+    }
+
+    if(chunks==0) {
+        complete(file);
+        return;
+    }
+
+    f.pending = chunks;
+    size_t queued = 0;
+    try {
+        for(; queued<chunks; ++queued)
+        {
+            const size_t from = queued * mChunkRows;
+            push(worker, Task{file, from, std::min(mChunkRows, result.records - from)});
+        }
+    } catch(std::exception& e) {
+        {
+            std::lock_guard<std::mutex> lock(f.errorMutex);
+            if(result.error.empty())
+                result.error = e.what();
+        }
+        // The chunks that were not queued are never read
+        if((f.pending -= chunks - queued)==0)
+            complete(file);
+    }
+}
+
+void MultiReader::readChunk(const Task& task) noexcept(true)
+{
+    File& f = *mFiles[task.file];
+    FileResult& result = f.result;
+    try {
+        std::vector<uint8_t*> values;
+        std::vector<size_t> sizes;
+        for(std::vector<uint8_t>& data: result.data)
+        {
+            const size_t size = data.size() / result.records;
+            values.push_back(data.data() + task.from * size);
+            sizes.push_back(task.rows * size);
+        }
+        if(f.reader->read(f.qindices, task.from, task.rows, 1, values, sizes)<task.rows)
+            throw std::runtime_error("Can't read the records "+std::to_string(task.from)+" to "+
+                                     std::to_string(task.from + task.rows)+".");
+    } catch(std::exception& e) {
+        std::lock_guard<std::mutex> lock(f.errorMutex);
+        if(result.error.empty())
+            result.error = e.what();
+    }
+
+    if(--f.pending==0)
+        complete(task.file);
+}
+
+void MultiReader::complete(const size_t file) noexcept(true)
+{
+    File& f = *mFiles[file];
+    f.reader.reset();
+    if(!f.result.error.empty()) {
+        f.result.records = 0;
+        f.result.data.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCompleted.push_back(file);
+    mDone.notify_all();
+}
+
+}
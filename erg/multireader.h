@@ -0,0 +1,193 @@
+/**********************************************************************************
+ *   30/01/2015                                                                   *
+ *                                                                                *
+ *   www.henesis.eu                                                               *
+ *                                                                                *
+ *   Alessandro Bacchini - alessandro.bacchini@henesis.eu                         *
+ *                                                                                *
+ * Copyright (c) 2015, Henesis s.r.l. part of Camlin Group                        *
+ *                                                                                *
+ * The MIT License (MIT)                                                          *
+ *                                                                                *
+ * Permission is here by granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal  *
+ * in the Software without restriction, including without limitation the rights   *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ * copies of the Software, and to permit persons to whom the Software is          *
+ * furnished to do so, subject to the following conditions:                       *
+ *                                                                                *
+ * The above copyright notice and this permission notice shall be included in all *
+ * copies or substantial portions of the Software.                                *
+ *                                                                                *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ * SOFTWARE.                                                                      *
+ *********************************************************************************/
+
+#ifndef ERGMULTIREADER_H
+#define ERGMULTIREADER_H
+
+#include "erg.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+
+namespace erg
+{
+
+/*!
+ * \brief Data of a file read by a MultiReader.
+ */
+struct FileResult
+{
+    size_t index;           //!< Index of the file in the batch
+    std::string filename;   //!< Name of the file
+    size_t records;         //!< Number of records read
+    std::vector<std::string> names;     //!< Names of the quantities
+    std::vector<Type> types;            //!< Types of the quantities
+    std::vector< std::vector<uint8_t> > data;   //!< Raw data of each quantity
+    std::string error;      //!< Error message, empty if the file has been read
+};
+
+/*!
+ * \brief Concurrent reader of a batch of files.
+ *
+ * A pool of threads opens and reads the files. Each thread has a queue of
+ * tasks: when it is empty the thread steals the oldest task of another
+ * thread. The files larger than a chunk are split in tasks of `chunkRows`
+ * records, so a large file is read by all the threads instead of delaying the
+ * end of the batch. The results are returned by next() as soon as each file
+ * is complete, in completion order.
+ *
+ * \code
+ * erg::MultiReader batch(filenames, {"Time", "Vhcl.v"});
+ * erg::FileResult result;
+ * while(batch.next(result))
+ * {
+ *     if(result.error.empty())
+ *         process(result);
+ * }
+ * \endcode
+ */
+class MultiReader
+{
+public:
+    /*!
+     * \brief Start reading a batch of files.
+     * \param filenames Names of the `.erg` files.
+     * \param columns Names of the quantities to read, all the quantities of each file if empty.
+     * \param workers Number of threads, `0` for all the hardware threads.
+     * \param chunkRows Maximum number of records read by each task.
+     * \throws If `chunkRows` is zero.
+     */
+    MultiReader(const std::vector<std::string>& filenames,
+                const std::vector<std::string>& columns=std::vector<std::string>(),
+                const size_t workers=0, const size_t chunkRows=262144) noexcept(false);
+
+    /*!
+     * \brief Stop the threads. The files not yet read are discarded.
+     */
+    ~MultiReader() noexcept(true);
+
+    MultiReader(const MultiReader&) = delete;
+    MultiReader& operator=(const MultiReader&) = delete;
+
+    /*!
+     * \brief Wait for the next completed file.
+     *
+     * A file that can't be opened or read is returned with an error message.
+     *
+     * \param[out] result The data of the file.
+     * \return `false` when all the files have been returned.
+     */
+    bool next(FileResult& result) noexcept(false);
+
+    /*!
+     * \brief Number of files in the batch.
+     */
+    size_t size() const noexcept(true) { return mFiles.size(); }
+
+    /*!
+     * \brief Number of threads of the pool.
+     */
+    size_t workers() const noexcept(true) { return mThreads.size(); }
+
+protected:
+    //! Open or read a range of records of a file. A task with no records opens the file.
+    struct Task
+    {
+        size_t file;    //!< Index of the file
+        size_t from;    //!< First record
+        size_t rows;    //!< Number of records, `0` to open the file
+    };
+
+    //! State of a file being read.
+    struct File
+    {
+        std::unique_ptr<Reader> reader;
+        std::vector<size_t> qindices;
+        std::atomic<size_t> pending;    //!< Read tasks not yet completed
+        std::mutex errorMutex;          //!< Serialize the updates of result.error
+        FileResult result;
+    };
+
+    /*!
+     * \brief Loop of a thread of the pool.
+     * \param worker Index of the thread.
+     */
+    void run(const size_t worker) noexcept(true);
+
+    /*!
+     * \brief Take the next task of a thread, or steal one from the other threads.
+     * \param worker Index of the thread.
+     * \param[out] task The task.
+     * \return `false` if all the queues are empty.
+     */
+    bool take(const size_t worker, Task& task) noexcept(true);
+
+    /*!
+     * \brief Add a task to the queue of a thread.
+     */
+    void push(const size_t worker, const Task& task) noexcept(false);
+
+    /*!
+     * \brief Open a file and queue its read tasks.
+     */
+    void openFile(const size_t worker, const size_t file) noexcept(true);
+
+    /*!
+     * \brief Read a range of records of a file.
+     */
+    void readChunk(const Task& task) noexcept(true);
+
+    /*!
+     * \brief Release the reader of a completed file and hand its result to next().
+     */
+    void complete(const size_t file) noexcept(true);
+
+    std::vector<std::string> mColumns;  //!< Names of the quantities to read
+    size_t mChunkRows;                  //!< Maximum number of records of each task
+    std::vector< std::unique_ptr<File> > mFiles;    //!< Files of the batch, released by next()
+    std::vector< std::deque<Task> > mQueues;        //!< Task queue of each thread
+    std::vector< std::unique_ptr<std::mutex> > mQueueMutexes;   //!< Lock of each queue
+    std::atomic<size_t> mTasks;         //!< Tasks queued or running
+    std::atomic<size_t> mQueued;        //!< Tasks queued and not yet taken
+    std::atomic<bool> mStop;            //!< Stop the threads
+    std::mutex mMutex;                  //!< Lock of the completed files and of the idle threads
+    std::condition_variable mWork;      //!< Signaled when tasks are queued or the batch ends
+    std::condition_variable mDone;      //!< Signaled when a file is completed
+    std::deque<size_t> mCompleted;      //!< Completed files not yet returned by next()
+    size_t mReturned;                   //!< Files returned by next()
+    std::vector<std::thread> mThreads;  //!< Thread pool
+};
+
+}
+
+#endif // ERGMULTIREADER_H
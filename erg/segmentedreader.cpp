@@ -0,0 +1,378 @@
+/**********************************************************************************
+ *   30/01/2015                                                                   *
+ *                                                                                *
+ *   www.henesis.eu                                                               *
+ *                                                                                *
+ *   Alessandro Bacchini - alessandro.bacchini@henesis.eu                         *
+ *                                                                                *
+ * Copyright (c) 2015, Henesis s.r.l. part of Camlin Group                        *
+ *                                                                                *
+ * The MIT License (MIT)                                                          *
+ *                                                                                *
+ * Permission is here by granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal  *
+ * in the Software without restriction, including without limitation the rights   *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ * copies of the Software, and to permit persons to whom the Software is          *
+ * furnished to do so, subject to the following conditions:                       *
+ *                                                                                *
+ * The above copyright notice and this permission notice shall be included in all *
+ * copies or substantial portions of the Software.                                *
+ *                                                                                *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ * SOFTWARE.                                                                      *
+ *********************************************************************************/
+
+#include "segmentedreader.h"
+
+#include <atomic>
+#include <thread>
+
+
+namespace erg
+{
+
+SegmentedReader::SegmentedReader() noexcept(true)
+    : mRecordsCount(0), mThreads(1)
+{
+}
+
+SegmentedReader::SegmentedReader(const std::vector<std::string>& filenames) noexcept(false)
+    : SegmentedReader()
+{
+    open(filenames);
+}
+
+void SegmentedReader::open(const std::vector<std::string>& filenames, const Backend backend) noexcept(false)
+{
+    close();
+    if(filenames.empty())
+        throw std::runtime_error("A segmented dataset needs at least one file.");
+
+    try {
+        for(const std::string& filename: filenames)
+        {
+            // The reader checks the headers of each segment
+            std::unique_ptr<Reader> segment(new Reader());
+            segment->open(filename, backend);
+
+            if(!mSegments.empty()) {
+                const Reader& first = *mSegments.front();
+                if(segment->byteOrder()!=first.byteOrder())
+                    throw std::runtime_error("The byte order of "+filename+" differs from the first segment.");
+                if(segment->numQuanities()!=first.numQuanities() || segment->recordSize()!=first.recordSize())
+                    throw std::runtime_error("The records of "+filename+" differ from the first segment.");
+                for(size_t q=0; q<first.numQuanities(); ++q)
+                {
+                    if(segment->quantityName(q)!=first.quantityName(q) ||
+                       segment->quantityType(q)!=first.quantityType(q) ||
+                       segment->quantityOffset(q)!=first.quantityOffset(q))
+                        throw std::runtime_error("The quantity "+first.quantityName(q)+" of "+filename+
+                                                 " differs from the first segment.");
+                }
+            }
+
+            mStarts.push_back(mRecordsCount);
+            mRecordsCount += segment->records();
+            mSegments.push_back(std::move(segment));
+        }
+
+        for(size_t q=0; q<numQuanities(); ++q)
+            mElementSizes.push_back(Reader::dataSize(quantityType(q)));
+    } catch(...) {
+        close();
+        throw;
+    }
+}
+
+void SegmentedReader::close() noexcept(true)
+{
+    mSegments.clear();
+    mStarts.clear();
+    mElementSizes.clear();
+    mRecordsCount = 0;
+}
+
+const Reader& SegmentedReader::segment(const size_t s) const noexcept(false)
+{
+    if(s>=mSegments.size())
+        throw std::runtime_error("The segment with index "+std::to_string(s)+" does not exists.");
+    return *mSegments[s];
+}
+
+size_t SegmentedReader::segmentStart(const size_t s) const noexcept(false)
+{
+    if(s>=mSegments.size())
+        throw std::runtime_error("The segment with index "+std::to_string(s)+" does not exists.");
+    return mStarts[s];
+}
+
+size_t SegmentedReader::locate(const size_t record, size_t& local) const noexcept(false)
+{
+    if(record>=mRecordsCount)
+        throw std::runtime_error("The record "+std::to_string(record)+" is out of range.");
+
+    // The last segment that starts at or before the record: empty segments are skipped
+    const size_t s = std::upper_bound(mStarts.begin(), mStarts.end(), record) - mStarts.begin() - 1;
+    local = record - mStarts[s];
+    return s;
+}
+
+size_t SegmentedReader::numQuanities() const noexcept(true)
+{
+    return mSegments.empty() ? 0 : mSegments.front()->numQuanities();
+}
+
+size_t SegmentedReader::quantitySize(const size_t qIndex) const noexcept(false)
+{
+    if (qIndex>=mElementSizes.size())
+        throw std::runtime_error("The quantity with index "+std::to_string(qIndex)+" does not exists.");
+    return mElementSizes[qIndex] * mRecordsCount;
+}
+
+std::string SegmentedReader::quantityName(const size_t qIndex) const noexcept(false)
+{
+    return segment(0).quantityName(qIndex);
+}
+
+Type SegmentedReader::quantityType(const size_t qIndex) const noexcept(false)
+{
+    return segment(0).quantityType(qIndex);
+}
+
+std::string SegmentedReader::quantityUnit(const size_t qIndex) const noexcept(false)
+{
+    return segment(0).quantityUnit(qIndex);
+}
+
+size_t SegmentedReader::index(const std::string& qname) const noexcept(false)
+{
+    return segment(0).index(qname);
+}
+
+bool SegmentedReader::has(const std::string& qname) const noexcept(true)
+{
+    return !mSegments.empty() && mSegments.front()->has(qname);
+}
+
+void SegmentedReader::setThreads(const size_t threads) noexcept(true)
+{
+    mThreads = threads;
+}
+
+size_t SegmentedReader::threads() const noexcept(true)
+{
+    if(mThreads>0)
+        return mThreads;
+    return std::max<unsigned>(1, std::thread::hardware_concurrency());
+}
+
+size_t SegmentedReader::rangeSize(const size_t from, const size_t count, const size_t step) const noexcept(true)
+{
+    if(from>=mRecordsCount || step==0)
+        return 0;
+    return std::min(count, (mRecordsCount - from + step - 1) / step);
+}
+
+std::vector<SegmentedReader::Part> SegmentedReader::split(const size_t from, const size_t count,
+                                                          const size_t step) const noexcept(true)
+{
+    std::vector<Part> parts;
+    const size_t rows = rangeSize(from, count, step);
+    if(rows==0)
+        return parts;
+
+    const size_t last = from + (rows - 1) * step;
+    for(size_t s=0; s<mSegments.size(); ++s)
+    {
+        const size_t start = mStarts[s];
+        const size_t end = start + mSegments[s]->records();
+        if(end<=from || start>last)
+            continue;
+
+        // First selected record inside the segment
+        const size_t first = start<=from ? from : from + (start - from + step - 1) / step * step;
+        if(first>=end || first>last)
+            continue;
+
+        const size_t offset = (first - from) / step;
+        const size_t segmentRows = std::min((end - first + step - 1) / step, rows - offset);
+        parts.push_back(Part{s, first - start, segmentRows, offset});
+    }
+    return parts;
+}
+
+size_t SegmentedReader::readParts(const std::vector<Part>& parts, const std::function<size_t(const Part&)>& read) const
+{
+    std::vector<size_t> readRows(parts.size(), 0);
+    std::vector<std::exception_ptr> errors(parts.size());
+    std::atomic<size_t> next(0);
+
+    // Each thread takes the next segment to read
+    auto worker = [&]()
+    {
+        for(size_t p=next++; p<parts.size(); p=next++)
+        {
+            try {
+                readRows[p] = read(parts[p]);
+            } catch(...) {
+                errors[p] = std::current_exception();
+            }
+        }
+    };
+
+    const size_t workers = std::min(threads(), parts.size());
+    std::vector<std::thread> pool;
+    try {
+        for(size_t w=1; w<workers; ++w)
+            pool.push_back(std::thread(worker));
+    } catch(...) {
+        // Joinable threads can't be destroyed: wait for the ones already started
+        for(std::thread& t: pool)
+            t.join();
+        throw;
+    }
+    worker();
+    for(std::thread& t: pool)
+        t.join();
+
+    for(std::exception_ptr& e: errors) {
+        if(e)
+            std::rethrow_exception(e);
+    }
+
+    // Count only the records read without gaps from the first one
+    size_t total = 0;
+    for(size_t p=0; p<parts.size(); ++p)
+    {
+        total += readRows[p];
+        if(readRows[p]<parts[p].rows)
+            break;
+    }
+    return total;
+}
+
+size_t SegmentedReader::read(const std::vector<size_t>& qindices, const size_t from, const size_t count, const size_t step,
+                             std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const
+{
+    if(values.size()!=qindices.size() || sizes.size()!=qindices.size())
+        throw std::runtime_error("Wrong input size");
+
+    if(step==0)
+        throw std::runtime_error("The step must be greater than zero.");
+
+    const size_t rows = rangeSize(from, count, step);
+    for(size_t i=0; i<qindices.size(); ++i)
+    {
+        if(qindices[i]>=mElementSizes.size())
+            throw std::runtime_error("Index "+std::to_string(qindices[i])+" is out of bounds.");
+
+        const size_t expectedSize = mElementSizes[qindices[i]] * rows;
+        if(expectedSize>sizes[i])
+            throw std::runtime_error("Not enough data allocated for dataset "+quantityName(qindices[i])+\
+                                     ": "+std::to_string(sizes[i])+" instead of "+\
+                                     std::to_string(expectedSize)+" bytes.");
+    }
+
+    return readParts(split(from, count, step), [&](const Part& part)
+    {
+        std::vector<uint8_t*> partValues(qindices.size());
+        std::vector<size_t> partSizes(qindices.size());
+        for(size_t i=0; i<qindices.size(); ++i)
+        {
+            const size_t elementSize = mElementSizes[qindices[i]];
+            partValues[i] = values[i] + part.offset * elementSize;
+            partSizes[i] = part.rows * elementSize;
+        }
+        return mSegments[part.segment]->read(qindices, part.from, part.rows, step, partValues, partSizes);
+    });
+}
+
+size_t SegmentedReader::read(const std::vector<size_t>& qindices, const size_t from, const size_t count,
+                             std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const
+{
+    return read(qindices, from, count, 1, values, sizes);
+}
+
+size_t SegmentedReader::read(const size_t qindex, const size_t from, const size_t count, uint8_t* dst,
+                             const size_t size) const
+{
+    std::vector<uint8_t*> values(1, dst);
+    return read({qindex}, from, count, 1, values, {size});
+}
+
+size_t SegmentedReader::readAll(std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const
+{
+    if(values.size()!=numQuanities())
+        throw std::runtime_error("Wrong input size");
+
+    std::vector<size_t> qindices(values.size());
+    for(size_t ds=0; ds<qindices.size(); ++ds)
+        qindices[ds] = ds;
+
+    return read(qindices, 0, mRecordsCount, 1, values, sizes);
+}
+
+template<typename T>
+size_t SegmentedReader::read(const std::vector<size_t>& qindices, const size_t from, const size_t count, const size_t step,
+                             std::vector<T*>& values) const
+{
+    if(values.size()!=qindices.size())
+        throw std::runtime_error("Wrong input size");
+
+    if(step==0)
+        throw std::runtime_error("The step must be greater than zero.");
+
+    return readParts(split(from, count, step), [&](const Part& part)
+    {
+        std::vector<T*> partValues(values.size());
+        for(size_t i=0; i<values.size(); ++i)
+            partValues[i] = values[i] + part.offset;
+        return mSegments[part.segment]->read<T>(qindices, part.from, part.rows, step, partValues);
+    });
+}
+
+template<typename T>
+size_t SegmentedReader::read(const size_t qindex, const size_t from, const size_t count, T* dst) const
+{
+    std::vector<T*> values(1, dst);
+    return read<T>({qindex}, from, count, 1, values);
+}
+
+template<typename T>
+size_t SegmentedReader::readAll(std::vector<T*>& values) const
+{
+    if(values.size()!=numQuanities())
+        throw std::runtime_error("Wrong input size");
+
+    std::vector<size_t> qindices(values.size());
+    for(size_t ds=0; ds<qindices.size(); ++ds)
+        qindices[ds] = ds;
+
+    return read<T>(qindices, 0, mRecordsCount, 1, values);
+}
+
+// Typed reads are available for all the ERG datatypes.
+#define ERG_INSTANTIATE_SEGMENTED_READ(T) \
+    template size_t SegmentedReader::read<T>(const size_t, const size_t, const size_t, T*) const; \
+    template size_t SegmentedReader::read<T>(const std::vector<size_t>&, const size_t, const size_t, const size_t, \
+                                             std::vector<T*>&) const; \
+    template size_t SegmentedReader::readAll<T>(std::vector<T*>&) const;
+
+ERG_INSTANTIATE_SEGMENTED_READ(int8_t)
+ERG_INSTANTIATE_SEGMENTED_READ(int16_t)
+ERG_INSTANTIATE_SEGMENTED_READ(int32_t)
+ERG_INSTANTIATE_SEGMENTED_READ(int64_t)
+ERG_INSTANTIATE_SEGMENTED_READ(uint8_t)
+ERG_INSTANTIATE_SEGMENTED_READ(uint16_t)
+ERG_INSTANTIATE_SEGMENTED_READ(uint32_t)
+ERG_INSTANTIATE_SEGMENTED_READ(uint64_t)
+ERG_INSTANTIATE_SEGMENTED_READ(float)
+ERG_INSTANTIATE_SEGMENTED_READ(double)
+
+}
@@ -0,0 +1,274 @@
+/**********************************************************************************
+ *   30/01/2015                                                                   *
+ *                                                                                *
+ *   www.henesis.eu                                                               *
+ *                                                                                *
+ *   Alessandro Bacchini - alessandro.bacchini@henesis.eu                         *
+ *                                                                                *
+ * Copyright (c) 2015, Henesis s.r.l. part of Camlin Group                        *
+ *                                                                                *
+ * The MIT License (MIT)                                                          *
+ *                                                                                *
+ * Permission is here by granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal  *
+ * in the Software without restriction, including without limitation the rights   *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ * copies of the Software, and to permit persons to whom the Software is          *
+ * furnished to do so, subject to the following conditions:                       *
+ *                                                                                *
+ * The above copyright notice and this permission notice shall be included in all *
+ * copies or substantial portions of the Software.                                *
+ *                                                                                *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ * SOFTWARE.                                                                      *
+ *********************************************************************************/
+
+#ifndef ERGSEGMENTEDREADER_H
+#define ERGSEGMENTEDREADER_H
+
+#include "erg.h"
+
+
+namespace erg
+{
+
+/*!
+ * \brief Ordered list of `.erg` files read as a single dataset.
+ *
+ * Long runs are often recorded in consecutive segments with the same
+ * quantities. Each segment is opened with its own Reader, which parses and
+ * checks the `.erg.info` and `.erg` headers; the segments must then have the
+ * same byte order, record layout, quantity names and types. The record `i`
+ * of the logical dataset is the record `i - segmentStart(s)` of the segment `s`
+ * that contains it, and the reads that cross the boundaries of the segments
+ * write into a single destination buffer.
+ *
+ * \code
+ * erg::SegmentedReader run({"run_00.erg", "run_01.erg", "run_02.erg"});
+ * std::vector<double> speed(run.records());
+ * run.read<double>(run.index("Vhcl.v"), 0, run.records(), speed.data());
+ * \endcode
+ */
+class SegmentedReader
+{
+public:
+    SegmentedReader() noexcept(true);
+
+    /*!
+     * \brief Open a list of segments.
+     * \see open()
+     */
+    explicit SegmentedReader(const std::vector<std::string>& filenames) noexcept(false);
+
+    SegmentedReader(const SegmentedReader&) = delete;
+    SegmentedReader& operator=(const SegmentedReader&) = delete;
+
+    /*!
+     * \brief Open the segments of a dataset.
+     *
+     * \param filenames Names of the `.erg` files, in record order.
+     * \param backend The I/O backend used by each segment.
+     * \throws If the list is empty, a segment can't be opened or its quantities
+     * differ from the ones of the first segment.
+     */
+    void open(const std::vector<std::string>& filenames, const Backend backend=Backend::Auto) noexcept(false);
+
+    /*!
+     * \brief Close all the segments.
+     */
+    void close() noexcept(true);
+
+    /*!
+     * \brief Number of segments.
+     */
+    size_t segments() const noexcept(true) { return mSegments.size(); }
+
+    /*!
+     * \brief Reader of a segment.
+     * \param s Index of the segment.
+     * \throws If the segment index is out of range.
+     */
+    const Reader& segment(const size_t s) const noexcept(false);
+
+    /*!
+     * \brief Index of the first record of a segment in the dataset.
+     * \param s Index of the segment.
+     * \throws If the segment index is out of range.
+     */
+    size_t segmentStart(const size_t s) const noexcept(false);
+
+    /*!
+     * \brief Segment that contains a record of the dataset.
+     * \param record Index of the record in the dataset.
+     * \param[out] local Index of the record in the segment.
+     * \return The index of the segment.
+     * \throws If the record is out of range.
+     */
+    size_t locate(const size_t record, size_t& local) const noexcept(false);
+
+    /*!
+     * \brief Total number of records of the segments.
+     */
+    size_t records() const noexcept(true) { return mRecordsCount; }
+
+    /*!
+     * \brief Number of quantities of each record.
+     */
+    size_t numQuanities() const noexcept(true);
+
+    /*!
+     * \brief Total size in bytes of a quantity in all the segments.
+     * \throws If the quantity index is out of range.
+     */
+    size_t quantitySize(const size_t qIndex) const noexcept(false);
+
+    /*!
+     * \brief Name of a quantity.
+     * \throws If the quantity index is out of range.
+     */
+    std::string quantityName(const size_t qIndex) const noexcept(false);
+
+    /*!
+     * \brief Type of a quantity.
+     * \throws If the quantity index is out of range.
+     */
+    Type quantityType(const size_t qIndex) const noexcept(false);
+
+    /*!
+     * \brief Unit of a quantity, as reported by the first segment.
+     * \throws If the quantity index is out of range.
+     */
+    std::string quantityUnit(const size_t qIndex) const noexcept(false);
+
+    /*!
+     * \brief Index of a quantity.
+     * \throws If the quantity name is not found.
+     */
+    size_t index(const std::string& qname) const noexcept(false);
+
+    /*!
+     * \brief Test if a quantity is present in the segments.
+     */
+    bool has(const std::string& qname) const noexcept(true);
+
+    /*!
+     * \brief Set the number of threads used to read the segments.
+     *
+     * When a read spans several segments, they are read concurrently, one
+     * segment per thread, into disjoint slices of the destination memory.
+     *
+     * \param threads Number of threads, `0` to use all the hardware threads. Default is `1`.
+     */
+    void setThreads(const size_t threads) noexcept(true);
+
+    /*!
+     * \brief Number of threads used to read the segments.
+     * \see setThreads()
+     */
+    size_t threads() const noexcept(true);
+
+    /*!
+     * \brief Number of records read by a range read.
+     * \see Reader::rangeSize()
+     */
+    size_t rangeSize(const size_t from, const size_t count, const size_t step=1) const noexcept(true);
+
+    /*!
+     * \brief Read every `step` record of a slice of a set of datasets.
+     *
+     * \param qindices Indices of the datasets to read
+     * \param from Index of the first record to read
+     * \param count Maximum number of records to read
+     * \param step Distance between two read records, must be greater than zero
+     * \param values Vector of pointer to the destination data of each dataset in `qindices`.
+     * \param sizes Size of the memory allocated for each dataset.
+     * \return The number of records that has been read.
+     * \throws If a quantity index is out of range, the step is zero or not enough memory is allocated.
+     * \see Reader::read()
+     */
+    size_t read(const std::vector<size_t>& qindices, const size_t from, const size_t count, const size_t step,
+                std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const;
+
+    /*!
+     * \brief Read a slice of a set of datasets.
+     * \see read(const std::vector<size_t>&, const size_t, const size_t, const size_t, std::vector<uint8_t*>&, const std::vector<size_t>&)
+     */
+    size_t read(const std::vector<size_t>& qindices, const size_t from, const size_t count,
+                std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const;
+
+    /*!
+     * \brief Read a slice of a single dataset.
+     * \see read(const std::vector<size_t>&, const size_t, const size_t, const size_t, std::vector<uint8_t*>&, const std::vector<size_t>&)
+     */
+    size_t read(const size_t qindex, const size_t from, const size_t count, uint8_t* dst, const size_t size) const;
+
+    /*!
+     * \brief Read all the datasets of all the segments.
+     * \param values Vector of pointer to the destination data of each quantity.
+     * \param sizes Size of the memory allocated for each quantity.
+     * \return The number of rows that has been read.
+     */
+    size_t readAll(std::vector<uint8_t*>& values, const std::vector<size_t>& sizes) const;
+
+    /*!
+     * \brief Read every `step` record of a slice of a set of datasets converted to type `T`.
+     * \param values Destination memory for rangeSize(from, count, step) elements of each dataset
+     * \see Reader::read(const std::vector<size_t>&, const size_t, const size_t, const size_t, std::vector<T*>&) const
+     */
+    template<typename T>
+    size_t read(const std::vector<size_t>& qindices, const size_t from, const size_t count, const size_t step,
+                std::vector<T*>& values) const;
+
+    /*!
+     * \brief Read a slice of a single dataset converted to type `T`.
+     * \param dst The pre-allocated destination memory for rangeSize(from, count) elements
+     */
+    template<typename T>
+    size_t read(const size_t qindex, const size_t from, const size_t count, T* dst) const;
+
+    /*!
+     * \brief Read all the datasets of all the segments converted to type `T`.
+     * \param values Destination memory for records() elements of each dataset.
+     */
+    template<typename T>
+    size_t readAll(std::vector<T*>& values) const;
+
+protected:
+    //! Read of a range of records of a segment
+    struct Part
+    {
+        size_t segment; //!< Index of the segment
+        size_t from;    //!< First record in the segment
+        size_t rows;    //!< Number of records
+        size_t offset;  //!< Index of the first destination element
+    };
+
+    /*!
+     * \brief Split a range read between the segments.
+     * \return The parts of the read, in record order.
+     */
+    std::vector<Part> split(const size_t from, const size_t count, const size_t step) const noexcept(true);
+
+    /*!
+     * \brief Read the parts of a range read, concurrently if threads() allows it.
+     * \param parts The parts returned by split().
+     * \param read Function that reads a part and returns the number of records read.
+     * \return The number of records read without gaps from the first one.
+     */
+    size_t readParts(const std::vector<Part>& parts, const std::function<size_t(const Part&)>& read) const;
+
+    std::vector< std::unique_ptr<Reader> > mSegments;   //!< Readers of the segments
+    std::vector<size_t> mStarts;        //!< First record of each segment
+    std::vector<size_t> mElementSizes;  //!< Size in bytes of each quantity in a record
+    size_t mRecordsCount;               //!< Total number of records
+    size_t mThreads;                    //!< Number of segments read concurrently, `0` for all the hardware threads
+};
+
+}
+
+#endif // ERGSEGMENTEDREADER_H
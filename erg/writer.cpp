@@ -0,0 +1,362 @@
+/**********************************************************************************
+ *   30/01/2015                                                                   *
+ *                                                                                *
+ *   www.henesis.eu                                                               *
+ *                                                                                *
+ *   Alessandro Bacchini - alessandro.bacchini@henesis.eu                         *
+ *                                                                                *
+ * Copyright (c) 2015, Henesis s.r.l. part of Camlin Group                        *
+ *                                                                                *
+ * The MIT License (MIT)                                                          *
+ *                                                                                *
+ * Permission is here by granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal  *
+ * in the Software without restriction, including without limitation the rights   *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ * copies of the Software, and to permit persons to whom the Software is          *
+ * furnished to do so, subject to the following conditions:                       *
+ *                                                                                *
+ * The above copyright notice and this permission notice shall be included in all *
+ * copies or substantial portions of the Software.                                *
+ *                                                                                *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ * SOFTWARE.                                                                      *
+ *********************************************************************************/
+
+#include "writer.h"
+
+#include <cstdio>
+#include <limits>
+#include <unordered_set>
+
+
+// Records filled with all the quantities before moving to the next group
+#define TILE_RECORDS    256
+
+// Default size of the write buffer
+#define WRITE_BUFFER_SIZE   (4 * 1024 * 1024)
+
+namespace erg
+{
+
+/*!
+ * \brief Check if the host has big endian order.
+ * \return `true` if the host has big endian order.
+ */
+static bool hostIsBigEndian() noexcept(true)
+{
+    const uint16_t one = 1;
+    uint8_t first = 0;
+    std::memcpy(&first, &one, sizeof(first));
+    return first==0;
+}
+
+/*!
+ * \brief Copy a field of `Size` bytes, reversing its bytes if `Swap` is true.
+ * \see Writer::CopyFunction
+ */
+template<size_t Size, bool Swap>
+static void copyField(const uint8_t* src, const size_t srcStride, uint8_t* dst,
+                      const size_t dstStride, const size_t rows)
+{
+    for(size_t i=0; i<rows; ++i)
+    {
+        const uint8_t* s = src + i * srcStride;
+        uint8_t* d = dst + i * dstStride;
+        for(size_t b=0; b<Size; ++b)
+            d[b] = s[Swap ? Size - 1 - b : b];
+    }
+}
+
+/*!
+ * \brief Copy kernel of a field.
+ * \param size Size in bytes of the field.
+ * \return The kernel, with the byte swap if `Swap` is true.
+ * \throws If the size is not 1, 2, 4 or 8 bytes.
+ */
+template<bool Swap>
+static Writer::CopyFunction copyKernel(const size_t size) noexcept(false)
+{
+    switch (size)
+    {
+    case 1:
+        return &copyField<1, Swap>;
+    case 2:
+        return &copyField<2, Swap>;
+    case 4:
+        return &copyField<4, Swap>;
+    case 8:
+        return &copyField<8, Swap>;
+    default:
+        throw std::runtime_error("Unknown data type size.");
+    }
+}
+
+/*!
+ * \brief Check if a string is stored unchanged as a value of the companion file.
+ *
+ * The values are trimmed and end at the first `#` or at the end of the line.
+ *
+ * \param value The string.
+ * \param forbidden Other characters that can't be stored.
+ * \return `true` if the string can be stored.
+ */
+static bool isInfoValue(const std::string& value, const char* forbidden) noexcept(true)
+{
+    if(value.find_first_of("#\r\n")!=std::string::npos || value.find_first_of(forbidden)!=std::string::npos)
+        return false;
+    return value.empty() ||
+           (!::isspace(static_cast<unsigned char>(value.front())) && !::isspace(static_cast<unsigned char>(value.back())));
+}
+
+
+Writer::Writer() noexcept(true)
+    : mByteOrder(ByteOrder::LittelEndian), mSwap(false), mRecordSize(0), mRecordsCount(0),
+      mBufferSize(WRITE_BUFFER_SIZE), mBufferRecords(0)
+{
+}
+
+Writer::Writer(const std::string& filename, const std::vector<Quantity>& quantities,
+               const ByteOrder byteOrder) noexcept(false)
+    : Writer()
+{
+    open(filename, quantities, byteOrder);
+}
+
+Writer::~Writer()
+{
+    try {
+        close();
+    } catch(std::runtime_error&) {
+    }
+}
+
+void Writer::open(const std::string& filename, const std::vector<Quantity>& quantities,
+                  const ByteOrder byteOrder) noexcept(false)
+{
+    close();
+
+    // Packed records: each quantity starts where the previous one ends
+    std::vector<Quantity> packed;
+    std::unordered_set<std::string> names;
+    size_t recordSize = 0;
+    for(const Quantity& q: quantities)
+    {
+        if(q.name.empty())
+            throw std::runtime_error("The quantities must have a name.");
+        if(names.insert(q.name).second==false)
+            throw std::runtime_error("The quantity "+q.name+" is defined more than once.");
+        if(q.type==Type::Void)
+            throw std::runtime_error("The quantity "+q.name+" has no data type.");
+        if(!isInfoValue(q.name, "=") || !isInfoValue(q.unit, ""))
+            throw std::runtime_error("The name or the unit of the quantity "+q.name+" can't be stored in the info file.");
+
+        Quantity p = q;
+        p.typeStr = Reader::typeName(q.type);
+        p.size = Reader::dataSize(q.type);
+        p.offset = recordSize;
+        recordSize += p.size;
+        packed.push_back(p);
+    }
+    if(packed.empty())
+        throw std::runtime_error("The file must have at least one quantity.");
+    if(recordSize>std::numeric_limits<uint16_t>::max())
+        throw std::runtime_error("The record size of "+std::to_string(recordSize)+" bytes does not fit the erg header.");
+
+    // Companion file
+    {
+        std::ofstream info(filename+".info", std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        if(info.is_open()==false)
+            throw std::runtime_error("Can't write "+filename+".info file.");
+
+        info << "#INFOFILE1.1 - Do not remove this line!\n"
+             << "File.Format = erg\n"
+             << "File.ByteOrder = " << (byteOrder==ByteOrder::BigEndian ? "BigEndian" : "LittleEndian") << "\n";
+        for(size_t i=0; i<packed.size(); ++i)
+        {
+            info << "\n"
+                 << "File.At." << i + 1 << ".Name = " << packed[i].name << "\n"
+                 << "File.At." << i + 1 << ".Type = " << packed[i].typeStr << "\n";
+            if(packed[i].unit.empty()==false)
+                info << "Quantity." << packed[i].name << ".Unit = " << packed[i].unit << "\n";
+        }
+        info.close();
+        if(info.fail()) {
+            std::remove((filename+".info").c_str());
+            throw std::runtime_error("Can't write "+filename+".info file.");
+        }
+    }
+
+    // Header, with the record size in the byte order of the data
+    header_t header;
+    std::memset(&header, 0, sizeof(header_t));
+    std::memcpy(header.identifier, "CM-ERG", sizeof("CM-ERG") - 1);
+    header.version = 1;
+    header.byte_order = byteOrder==ByteOrder::BigEndian ? 1 : 0;
+    const uint8_t size[2] = {static_cast<uint8_t>(recordSize & 0xff), static_cast<uint8_t>(recordSize >> 8)};
+    uint8_t* recordSizeBytes = reinterpret_cast<uint8_t*>(&header.record_size);
+    recordSizeBytes[0] = byteOrder==ByteOrder::BigEndian ? size[1] : size[0];
+    recordSizeBytes[1] = byteOrder==ByteOrder::BigEndian ? size[0] : size[1];
+
+    // The companion file is removed if the data file can't be written
+    mFile.open(filename, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if(mFile.is_open()==false) {
+        std::remove((filename+".info").c_str());
+        throw std::runtime_error("Can't write "+filename+" file.");
+    }
+    mFile.write(reinterpret_cast<const char*>(&header), sizeof(header_t));
+    if(!mFile) {
+        mFile.close();
+        std::remove((filename+".info").c_str());
+        throw std::runtime_error("Can't write "+filename+" file.");
+    }
+
+    mFilename = filename;
+    mByteOrder = byteOrder;
+    mSwap = (byteOrder==ByteOrder::BigEndian) != hostIsBigEndian();
+    mQuantities.swap(packed);
+    for(const Quantity& q: mQuantities)
+        mKernels.push_back(mSwap ? copyKernel<true>(q.size) : copyKernel<false>(q.size));
+    mRecordSize = recordSize;
+    mRecordsCount = 0;
+    mBuffer.resize(std::max<size_t>(1, mBufferSize / mRecordSize) * mRecordSize);
+    mBufferRecords = 0;
+}
+
+void Writer::close() noexcept(false)
+{
+    // The file is closed also if the last records can't be written
+    const std::string filename = mFilename;
+    bool failed = false;
+    if(mFile.is_open()) {
+        try {
+            flush();
+        } catch(std::runtime_error&) {
+            failed = true;
+        }
+        mFile.close();
+        failed = failed || mFile.fail();
+    }
+
+    mFilename.clear();
+    mQuantities.clear();
+    mKernels.clear();
+    mSwap = false;
+    mRecordSize = 0;
+    mRecordsCount = 0;
+    std::vector<uint8_t>().swap(mBuffer);
+    mBufferRecords = 0;
+
+    if(failed)
+        throw std::runtime_error("Can't write "+filename+" file.");
+}
+
+void Writer::checkOpen() const noexcept(false)
+{
+    if(mFile.is_open()==false)
+        throw std::runtime_error("No file is open.");
+}
+
+void Writer::writeColumns(const std::vector<const void*>& columns, const size_t rows) noexcept(false)
+{
+    checkOpen();
+    if(columns.size()!=mQuantities.size())
+        throw std::runtime_error("Expected "+std::to_string(mQuantities.size())+" columns, got "+
+                                 std::to_string(columns.size())+".");
+    for(size_t i=0; i<columns.size(); ++i)
+    {
+        if(columns[i]==nullptr && rows>0)
+            throw std::runtime_error("No data for the quantity "+mQuantities[i].name+".");
+    }
+
+    const size_t capacity = mBuffer.size() / mRecordSize;
+    for(size_t done=0; done<rows; )
+    {
+        const size_t n = std::min(rows - done, capacity - mBufferRecords);
+        encodeColumns(columns, done, n);
+        done += n;
+        if(mBufferRecords==capacity)
+            flush();
+    }
+}
+
+void Writer::writeRecords(const void* records, const size_t rows) noexcept(false)
+{
+    checkOpen();
+    if(records==nullptr && rows>0)
+        throw std::runtime_error("No data for the records.");
+
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(records);
+    const size_t capacity = mBuffer.size() / mRecordSize;
+    for(size_t done=0; done<rows; )
+    {
+        const size_t n = std::min(rows - done, capacity - mBufferRecords);
+        encodeRecords(src + done * mRecordSize, n);
+        done += n;
+        if(mBufferRecords==capacity)
+            flush();
+    }
+}
+
+void Writer::flush() noexcept(false)
+{
+    if(mBufferRecords==0)
+        return;
+
+    // Records that can't be written are discarded and not counted
+    mFile.write(reinterpret_cast<const char*>(mBuffer.data()), mBufferRecords * mRecordSize);
+    const size_t rows = mBufferRecords;
+    mBufferRecords = 0;
+    if(!mFile)
+        throw std::runtime_error("Can't write "+mFilename+" file.");
+    mRecordsCount += rows;
+}
+
+void Writer::encodeColumns(const std::vector<const void*>& columns, const size_t from, const size_t rows) noexcept(true)
+{
+    uint8_t* records = mBuffer.data() + mBufferRecords * mRecordSize;
+
+    // Tiled transposition: fill a group of records with all the quantities
+    // before moving to the next one.
+    for(size_t tile=0; tile<rows; tile+=TILE_RECORDS)
+    {
+        const size_t tileRows = std::min<size_t>(TILE_RECORDS, rows - tile);
+        uint8_t* tileRecords = records + tile * mRecordSize;
+        for(size_t i=0; i<mQuantities.size(); ++i)
+        {
+            const Quantity& q = mQuantities[i];
+            const uint8_t* src = reinterpret_cast<const uint8_t*>(columns[i]) + (from + tile) * q.size;
+            mKernels[i](src, q.size, tileRecords + q.offset, mRecordSize, tileRows);
+        }
+    }
+
+    mBufferRecords += rows;
+}
+
+void Writer::encodeRecords(const uint8_t* records, const size_t rows) noexcept(true)
+{
+    uint8_t* dst = mBuffer.data() + mBufferRecords * mRecordSize;
+    if(mSwap) {
+        for(size_t tile=0; tile<rows; tile+=TILE_RECORDS)
+        {
+            const size_t tileRows = std::min<size_t>(TILE_RECORDS, rows - tile);
+            const size_t offset = tile * mRecordSize;
+            for(size_t i=0; i<mQuantities.size(); ++i)
+            {
+                const size_t field = offset + mQuantities[i].offset;
+                mKernels[i](records + field, mRecordSize, dst + field, mRecordSize, tileRows);
+            }
+        }
+    } else {
+        std::memcpy(dst, records, rows * mRecordSize);
+    }
+
+    mBufferRecords += rows;
+}
+
+}
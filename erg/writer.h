@@ -0,0 +1,222 @@
+/**********************************************************************************
+ *   30/01/2015                                                                   *
+ *                                                                                *
+ *   www.henesis.eu                                                               *
+ *                                                                                *
+ *   Alessandro Bacchini - alessandro.bacchini@henesis.eu                         *
+ *                                                                                *
+ * Copyright (c) 2015, Henesis s.r.l. part of Camlin Group                        *
+ *                                                                                *
+ * The MIT License (MIT)                                                          *
+ *                                                                                *
+ * Permission is here by granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal  *
+ * in the Software without restriction, including without limitation the rights   *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      *
+ * copies of the Software, and to permit persons to whom the Software is          *
+ * furnished to do so, subject to the following conditions:                       *
+ *                                                                                *
+ * The above copyright notice and this permission notice shall be included in all *
+ * copies or substantial portions of the Software.                                *
+ *                                                                                *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  *
+ * SOFTWARE.                                                                      *
+ *********************************************************************************/
+
+#ifndef ERGWRITER_H
+#define ERGWRITER_H
+
+#include "erg.h"
+
+
+namespace erg
+{
+
+/*!
+ * \brief Writer of `.erg` files and of their `.erg.info` companion file.
+ *
+ * open() writes the companion file and the header_t of the `.erg` file,
+ * then the records are appended from a buffer for each quantity or from
+ * packed records. The data is given in host byte order and it is converted
+ * to the byte order of the file while it is copied into a large write buffer.
+ * The files can be read by Reader once the writer has been closed.
+ *
+ * \code
+ * std::vector<erg::Quantity> quantities(2);
+ * quantities[0].name = "Time";
+ * quantities[0].unit = "s";
+ * quantities[0].type = erg::Type::Double;
+ * quantities[1].name = "Vhcl.v";
+ * quantities[1].unit = "m/s";
+ * quantities[1].type = erg::Type::Float;
+ *
+ * erg::Writer writer("out.erg", quantities);
+ * writer.writeColumns({time.data(), speed.data()}, time.size());
+ * writer.close();
+ * \endcode
+ */
+class Writer
+{
+public:
+    Writer() noexcept(true);
+
+    /*!
+     * \brief Create a file.
+     * \see open()
+     */
+    Writer(const std::string& filename, const std::vector<Quantity>& quantities,
+           const ByteOrder byteOrder=ByteOrder::LittelEndian) noexcept(false);
+
+    /*!
+     * \brief Close the file, ignoring the errors.
+     * \see close()
+     */
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    /*!
+     * \brief Create a `.erg` file and its `.erg.info` companion file.
+     *
+     * The name, the unit and the type of each quantity are used: the size,
+     * the offset and the type string are computed by the writer. The records
+     * are packed, without padding bytes.
+     *
+     * \param filename Name of the `.erg` file.
+     * \param quantities The quantities of each record.
+     * \param byteOrder Byte order of the data in the file.
+     * \throws If a file can't be written, a quantity has Type::Void, an empty
+     * name or characters that can't be stored in the companion file, or the
+     * record does not fit the 16 bits record size of the header.
+     */
+    void open(const std::string& filename, const std::vector<Quantity>& quantities,
+              const ByteOrder byteOrder=ByteOrder::LittelEndian) noexcept(false);
+
+    /*!
+     * \brief Flush the buffered records and close the file.
+     * \throws If the records can't be written.
+     */
+    void close() noexcept(false);
+
+    /*!
+     * \brief Check if a file is open.
+     */
+    bool isOpen() const noexcept(true) { return mFile.is_open(); }
+
+    /*!
+     * \brief Set the size of the write buffer.
+     *
+     * The buffer holds at least a record. The size is used by the following open().
+     *
+     * \param bytes Size of the buffer in bytes. Default is 4 MiB.
+     */
+    void setBufferSize(const size_t bytes) noexcept(true) { mBufferSize = bytes; }
+
+    /*!
+     * \brief Size of the write buffer.
+     * \see setBufferSize()
+     */
+    size_t bufferSize() const noexcept(true) { return mBufferSize; }
+
+    /*!
+     * \brief Byte order of the data in the file.
+     */
+    ByteOrder byteOrder() const noexcept(true) { return mByteOrder; }
+
+    /*!
+     * \brief Quantities of each record, with their size and offset.
+     */
+    const std::vector<Quantity>& quantities() const noexcept(true) { return mQuantities; }
+
+    /*!
+     * \brief Number of quantities of each record.
+     */
+    size_t numQuanities() const noexcept(true) { return mQuantities.size(); }
+
+    /*!
+     * \brief Size in bytes of each record.
+     */
+    size_t recordSize() const noexcept(true) { return mRecordSize; }
+
+    /*!
+     * \brief Number of records written, including the buffered ones.
+     */
+    size_t records() const noexcept(true) { return mRecordsCount + mBufferRecords; }
+
+    /*!
+     * \brief Append records from a buffer for each quantity.
+     * \param columns The `rows` values of each quantity, in host byte order and in
+     * the order of quantities().
+     * \param rows Number of records.
+     * \throws If the number of columns is wrong, a column is `nullptr` or the
+     * records can't be written.
+     */
+    void writeColumns(const std::vector<const void*>& columns, const size_t rows) noexcept(false);
+
+    /*!
+     * \brief Append packed records.
+     * \param records The records: recordSize() bytes each, with the quantities in host
+     * byte order at their offset.
+     * \param rows Number of records.
+     * \throws If no file is open or the records can't be written.
+     */
+    void writeRecords(const void* records, const size_t rows) noexcept(false);
+
+    /*!
+     * \brief Write the buffered records to the file.
+     *
+     * On errors the buffered records are discarded and not counted by records().
+     *
+     * \throws If the records can't be written.
+     */
+    void flush() noexcept(false);
+
+    /*!
+     * \brief Kernel copying a field in each record, with an optional byte swap.
+     * \param src The first value.
+     * \param srcStride Distance in bytes between two values.
+     * \param dst The field in the first record.
+     * \param dstStride Distance in bytes between two records.
+     * \param rows Number of values.
+     */
+    typedef void (*CopyFunction)(const uint8_t* src, const size_t srcStride, uint8_t* dst,
+                                 const size_t dstStride, const size_t rows);
+
+protected:
+    /*!
+     * \brief Copy a block of records from the columns into the write buffer.
+     */
+    void encodeColumns(const std::vector<const void*>& columns, const size_t from, const size_t rows) noexcept(true);
+
+    /*!
+     * \brief Copy a block of packed records into the write buffer.
+     */
+    void encodeRecords(const uint8_t* records, const size_t rows) noexcept(true);
+
+    /*!
+     * \brief Throw if no file is open.
+     */
+    void checkOpen() const noexcept(false);
+
+    std::string mFilename;          //!< Name of the `.erg` file
+    std::ofstream mFile;            //!< Open `.erg` file
+    ByteOrder mByteOrder;           //!< Byte order of the data in the file
+    bool mSwap;                     //!< The byte order of the file differs from the host one
+    std::vector<Quantity> mQuantities;  //!< Quantities of each record
+    std::vector<CopyFunction> mKernels; //!< Copy kernel of each quantity
+    size_t mRecordSize;             //!< Size in bytes of each record
+    size_t mRecordsCount;           //!< Number of records written to the file
+    size_t mBufferSize;             //!< Requested size of the write buffer
+    std::vector<uint8_t> mBuffer;   //!< Write buffer, a multiple of the record size
+    size_t mBufferRecords;          //!< Records in the write buffer
+};
+
+}
+
+#endif // ERGWRITER_H
@@ -82,8 +82,8 @@ static size_t indexFromPyObject(erg::Reader* parser, PyObject* arg)
         // Check if the quantity is a string or an integer
         if(PyUnicode_Check(arg)) {
             // Find the quantity id
-            const char* qname = PyUnicode_AsUTF8(arg);
-            qindex = parser->index(std::string(qname));
+            // index() throws also the parsing error of a lazy open
+            qindex = parser->index(PyUnicode_AsUTF8(arg));
         } else if(PyLong_Check(arg)){
             qindex = PyLong_AsLong(arg);
         } else {
@@ -97,220 +97,1966 @@ static size_t indexFromPyObject(erg::Reader* parser, PyObject* arg)
     return qindex;
 }
 
+/*!
+ * \brief Register a read that runs with the GIL released.
+ *
+ * Reads can run concurrently on the same reader, but not while the file is
+ * being opened. Must be called with the GIL held.
+ * \param self The Python reader.
+ * \return `false`, with a Python exception set, if the read can't start.
+ */
+static bool beginRead(Reader* self)
+{
+    if(self->opening) {
+        PyErr_SetString(PyExc_RuntimeError, "The reader is opening a file.");
+        return false;
+    }
+    self->readers += 1;
+    return true;
+}
+
+/*!
+ * \brief Unregister a read started with beginRead(). Must be called with the GIL held.
+ * \param self The Python reader.
+ */
+static void endRead(Reader* self)
+{
+    self->readers -= 1;
+}
+
+/*!
+ * \brief Check that no read or open is in progress, before changing the reader state.
+ * \param self The Python reader.
+ * \return `false`, with a Python exception set, if the reader is in use.
+ */
+static bool checkIdle(Reader* self)
+{
+    if(self->readers>0 || self->opening) {
+        PyErr_SetString(PyExc_RuntimeError, "The reader is in use by another thread.");
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief Parse the quantities deferred by the lazy open.
+ * \param self The Python reader.
+ * \return `false`, with a Python exception set, if the quantities can't be parsed.
+ */
+static bool loadQuantities(Reader* self)
+{
+    try {
+        self->parser->load();
+    } catch (std::runtime_error& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief Quantity indices from a PyObject.
+ *
+ * If errors happens during the parsing, a PyErr_SetString attribute is set: use the
+ * PyErr_Occurred() to check if the returned value is valid or not.
+ * \param arg PyObject representing a sequence of quantity indices or names.
+ * \return The quantity indices.
+ */
+static std::vector<size_t> indicesFromPyObject(erg::Reader* parser, PyObject* arg)
+{
+    std::vector<size_t> qindices;
+    if(PyUnicode_Check(arg) || !PySequence_Check(arg)) {
+        PyErr_SetString(PyExc_NameError, "The argument must be a sequence of quantity names or indices.");
+        return qindices;
+    }
+
+    PyObject* seq = PySequence_Fast(arg, "The argument must be a sequence of quantity names or indices.");
+    if(seq==nullptr)
+        return qindices;
+
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    for(Py_ssize_t i=0; i<n; ++i)
+    {
+        const size_t qindex = indexFromPyObject(parser, PySequence_Fast_GET_ITEM(seq, i));
+        if(PyErr_Occurred()!=nullptr)
+            break;
+        qindices.push_back(qindex);
+    }
+    Py_DecRef(seq);
+
+    return qindices;
+}
+
+/*!
+ * \brief Predicates of a filtered read from a PyObject.
+ *
+ * If errors happens during the parsing, a Python exception is set.
+ * \param parser The reader.
+ * \param arg Sequence of `(quantity, operator, value)` tuples, where the operator is one
+ * of `<`, `<=`, `>`, `>=`, `==` and `!=`.
+ * \param predicates Set to the predicates.
+ * \return `false` on errors.
+ */
+static bool predicatesFromPyObject(erg::Reader* parser, PyObject* arg, std::vector<erg::Predicate>& predicates)
+{
+    static const char* ERROR = "The conditions must be a sequence of (quantity, operator, value) tuples.";
+    static const char* OPERATORS[] = {"<", "<=", ">", ">=", "==", "!="};
+    static const erg::Compare COMPARES[] = {erg::Compare::Less, erg::Compare::LessEqual, erg::Compare::Greater,
+                                            erg::Compare::GreaterEqual, erg::Compare::Equal, erg::Compare::NotEqual};
+
+    predicates.clear();
+    if(PyUnicode_Check(arg) || !PySequence_Check(arg)) {
+        PyErr_SetString(PyExc_TypeError, ERROR);
+        return false;
+    }
+    PyObject* seq = PySequence_Fast(arg, ERROR);
+    if(seq==nullptr)
+        return false;
+
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    for(Py_ssize_t i=0; i<n; ++i)
+    {
+        PyObject* qobj = nullptr;
+        const char* op = nullptr;
+        double value = 0.0;
+        PyObject* item = PySequence_Fast_GET_ITEM(seq, i);
+        if(!PyTuple_Check(item) || !PyArg_ParseTuple(item, "Osd", &qobj, &op, &value)) {
+            if(PyErr_Occurred()==nullptr)
+                PyErr_SetString(PyExc_TypeError, ERROR);
+            break;
+        }
+
+        erg::Predicate predicate;
+        predicate.qindex = indexFromPyObject(parser, qobj);
+        if(PyErr_Occurred()!=nullptr)
+            break;
+        const size_t nOps = sizeof(OPERATORS) / sizeof(OPERATORS[0]);
+        size_t k = 0;
+        while(k<nOps && std::strcmp(op, OPERATORS[k])!=0)
+            ++k;
+        if(k==nOps) {
+            PyErr_Format(PyExc_ValueError, "Unknown operator '%s'.", op);
+            break;
+        }
+        predicate.op = COMPARES[k];
+        predicate.operand = value;
+        predicates.push_back(predicate);
+    }
+    Py_DecRef(seq);
+
+    return PyErr_Occurred()==nullptr;
+}
+
+/*!
+ * \brief Numpy type of a typed read from a dtype argument.
+ *
+ * Only native byte order integer and floating point types are supported.
+ * If errors happens during the parsing, a Python exception is set.
+ * \param obj Any object accepted by numpy.dtype(), None or nullptr.
+ * \param npyType Set to the numpy type or to `-1` if no conversion is requested.
+ * \return `false` on errors.
+ */
+static bool dtypeFromPyObject(PyObject* obj, int& npyType)
+{
+    npyType = -1;
+    if(obj==nullptr || obj==Py_None)
+        return true;
+
+    PyArray_Descr* descr = nullptr;
+    if(!PyArray_DescrConverter(obj, &descr))
+        return false;
+
+    const char kind = descr->kind;
+    const int size = PyDataType_ELSIZE(descr);
+    const bool native = PyArray_ISNBO(descr->byteorder);
+    Py_DecRef((PyObject*)descr);
+
+    if(native) {
+        if(kind=='f' && size==4)
+            npyType = NPY_FLOAT32;
+        else if(kind=='f' && size==8)
+            npyType = NPY_FLOAT64;
+        else if(kind=='i' && size==1)
+            npyType = NPY_INT8;
+        else if(kind=='i' && size==2)
+            npyType = NPY_INT16;
+        else if(kind=='i' && size==4)
+            npyType = NPY_INT32;
+        else if(kind=='i' && size==8)
+            npyType = NPY_INT64;
+        else if(kind=='u' && size==1)
+            npyType = NPY_UINT8;
+        else if(kind=='u' && size==2)
+            npyType = NPY_UINT16;
+        else if(kind=='u' && size==4)
+            npyType = NPY_UINT32;
+        else if(kind=='u' && size==8)
+            npyType = NPY_UINT64;
+    }
+
+    if(npyType<0) {
+        PyErr_SetString(PyExc_TypeError, "The dtype must be a native integer or floating point type.");
+        return false;
+    }
+    return true;
+}
+
+template<typename T, typename R>
+static size_t readAs(const R* parser, const std::vector<size_t>& qindices, const size_t from,
+                     const size_t count, const size_t step, const std::vector<uint8_t*>& values)
+{
+    std::vector<T*> typed;
+    for(uint8_t* v: values)
+        typed.push_back(reinterpret_cast<T*>(v));
+    return parser->template read<T>(qindices, from, count, step, typed);
+}
+
+/*!
+ * \brief Read a slice of a set of quantities converted to a numpy type.
+ * \param parser The reader, an erg::Reader or an erg::SegmentedReader.
+ * \param npyType Numpy type returned by dtypeFromPyObject().
+ * \throws If the read fails.
+ * \see erg::Reader::read()
+ */
+template<typename R>
+static size_t readTyped(const R* parser, const int npyType, const std::vector<size_t>& qindices,
+                        const size_t from, const size_t count, const size_t step, const std::vector<uint8_t*>& values)
+{
+    switch (npyType)
+    {
+    case NPY_FLOAT32:
+        return readAs<float>(parser, qindices, from, count, step, values);
+    case NPY_FLOAT64:
+        return readAs<double>(parser, qindices, from, count, step, values);
+    case NPY_INT8:
+        return readAs<int8_t>(parser, qindices, from, count, step, values);
+    case NPY_INT16:
+        return readAs<int16_t>(parser, qindices, from, count, step, values);
+    case NPY_INT32:
+        return readAs<int32_t>(parser, qindices, from, count, step, values);
+    case NPY_INT64:
+        return readAs<int64_t>(parser, qindices, from, count, step, values);
+    case NPY_UINT8:
+        return readAs<uint8_t>(parser, qindices, from, count, step, values);
+    case NPY_UINT16:
+        return readAs<uint16_t>(parser, qindices, from, count, step, values);
+    case NPY_UINT32:
+        return readAs<uint32_t>(parser, qindices, from, count, step, values);
+    case NPY_UINT64:
+        return readAs<uint64_t>(parser, qindices, from, count, step, values);
+    default:
+        throw std::runtime_error("Unsupported data type.");
+    }
+}
+
+/*!
+ * \brief Records range from the Python arguments of a read.
+ *
+ * `start` can be an integer, negative values count from the end of the file, or
+ * a slice object with a positive step. A negative `count` reads up to the end of the file.
+ * If errors happens during the parsing, a Python exception is set.
+ * \param self The Python reader.
+ * \param start Index of the first record, slice object or nullptr.
+ * \param count Maximum number of records.
+ * \param step Distance between two records.
+ * \param from Index of the first record to read.
+ * \param rows Number of records to read.
+ * \param stride Distance between two records to read.
+ * \return `false` on errors.
+ */
+static bool rangeFromPyObject(Reader* self, PyObject* start, Py_ssize_t count, Py_ssize_t step,
+                              size_t& from, size_t& rows, size_t& stride)
+{
+    const Py_ssize_t records = self->parser->records();
+
+    if(start!=nullptr && PySlice_Check(start)) {
+        if(count>=0 || step!=1) {
+            PyErr_SetString(PyExc_TypeError, "count and step can't be used with a slice.");
+            return false;
+        }
+
+        Py_ssize_t first, last;
+        if(PySlice_Unpack(start, &first, &last, &step)<0)
+            return false;
+        if(step<=0) {
+            PyErr_SetString(PyExc_ValueError, "The slice step must be positive.");
+            return false;
+        }
+
+        rows = PySlice_AdjustIndices(records, &first, &last, step);
+        from = first;
+        stride = step;
+        return true;
+    }
+
+    Py_ssize_t first = 0;
+    if(start!=nullptr && start!=Py_None) {
+        first = PyLong_AsSsize_t(start);
+        if(PyErr_Occurred()!=nullptr)
+            return false;
+        if(first<0)
+            first = std::max<Py_ssize_t>(0, records + first);
+    }
+
+    if(step<=0) {
+        PyErr_SetString(PyExc_ValueError, "The step must be positive.");
+        return false;
+    }
+
+    from = first;
+    stride = step;
+    rows = self->parser->rangeSize(from, count<0 ? records : count, stride);
+    return true;
+}
+
+/*!
+ * \brief Read a slice of a quantity.
+ * \param self The Python reader.
+ * \param qindex Index of the quantity to read.
+ * \param from Index of the first record to read.
+ * \param count Number of records to read: it must be inside the file.
+ * \param step Distance between two records.
+ * \param npyType Numpy type of the returned array, `-1` for the type stored in the file.
+ * \return Numpy array or nullptr on errors.
+ */
+static PyObject* readColumn(Reader* self, const size_t qindex, const size_t from, const size_t count,
+                            const size_t step, const int npyType)
+{
+    PyArrayObject* array = nullptr;
+    try {
+        npy_intp rows = count;
+        int type = npyType>=0 ? npyType : ergType2npyType(self->parser->quantityType(qindex));
+        array = (PyArrayObject*)PyArray_SimpleNew(1, &rows, type);
+    } catch(std::runtime_error& e) {
+        PyErr_SetString(PyExc_NameError, e.what());
+        return nullptr;
+    }
+    if(array==nullptr)
+        return nullptr;
+    uint8_t* outData = (uint8_t*)PyArray_DATA(array);
+    const npy_intp size = PyArray_NBYTES(array);
+
+    if(!beginRead(self)) {
+        Py_DecRef((PyObject*)array);
+        return nullptr;
+    }
+
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            if(npyType>=0)
+                readTyped(self->parser, npyType, std::vector<size_t>(1, qindex), from, count, step,
+                          std::vector<uint8_t*>(1, outData));
+            else
+                self->parser->read(qindex, from, count, step, outData, size);
+        } catch(std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+    endRead(self);
+
+    if(error.length()>0) {
+        Py_DecRef((PyObject*)array);
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+
+    return (PyObject*)array;
+}
+
+/*!
+ * \brief Allocate a Dict of numpy arrays, one for each quantity.
+ *
+ * The Dict holds the only reference to the arrays: a repeated name would free the array
+ * it replaces while its data is still in `data`, so repeated names are refused.
+ * \param names Names of the quantities, used as keys.
+ * \param types Numpy type of each array.
+ * \param rows Number of elements of each array.
+ * \param data Set to the data of each array.
+ * \param sizes Set to the size in bytes of each array.
+ * \return The Dict or nullptr on errors.
+ */
+static PyObject* newColumns(const std::vector<std::string>& names, const std::vector<int>& types, npy_intp rows,
+                            std::vector<uint8_t*>& data, std::vector<size_t>& sizes)
+{
+    data.clear();
+    sizes.clear();
+    PyObject* map = PyDict_New();
+    if(map==nullptr)
+        return nullptr;
+    for(size_t i=0; i<names.size(); ++i)
+    {
+        if(PyDict_GetItemString(map, names[i].c_str())!=nullptr) {
+            PyErr_Format(PyExc_ValueError, "Quantity '%s' is selected more than once.", names[i].c_str());
+            Py_DecRef(map);
+            return nullptr;
+        }
+
+        PyObject* array = PyArray_SimpleNew(1, &rows, types[i]);
+        if(array==nullptr) {
+            Py_DecRef(map);
+            return nullptr;
+        }
+        data.push_back(reinterpret_cast<uint8_t*>(PyArray_DATA((PyArrayObject*)array)));
+        sizes.push_back(PyArray_NBYTES((PyArrayObject*)array));
+
+        const int res = PyDict_SetItemString(map, names[i].c_str(), array);
+        Py_DecRef(array);
+        if(res<0) {
+            Py_DecRef(map);
+            return nullptr;
+        }
+    }
+    return map;
+}
+
+/*!
+ * \brief Read a slice of a set of quantities in a single pass.
+ * \param self The Python reader.
+ * \param qindices Indices of the quantities to read.
+ * \param from Index of the first record to read.
+ * \param count Number of records to read: it must be inside the file.
+ * \param step Distance between two records.
+ * \param npyType Numpy type of the returned arrays, `-1` for the types stored in the file.
+ * \return Dict of numpy arrays with the quantity names as keys or nullptr on errors.
+ */
+static PyObject* readColumns(Reader* self, const std::vector<size_t>& qindices, const size_t from,
+                             const size_t count, const size_t step, const int npyType)
+{
+    // Allocate a Dict of numpy arrays as the returned value.
+    std::vector<std::string> names;
+    std::vector<int> types;
+    try {
+        for(size_t qindex: qindices)
+        {
+            names.push_back(self->parser->quantityName(qindex));
+            types.push_back(npyType>=0 ? npyType : ergType2npyType(self->parser->quantityType(qindex)));
+        }
+    } catch(std::runtime_error& e) {
+        PyErr_SetString(PyExc_NameError, e.what());
+        return nullptr;
+    }
+    std::vector<uint8_t*> dataWrapper;
+    std::vector<size_t> sizeWrapper;
+    PyObject* map = newColumns(names, types, count, dataWrapper, sizeWrapper);
+    if(map==nullptr)
+        return nullptr;
+
+    if(!beginRead(self)) {
+        Py_DecRef(map);
+        return nullptr;
+    }
+
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            if(npyType>=0)
+                readTyped(self->parser, npyType, qindices, from, count, step, dataWrapper);
+            else
+                self->parser->read(qindices, from, count, step, dataWrapper, sizeWrapper);
+        } catch(std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+    endRead(self);
+
+    if(error.length()>0) {
+        Py_DecRef(map);
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+
+    return map;
+}
+
+/*!
+ * \brief Read a slice of a quantity or of a list of quantities.
+ * \param self The Python reader.
+ * \param selection Name or index of a quantity, or a list or tuple of them.
+ * \param from Index of the first record to read.
+ * \param count Number of records to read: it must be inside the file.
+ * \param step Distance between two records.
+ * \param npyType Numpy type of the returned arrays, `-1` for the types stored in the file.
+ * \return Numpy array for a single quantity, Dict of numpy arrays for a list of
+ * quantities or nullptr on errors.
+ */
+static PyObject* readSelection(Reader* self, PyObject* selection, const size_t from, const size_t count,
+                               const size_t step, const int npyType)
+{
+    if(PyList_Check(selection) || PyTuple_Check(selection)) {
+        std::vector<size_t> qindices = indicesFromPyObject(self->parser, selection);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
+        return readColumns(self, qindices, from, count, step, npyType);
+    }
+
+    const size_t qindex = indexFromPyObject(self->parser, selection);
+    if(PyErr_Occurred()!=nullptr)
+        return nullptr;
+    return readColumn(self, qindex, from, count, step, npyType);
+}
+
+//! Name of the capsules that hold a reference to a mapped file
+static const char* MAPPING_CAPSULE = "pyerg.mapping";
+
+extern "C" void releaseMapping(PyObject* capsule)
+{
+    delete reinterpret_cast<std::shared_ptr<const uint8_t>*>(PyCapsule_GetPointer(capsule, MAPPING_CAPSULE));
+}
+
+/*!
+ * \brief Python object that keeps the mapping of the open file alive.
+ *
+ * It is used as base object of the numpy views over the mapped records.
+ * If errors happens, a Python exception is set.
+ * \param parser The reader.
+ * \return New capsule reference or nullptr on errors.
+ */
+static PyObject* mappingCapsule(const erg::Reader* parser)
+{
+    std::shared_ptr<const uint8_t> data = parser->mappedData();
+    if(!data) {
+        PyErr_SetString(PyExc_RuntimeError, "The file is not memory mapped: views are not available.");
+        return nullptr;
+    }
+
+    std::shared_ptr<const uint8_t>* owner = new std::shared_ptr<const uint8_t>(data);
+    PyObject* capsule = PyCapsule_New(owner, MAPPING_CAPSULE, releaseMapping);
+    if(capsule==nullptr)
+        delete owner;
+    return capsule;
+}
+
+/*!
+ * \brief Read-only numpy array over a quantity in the mapped records.
+ *
+ * The array stride is the record size, so no data is copied and the pages
+ * are loaded only when they are accessed. Data stored with a non native
+ * byte order get a byte swapped dtype.
+ * \param parser The reader.
+ * \param qindex Index of the quantity.
+ * \param mapping Capsule returned by mappingCapsule(), used as array base.
+ * \return Numpy array or nullptr on errors.
+ */
+static PyObject* viewColumn(const erg::Reader* parser, const size_t qindex, PyObject* mapping)
+{
+    const uint8_t* records = reinterpret_cast<std::shared_ptr<const uint8_t>*>(
+                PyCapsule_GetPointer(mapping, MAPPING_CAPSULE))->get();
+
+    PyArray_Descr* descr = nullptr;
+    size_t offset = 0;
+    try {
+        descr = PyArray_DescrFromType(ergType2npyType(parser->quantityType(qindex)));
+        offset = parser->quantityOffset(qindex);
+    } catch (std::runtime_error& e) {
+        PyErr_SetString(PyExc_NameError, e.what());
+        return nullptr;
+    }
+
+    const bool bigEndianData = parser->byteOrder()==erg::ByteOrder::BigEndian;
+    if(bigEndianData!=(NPY_BYTE_ORDER==NPY_BIG_ENDIAN)) {
+        PyArray_Descr* swapped = PyArray_DescrNewByteorder(descr, NPY_SWAP);
+        Py_DecRef((PyObject*)descr);
+        if(swapped==nullptr)
+            return nullptr;
+        descr = swapped;
+    }
+
+    npy_intp rows = parser->records();
+    npy_intp stride = parser->recordSize();
+    // No flags: the array is not writeable
+    PyObject* array = PyArray_NewFromDescr(&PyArray_Type, descr, 1, &rows, &stride,
+                                           const_cast<uint8_t*>(records + offset), 0, nullptr);
+    if(array==nullptr)
+        return nullptr;
+
+    Py_IncRef(mapping);
+    if(PyArray_SetBaseObject((PyArrayObject*)array, mapping)<0) {
+        Py_DecRef(array);
+        return nullptr;
+    }
+    return array;
+}
+
+/*!
+ * \brief Numpy views over a set of quantities in the mapped records.
+ * \param parser The reader.
+ * \param qindices Indices of the quantities.
+ * \return Dict of numpy arrays with the quantity names as keys or nullptr on errors.
+ * \see viewColumn()
+ */
+static PyObject* viewColumns(const erg::Reader* parser, const std::vector<size_t>& qindices)
+{
+    PyObject* mapping = mappingCapsule(parser);
+    if(mapping==nullptr)
+        return nullptr;
+
+    PyObject* dict = PyDict_New();
+    for(size_t qindex: qindices)
+    {
+        PyObject* array = viewColumn(parser, qindex, mapping);
+        if(array==nullptr) {
+            Py_DecRef(dict);
+            Py_DecRef(mapping);
+            return nullptr;
+        }
+        PyDict_SetItemString(dict, parser->quantityName(qindex).c_str(), array);
+        Py_DecRef(array);
+    }
+
+    Py_DecRef(mapping);
+    return dict;
+}
+
+
+PyFUNC py_read(PyObject* self, PyObject* args, PyObject* keywds)
+{
+    PyObject* filename = nullptr;
+    PyObject* columns = nullptr;
+    PyObject* dtype = nullptr;
+    static char* kwlist[] = {"filename", "columns", "dtype", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "O|OO", kwlist, &filename, &columns, &dtype))
+        return nullptr;
+
+    int npyType = -1;
+    if(!dtypeFromPyObject(dtype, npyType))
+        return nullptr;
+
+    PyObject* noArgs = PyTuple_New(0);
+    Reader* pyReader = (Reader*)PyObject_CallObject((PyObject*)&pyerg_ReaderType, noArgs);
+
+    PyObject* ret = Parser_open(pyReader, filename);
+    if(ret==nullptr) {
+        Py_DecRef(noArgs);
+        Py_DecRef((PyObject*)pyReader);
+        return nullptr;
+    }
+
+    Py_DecRef(ret);
+
+    PyObject* data = nullptr;
+    if((columns==nullptr || columns==Py_None) && npyType<0) {
+        data = Parser_readAll(pyReader, noArgs, nullptr);
+    } else {
+        std::vector<size_t> qindices;
+        if(columns==nullptr || columns==Py_None) {
+            for(size_t i=0; i<pyReader->parser->numQuanities(); ++i)
+                qindices.push_back(i);
+        } else {
+            qindices = indicesFromPyObject(pyReader->parser, columns);
+        }
+        if(PyErr_Occurred()==nullptr)
+            data = readColumns(pyReader, qindices, 0, pyReader->parser->records(), 1, npyType);
+    }
+    Py_DecRef(noArgs);
+    Py_DecRef((PyObject*)pyReader);
+    return data;
+
+    /*
+    // self is unused.
+    if(PyUnicode_Check(filename)==false) {
+        PyErr_SetString(PyExc_NameError, "The input arguments must be a string");
+        return nullptr;
+    }
+
+    const char* filenameStr = PyUnicode_AsUTF8(filename);
+    erg::Reader parser;
+
+    // Error variable: used to check if C++ exceptions are thrown.
+    std::string error;
+
+    // Release the GIL because the open function is an I/O
+    // operation that read a file.
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            parser.open(filenameStr);
+        } catch (std::runtime_error e) {
+            error = e.what();
+        }
+    // Reacquire the GIL
+    Py_END_ALLOW_THREADS;
+
+    // Check for exceptions
+    if(error.length()>0) {
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+
+    // Allocate a Dict of numpy arrays as the returned value.
+    // Load all the numpy array raw data pointer for passing to
+    // the erg::Parser::readAll() function.
+    const size_t numQuantities = parser.numQuanities();
+    npy_intp rows = parser.records();
+    std::vector<uint8_t*> dataWrapper;
+    std::vector<size_t> sizeWrapper;
+    PyObject* map = PyDict_New();
+    for(size_t i=0; i<numQuantities; ++i)
+    {
+        int type = ergType2npyType(parser.quantityType(i));
+        PyObject* array = PyArray_SimpleNew(1, &rows, type);
+
+        void* d = PyArray_DATA((PyArrayObject*)array);
+        dataWrapper.push_back(reinterpret_cast<uint8_t*>(d));
+        sizeWrapper.push_back(PyArray_NBYTES((PyArrayObject*)array));
+
+        std::string name = parser.quantityName(i);
+        PyDict_SetItemString(map, name.c_str(), array);
+
+        // No need to decref the array because i never incrref it.
+    }
+
+    // Reset error variable, it should be already empty...
+    error.clear();
+
+    // Release the GIL because the readAll function is an I/O
+    // operation that read a file.
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            parser.readAll(dataWrapper, sizeWrapper);
+        } catch(std::runtime_error e) {
+            error = e.what();
+        }
+    // Reacquire the GIL
+    Py_END_ALLOW_THREADS;
+
+    // Check for exceptions
+    if(error.length()>0) {
+        Py_DecRef(map);
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+
+    return map;
+    */
+}
+
+PyFUNC py_can_read(PyObject* self, PyObject* filename)
+{
+    // self is unused.
+    if(PyUnicode_Check(filename)==false) {
+        PyErr_SetString(PyExc_NameError, "The input arguments must be a string");
+        return nullptr;
+    }
+
+    const char* filenameStr = PyUnicode_AsUTF8(filename);
+    // Flag for check for exceptions in file opening
+    bool error = false;
+
+    // Release the GIL because the open function is an I/O
+    // operation that read a file.
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            // Check only the headers: if the file is valid,
+            // no exceptions are thrown
+            erg::probe(filenameStr);
+        } catch(...) {
+            error = true;
+        }
+    // Reacquire the GIL
+    Py_END_ALLOW_THREADS;
+
+    if(error) {
+        Py_RETURN_FALSE;
+    }
+
+    Py_RETURN_TRUE;
+}
+
+PyFUNC py_probe(PyObject* self, PyObject* filename)
+{
+    // self is unused.
+    if(PyUnicode_Check(filename)==false) {
+        PyErr_SetString(PyExc_NameError, "The input arguments must be a string");
+        return nullptr;
+    }
+
+    const char* filenameStr = PyUnicode_AsUTF8(filename);
+    erg::ProbeInfo info;
+    std::string error;
+
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            info = erg::probe(filenameStr);
+        } catch(std::exception& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+
+    if(error.length()>0) {
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+
+    return Py_BuildValue("{s:s,s:s,s:n,s:n}",
+                         "format", info.format==erg::Format::Erg ? "erg" : "fortran",
+                         "byteOrder", info.byteOrder==erg::ByteOrder::LittelEndian ? "little" : "big",
+                         "recordSize", static_cast<Py_ssize_t>(info.recordSize),
+                         "records", static_cast<Py_ssize_t>(info.records));
+}
+
+PyFUNC py_open_view(PyObject* self, PyObject* filename)
+{
+    // self is unused.
+    PyObject* noArgs = PyTuple_New(0);
+    Reader* pyReader = (Reader*)PyObject_CallObject((PyObject*)&pyerg_ReaderType, noArgs);
+    Py_DecRef(noArgs);
+
+    PyObject* ret = Parser_open(pyReader, filename);
+    if(ret==nullptr) {
+        Py_DecRef((PyObject*)pyReader);
+        return nullptr;
+    }
+    Py_DecRef(ret);
+
+    std::vector<size_t> qindices;
+    for(size_t i=0; i<pyReader->parser->numQuanities(); ++i)
+        qindices.push_back(i);
+
+    // The views keep the mapping alive after the reader is destroyed.
+    PyObject* data = viewColumns(pyReader->parser, qindices);
+    Py_DecRef((PyObject*)pyReader);
+    return data;
+}
+
+/*!
+ * \brief List of strings from a Python sequence.
+ *
+ * If errors happens during the parsing, a Python exception is set.
+ * \param arg Sequence of strings.
+ * \param[out] strings The strings.
+ * \return `false` on errors.
+ */
+static bool stringsFromPyObject(PyObject* arg, std::vector<std::string>& strings)
+{
+    PyObject* seq = PySequence_Fast(arg, "Argument must be a list of strings.");
+    if(seq==nullptr)
+        return false;
+
+    const Py_ssize_t size = PySequence_Fast_GET_SIZE(seq);
+    for(Py_ssize_t i=0; i<size; ++i)
+    {
+        PyObject* item = PySequence_Fast_GET_ITEM(seq, i);
+        if(!PyUnicode_Check(item)) {
+            Py_DecRef(seq);
+            PyErr_SetString(PyExc_TypeError, "Argument must be a list of strings.");
+            return false;
+        }
+        strings.push_back(PyUnicode_AsUTF8(item));
+    }
+
+    Py_DecRef(seq);
+    return true;
+}
+
+//! Maximum number of threads of pyerg.read_many()
+static const int MAX_WORKERS = 1024;
+
+PyFUNC py_read_many(PyObject* self, PyObject* args, PyObject* keywds)
+{
+    // self is unused.
+    PyObject* paths = nullptr;
+    PyObject* columns = nullptr;
+    Py_ssize_t workers = 0;
+    Py_ssize_t chunk = 262144;
+    static char* kwlist[] = {"paths", "columns", "workers", "chunk", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "O|Onn", kwlist, &paths, &columns, &workers, &chunk))
+        return nullptr;
+
+    if(workers<0 || workers>MAX_WORKERS) {
+        PyErr_Format(PyExc_ValueError, "The number of workers must be between 0 and %d.", MAX_WORKERS);
+        return nullptr;
+    }
+    if(chunk<=0) {
+        PyErr_SetString(PyExc_ValueError, "The chunks must contain at least one row.");
+        return nullptr;
+    }
+
+    std::vector<std::string> filenames;
+    std::vector<std::string> names;
+    if(!stringsFromPyObject(paths, filenames))
+        return nullptr;
+    if(columns!=nullptr && columns!=Py_None && !stringsFromPyObject(columns, names))
+        return nullptr;
+
+    BatchIterator* it = PyObject_New(BatchIterator, &pyerg_BatchIteratorType);
+    if(it==nullptr)
+        return nullptr;
+
+    // The threads start reading the files before the first iteration
+    it->batch = nullptr;
+    try {
+        it->batch = new erg::MultiReader(filenames, names, workers, chunk);
+    } catch(std::exception& e) {
+        Py_DecRef((PyObject*)it);
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    return (PyObject*)it;
+}
+
+PyFUNC py_read_segments(PyObject* self, PyObject* args, PyObject* keywds)
+{
+    // self is unused.
+    PyObject* paths = nullptr;
+    PyObject* columns = nullptr;
+    Py_ssize_t start = 0;
+    Py_ssize_t count = -1;
+    PyObject* dtype = nullptr;
+    Py_ssize_t threads = 1;
+    static char* kwlist[] = {"paths", "columns", "start", "count", "dtype", "threads", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "O|OnnOn", kwlist, &paths, &columns, &start, &count,
+                                    &dtype, &threads))
+        return nullptr;
+
+    if(start<0 || threads<0) {
+        PyErr_SetString(PyExc_ValueError, "The start and the number of threads can't be negative.");
+        return nullptr;
+    }
+
+    int npyType = -1;
+    if(!dtypeFromPyObject(dtype, npyType))
+        return nullptr;
+
+    std::vector<std::string> filenames;
+    std::vector<std::string> names;
+    if(!stringsFromPyObject(paths, filenames))
+        return nullptr;
+    if(columns!=nullptr && columns!=Py_None && !stringsFromPyObject(columns, names))
+        return nullptr;
+
+    erg::SegmentedReader run;
+    run.setThreads(threads);
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            run.open(filenames);
+        } catch (std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+
+    if(!error.empty()) {
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+
+    std::vector<size_t> qindices;
+    try {
+        if(names.empty()) {
+            for(size_t i=0; i<run.numQuanities(); ++i)
+                qindices.push_back(i);
+        } else {
+            for(const std::string& name: names)
+                qindices.push_back(run.index(name));
+        }
+    } catch (std::runtime_error& e) {
+        PyErr_SetString(PyExc_NameError, e.what());
+        return nullptr;
+    }
+
+    // A single array for each quantity: the segments are read in place
+    const size_t from = start;
+    const size_t rows = run.rangeSize(from, count<0 ? run.records() : count);
+    std::vector<std::string> qnames;
+    std::vector<int> types;
+    try {
+        for(size_t qindex: qindices)
+        {
+            qnames.push_back(run.quantityName(qindex));
+            types.push_back(npyType>=0 ? npyType : ergType2npyType(run.quantityType(qindex)));
+        }
+    } catch (std::runtime_error& e) {
+        PyErr_SetString(PyExc_NameError, e.what());
+        return nullptr;
+    }
+    std::vector<uint8_t*> values;
+    std::vector<size_t> sizes;
+    PyObject* dict = newColumns(qnames, types, rows, values, sizes);
+    if(dict==nullptr)
+        return nullptr;
+
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            if(npyType>=0)
+                readTyped(&run, npyType, qindices, from, rows, 1, values);
+            else
+                run.read(qindices, from, rows, values, sizes);
+        } catch (std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+
+    if(!error.empty()) {
+        Py_DecRef(dict);
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+    return dict;
+}
+
+/*!
+ * \brief ERG type of a numpy type.
+ * \param descr Numpy type, in native byte order.
+ * \return The ERG type or erg::Type::Void if the type can't be stored. Booleans are stored as erg::Type::Uint8.
+ */
+static erg::Type npyType2ergType(const PyArray_Descr* descr)
+{
+    const char kind = descr->kind;
+    const int size = PyDataType_ELSIZE(descr);
+    if(kind=='f' && size==4)
+        return erg::Type::Float;
+    if(kind=='f' && size==8)
+        return erg::Type::Double;
+    if(kind=='i' && size==1)
+        return erg::Type::Int8;
+    if(kind=='i' && size==2)
+        return erg::Type::Int16;
+    if(kind=='i' && size==4)
+        return erg::Type::Int32;
+    if(kind=='i' && size==8)
+        return erg::Type::Int64;
+    if((kind=='u' || kind=='b') && size==1)
+        return erg::Type::Uint8;
+    if(kind=='u' && size==2)
+        return erg::Type::Uint16;
+    if(kind=='u' && size==4)
+        return erg::Type::Uint32;
+    if(kind=='u' && size==8)
+        return erg::Type::Uint64;
+    return erg::Type::Void;
+}
+
+PyFUNC py_write(PyObject* self, PyObject* args, PyObject* keywds)
+{
+    // self is unused.
+    const char* filename = nullptr;
+    PyObject* data = nullptr;
+    PyObject* units = nullptr;
+    const char* byteorder = "little";
+    static char* kwlist[] = {"filename", "data", "units", "byteorder", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "sO|Os", kwlist, &filename, &data, &units, &byteorder))
+        return nullptr;
+
+    if(!PyDict_Check(data) || (units!=nullptr && units!=Py_None && !PyDict_Check(units))) {
+        PyErr_SetString(PyExc_TypeError, "The data and the units must be a dict with the dataset names as keys.");
+        return nullptr;
+    }
+
+    erg::ByteOrder byteOrder = erg::ByteOrder::LittelEndian;
+    const std::string order = byteorder;
+    if(order=="big") {
+        byteOrder = erg::ByteOrder::BigEndian;
+    } else if(order!="little") {
+        PyErr_SetString(PyExc_ValueError, ("Unknown byte order: "+order).c_str());
+        return nullptr;
+    }
+
+    // Contiguous native arrays: numpy copies only the arrays that are not
+    std::vector<erg::Quantity> quantities;
+    std::vector<PyObject*> arrays;
+    std::vector<const void*> columns;
+    auto release = [&arrays]() {
+        for(PyObject* array: arrays)
+            Py_DecRef(array);
+    };
+
+    PyObject* key = nullptr;
+    PyObject* value = nullptr;
+    Py_ssize_t pos = 0;
+    npy_intp rows = -1;
+    while(PyDict_Next(data, &pos, &key, &value))
+    {
+        if(!PyUnicode_Check(key)) {
+            release();
+            PyErr_SetString(PyExc_TypeError, "The dataset names must be strings.");
+            return nullptr;
+        }
+        const std::string name = PyUnicode_AsUTF8(key);
+
+        PyObject* array = PyArray_FROM_OF(value, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_NOTSWAPPED);
+        if(array==nullptr) {
+            release();
+            return nullptr;
+        }
+        arrays.push_back(array);
+
+        PyArrayObject* a = (PyArrayObject*)array;
+        erg::Quantity q;
+        q.name = name;
+        q.type = npyType2ergType(PyArray_DESCR(a));
+        if(q.type==erg::Type::Void || PyArray_NDIM(a)!=1) {
+            release();
+            PyErr_SetString(PyExc_TypeError, ("The dataset "+name+" must be a 1-D array of integers or floating point numbers.").c_str());
+            return nullptr;
+        }
+        if(rows>=0 && PyArray_DIM(a, 0)!=rows) {
+            release();
+            PyErr_SetString(PyExc_ValueError, "All the datasets must have the same length.");
+            return nullptr;
+        }
+        rows = PyArray_DIM(a, 0);
+
+        PyObject* unit = units!=nullptr && units!=Py_None ? PyDict_GetItem(units, key) : nullptr;
+        if(unit!=nullptr) {
+            if(!PyUnicode_Check(unit)) {
+                release();
+                PyErr_SetString(PyExc_TypeError, "The units must be strings.");
+                return nullptr;
+            }
+            q.unit = PyUnicode_AsUTF8(unit);
+        }
+
+        quantities.push_back(q);
+        columns.push_back(PyArray_DATA(a));
+    }
+
+    // The rows are transposed into the write buffer in C++
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            erg::Writer writer(filename, quantities, byteOrder);
+            writer.writeColumns(columns, rows>0 ? rows : 0);
+            writer.close();
+        } catch (std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+    release();
+
+    if(!error.empty()) {
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+//! Name of the capsules that own the data of the arrays returned by read_many()
+static const char* BUFFER_CAPSULE = "pyerg.buffer";
+
+extern "C" void releaseBuffer(PyObject* capsule)
+{
+    delete reinterpret_cast<std::vector<uint8_t>*>(PyCapsule_GetPointer(capsule, BUFFER_CAPSULE));
+}
+
+/*!
+ * \brief Numpy array that takes the ownership of a buffer without copying it.
+ * \param data The buffer, left empty.
+ * \param rows Number of elements in the buffer.
+ * \param npyType Numpy type of the elements.
+ * \return Numpy array or nullptr on errors.
+ */
+static PyObject* bufferArray(std::vector<uint8_t>& data, npy_intp rows, const int npyType)
+{
+    if(rows==0)
+        return PyArray_SimpleNew(1, &rows, npyType);
+
+    std::vector<uint8_t>* owner = new std::vector<uint8_t>(std::move(data));
+    PyObject* capsule = PyCapsule_New(owner, BUFFER_CAPSULE, releaseBuffer);
+    if(capsule==nullptr) {
+        delete owner;
+        return nullptr;
+    }
+
+    PyObject* array = PyArray_SimpleNewFromData(1, &rows, npyType, owner->data());
+    if(array==nullptr) {
+        Py_DecRef(capsule);
+        return nullptr;
+    }
+    // The reference to the capsule is stolen
+    if(PyArray_SetBaseObject((PyArrayObject*)array, capsule)<0) {
+        Py_DecRef(array);
+        return nullptr;
+    }
+    return array;
+}
+
+extern "C" void BatchIterator_dealloc(BatchIterator* self)
+{
+    // Wait for the running tasks without blocking the other Python threads
+    Py_BEGIN_ALLOW_THREADS;
+        delete self->batch;
+    Py_END_ALLOW_THREADS;
+    PyObject_Del(self);
+}
+
+PyFUNC BatchIterator_next(BatchIterator* self)
+{
+    erg::FileResult result;
+    bool available = false;
+    Py_BEGIN_ALLOW_THREADS;
+        available = self->batch->next(result);
+    Py_END_ALLOW_THREADS;
+
+    // No exception set: the iteration stops
+    if(!available)
+        return nullptr;
+
+    if(!result.error.empty()) {
+        PyErr_SetString(PyExc_RuntimeError, (result.filename+": "+result.error).c_str());
+        return nullptr;
+    }
 
-PyFUNC py_read(PyObject* self, PyObject* filename)
+    PyObject* dict = PyDict_New();
+    for(size_t i=0; i<result.names.size(); ++i)
+    {
+        int type = 0;
+        try {
+            type = ergType2npyType(result.types[i]);
+        } catch (std::runtime_error& e) {
+            Py_DecRef(dict);
+            PyErr_SetString(PyExc_RuntimeError, (result.filename+": "+e.what()).c_str());
+            return nullptr;
+        }
+
+        PyObject* array = bufferArray(result.data[i], result.records, type);
+        if(array==nullptr) {
+            Py_DecRef(dict);
+            return nullptr;
+        }
+        PyDict_SetItemString(dict, result.names[i].c_str(), array);
+        Py_DecRef(array);
+    }
+
+    return Py_BuildValue("(sN)", result.filename.c_str(), dict);
+}
+
+extern "C" void ChunkIterator_dealloc(ChunkIterator* self)
+{
+    delete self->qindices;
+    Py_DecRef((PyObject*)self->reader);
+    PyObject_Del(self);
+}
+
+PyFUNC ChunkIterator_next(ChunkIterator* self)
+{
+    // No exception set: the iteration stops
+    const size_t count = self->reader->parser->rangeSize(self->next, self->rows);
+    if(count==0)
+        return nullptr;
+
+    PyObject* chunk = readColumns(self->reader, *self->qindices, self->next, count, 1, self->npyType);
+    if(chunk!=nullptr)
+        self->next += count;
+    return chunk;
+}
+
+extern "C" void Parser_dealloc(Reader* self)
+{
+    PyTypeObject *tp = Py_TYPE(self);
+    // free references and buffers here
+    delete self->parser;
+    tp->tp_free(self);
+    Py_DECREF(tp);
+}
+
+PyFUNC Parser_new(PyTypeObject* type, PyObject *args, PyObject *kwds)
+{
+    Reader* self = (Reader*)type->tp_alloc(type, 0);
+    if (self != nullptr) {
+        self->parser = new erg::Reader();
+    }
+
+    return (PyObject*)self;
+}
+
+extern "C" int Parser_init(Reader* self, PyObject *args, PyObject *kwds)
+{
+    PyObject* filename = nullptr;
+    PyObject* access = nullptr;
+    const char* sidecar = nullptr;
+    int lazy = 0;
+    static char* kwlist[] = {"filename", "access", "sidecar", "lazy", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|OOsp", kwlist, &filename, &access, &sidecar, &lazy))
+        return -1;
+
+    self->parser->setLazyOpen(lazy!=0);
+
+    if(sidecar!=nullptr) {
+        const std::string mode = sidecar;
+        if(mode=="ignore") {
+            self->parser->setSidecar(erg::Sidecar::Ignore);
+        } else if(mode=="use") {
+            self->parser->setSidecar(erg::Sidecar::Use);
+        } else if(mode=="build") {
+            self->parser->setSidecar(erg::Sidecar::Build);
+        } else {
+            PyErr_SetString(PyExc_ValueError, ("Unknown sidecar policy: "+mode).c_str());
+            return -1;
+        }
+    }
+
+    if(access!=nullptr && access!=Py_None) {
+        PyObject* result = Parser_setAccess(self, access);
+        if(result==nullptr)
+            return -1;
+        Py_DECREF(result);
+    }
+
+    if(filename!=nullptr && filename!=Py_None) {
+        // Initialize with a filename: open the file
+        PyObject* result = Parser_open(self, filename);
+        if(result==nullptr)
+            return -1;
+
+        // DecRef the None object
+        Py_DECREF(result);
+    }
+
+    return 0;
+}
+
+PyFUNC Parser_open(Reader* self, PyObject* filename)
+{
+    if(PyUnicode_Check(filename)==false) {
+        PyErr_SetString(PyExc_NameError, "The function arguments must be a string");
+        return nullptr;
+    }
+
+    if(!checkIdle(self))
+        return nullptr;
+
+    const char* filenameStr = PyUnicode_AsUTF8(filename);
+    std::string error;
+
+    // Release the GIL because the open function is an I/O
+    // operation that read a file.
+    self->opening = 1;
+    Py_BEGIN_ALLOW_THREADS
+        try {
+            self->parser->open(filenameStr);
+        } catch (std::runtime_error& FileOpenError) {
+            error = FileOpenError.what();
+        }
+    // Reacquire the GIL
+    Py_END_ALLOW_THREADS;
+    self->opening = 0;
+
+    if (error.length()>0) {
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+
+
+    Py_RETURN_NONE;
+}
+
+PyFUNC Parser_records(Reader* self)
+{
+    size_t records = self->parser->records();
+    return PyLong_FromSize_t(records);
+}
+
+PyFUNC Parser_recordSize(Reader* self)
+{
+    size_t recordSize = self->parser->recordSize();
+    return PyLong_FromSize_t(recordSize);
+}
+
+PyFUNC Parser_numQuanities(Reader* self)
+{
+    if(!loadQuantities(self))
+        return nullptr;
+
+    size_t numQ = self->parser->numQuanities();
+    return PyLong_FromSize_t(numQ);
+}
+
+PyFUNC Parser_setThreads(Reader* self, PyObject* arg)
+{
+    const size_t threads = PyLong_AsSize_t(arg);
+    if(PyErr_Occurred()!=nullptr || !checkIdle(self))
+        return nullptr;
+
+    self->parser->setThreads(threads);
+    Py_RETURN_NONE;
+}
+
+PyFUNC Parser_threads(Reader* self)
+{
+    return PyLong_FromSize_t(self->parser->threads());
+}
+
+PyFUNC Parser_setPrefetch(Reader* self, PyObject* arg)
+{
+    const size_t buffers = PyLong_AsSize_t(arg);
+    if(PyErr_Occurred()!=nullptr || !checkIdle(self))
+        return nullptr;
+
+    self->parser->setPrefetch(buffers);
+    Py_RETURN_NONE;
+}
+
+PyFUNC Parser_prefetch(Reader* self)
+{
+    return PyLong_FromSize_t(self->parser->prefetch());
+}
+
+PyFUNC Parser_setCacheSize(Reader* self, PyObject* arg)
+{
+    const size_t bytes = PyLong_AsSize_t(arg);
+    if(PyErr_Occurred()!=nullptr)
+        return nullptr;
+
+    self->parser->setCacheSize(bytes);
+    Py_RETURN_NONE;
+}
+
+PyFUNC Parser_cacheSize(Reader* self)
+{
+    return PyLong_FromSize_t(self->parser->cacheSize());
+}
+
+PyFUNC Parser_cacheStats(Reader* self)
+{
+    const erg::CacheStats stats = self->parser->cacheStats();
+    return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n}",
+                         "hits", (Py_ssize_t)stats.hits,
+                         "misses", (Py_ssize_t)stats.misses,
+                         "evictions", (Py_ssize_t)stats.evictions,
+                         "bytes", (Py_ssize_t)stats.bytes,
+                         "columns", (Py_ssize_t)stats.columns);
+}
+
+PyFUNC Parser_buildSidecar(Reader* self)
+{
+    if(!checkIdle(self))
+        return nullptr;
+
+    std::string error;
+    self->opening = 1;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            self->parser->buildSidecar();
+        } catch(std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+    self->opening = 0;
+
+    if(error.length()>0) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyFUNC Parser_hasSidecar(Reader* self)
+{
+    if(self->parser->hasSidecar()) {
+        Py_RETURN_TRUE;
+    }
+
+    Py_RETURN_FALSE;
+}
+
+PyFUNC Parser_recordAt(Reader* self, PyObject* arg)
+{
+    const double time = PyFloat_AsDouble(arg);
+    if(PyErr_Occurred()!=nullptr)
+        return nullptr;
+
+    if(!beginRead(self))
+        return nullptr;
+
+    size_t record = 0;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            record = self->parser->recordAt(time);
+        } catch(std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+    endRead(self);
+
+    if(error.length()>0) {
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+    return PyLong_FromSize_t(record);
+}
+
+PyFUNC Parser_readTimeRange(Reader* self, PyObject* args, PyObject* keywds)
+{
+    double t0 = 0.0;
+    double t1 = 0.0;
+    PyObject* columns = nullptr;
+    PyObject* dtype = nullptr;
+    static char* kwlist[] = {"t0", "t1", "columns", "dtype", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "dd|OO", kwlist, &t0, &t1, &columns, &dtype))
+        return nullptr;
+
+    int npyType = -1;
+    if(!dtypeFromPyObject(dtype, npyType))
+        return nullptr;
+
+    std::vector<size_t> qindices;
+    if(columns==nullptr || columns==Py_None) {
+        for(size_t i=0; i<self->parser->numQuanities(); ++i)
+            qindices.push_back(i);
+    } else {
+        qindices = indicesFromPyObject(self->parser, columns);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
+    }
+
+    if(!beginRead(self))
+        return nullptr;
+
+    size_t from = 0;
+    size_t count = 0;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            count = self->parser->timeRange(t0, t1, from);
+        } catch(std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+    endRead(self);
+
+    if(error.length()>0) {
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+    return readColumns(self, qindices, from, count, 1, npyType);
+}
+
+//! Names of the interpolation methods, in the order of erg::Interpolation
+static const char* INTERPOLATION_NAMES[] = {"nearest", "linear", "previous"};
+
+PyFUNC Parser_resample(Reader* self, PyObject* args, PyObject* keywds)
+{
+    double t0 = 0.0;
+    double t1 = 0.0;
+    double dt = 0.0;
+    PyObject* columns = nullptr;
+    const char* method = "linear";
+    static char* kwlist[] = {"t0", "t1", "dt", "columns", "method", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "ddd|Os", kwlist, &t0, &t1, &dt, &columns, &method))
+        return nullptr;
+
+    if(!(dt>0.0)) {
+        PyErr_SetString(PyExc_ValueError, "The time step must be positive.");
+        return nullptr;
+    }
+
+    const size_t nMethods = sizeof(INTERPOLATION_NAMES) / sizeof(INTERPOLATION_NAMES[0]);
+    size_t m = 0;
+    while(m<nMethods && std::strcmp(method, INTERPOLATION_NAMES[m])!=0)
+        ++m;
+    if(m==nMethods) {
+        PyErr_Format(PyExc_ValueError, "Unknown interpolation method '%s'.", method);
+        return nullptr;
+    }
+
+    std::vector<size_t> qindices;
+    if(columns==nullptr || columns==Py_None) {
+        for(size_t i=0; i<self->parser->numQuanities(); ++i)
+        {
+            if(self->parser->quantityType(i)!=erg::Type::Void)
+                qindices.push_back(i);
+        }
+    } else {
+        qindices = indicesFromPyObject(self->parser, columns);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
+    }
+
+    // Allocate a Dict of numpy arrays on the grid
+    npy_intp points = erg::Reader::gridSize(t0, t1, dt);
+    std::vector<std::string> names;
+    try {
+        for(size_t qindex: qindices)
+            names.push_back(self->parser->quantityName(qindex));
+    } catch(std::runtime_error& e) {
+        PyErr_SetString(PyExc_NameError, e.what());
+        return nullptr;
+    }
+    std::vector<uint8_t*> data;
+    std::vector<size_t> sizes;
+    PyObject* map = newColumns(names, std::vector<int>(names.size(), NPY_FLOAT64), points, data, sizes);
+    if(map==nullptr)
+        return nullptr;
+    std::vector<double*> dataWrapper;
+    for(uint8_t* d: data)
+        dataWrapper.push_back(reinterpret_cast<double*>(d));
+
+    if(!beginRead(self)) {
+        Py_DecRef(map);
+        return nullptr;
+    }
+
+    size_t written = 0;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            written = self->parser->resample(qindices, t0, t1, dt, static_cast<erg::Interpolation>(m), dataWrapper);
+        } catch(std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+    endRead(self);
+
+    if(error.length()==0 && written<static_cast<size_t>(points))
+        error = "The file contains no records.";
+    if(error.length()>0) {
+        Py_DecRef(map);
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+
+    return map;
+}
+
+PyFUNC Parser_buildTimeIndex(Reader* self, PyObject* args, PyObject* keywds)
 {
-    PyObject* args = PyTuple_New(0);
-    Reader* pyReader = (Reader*)PyObject_CallObject((PyObject*)&pyerg_ReaderType, args);
-    Py_DecRef(args);
+    Py_ssize_t block = 4096;
+    static char* kwlist[] = {"block", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|n", kwlist, &block))
+        return nullptr;
+    if(block<=0) {
+        PyErr_SetString(PyExc_ValueError, "The number of records of each block must be positive.");
+        return nullptr;
+    }
+
+    if(!checkIdle(self))
+        return nullptr;
+
+    std::string error;
+    self->opening = 1;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            self->parser->buildTimeIndex(static_cast<size_t>(block));
+        } catch(std::runtime_error& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+    self->opening = 0;
 
-    PyObject* ret = Parser_open(pyReader, filename);
-    if(ret==nullptr)
+    if(error.length()>0) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
         return nullptr;
+    }
+    Py_RETURN_NONE;
+}
 
-    Py_DecRef(ret);
+PyFUNC Parser_hasTimeIndex(Reader* self)
+{
+    if(self->parser->hasTimeIndex()) {
+        Py_RETURN_TRUE;
+    }
 
-    PyObject* data = Parser_readAll(pyReader);
-    Py_DecRef((PyObject*)pyReader);
-    return data;
+    Py_RETURN_FALSE;
+}
 
-    /*
-    // self is unused.
-    if(PyUnicode_Check(filename)==false) {
-        PyErr_SetString(PyExc_NameError, "The input arguments must be a string");
+PyFUNC Parser_where(Reader* self, PyObject* arg)
+{
+    std::vector<erg::Predicate> predicates;
+    if(!predicatesFromPyObject(self->parser, arg, predicates))
         return nullptr;
-    }
 
-    const char* filenameStr = PyUnicode_AsUTF8(filename);
-    erg::Reader parser;
+    if(!beginRead(self))
+        return nullptr;
 
-    // Error variable: used to check if C++ exceptions are thrown.
+    std::vector<size_t> records;
     std::string error;
-
-    // Release the GIL because the open function is an I/O
-    // operation that read a file.
     Py_BEGIN_ALLOW_THREADS;
         try {
-            parser.open(filenameStr);
-        } catch (std::runtime_error e) {
+            records = self->parser->where(predicates);
+        } catch(std::runtime_error& e) {
             error = e.what();
         }
-    // Reacquire the GIL
     Py_END_ALLOW_THREADS;
+    endRead(self);
 
-    // Check for exceptions
     if(error.length()>0) {
         PyErr_SetString(PyExc_NameError, error.c_str());
         return nullptr;
     }
 
-    // Allocate a Dict of numpy arrays as the returned value.
-    // Load all the numpy array raw data pointer for passing to
-    // the erg::Parser::readAll() function.
-    const size_t numQuantities = parser.numQuanities();
-    npy_intp rows = parser.records();
-    std::vector<uint8_t*> dataWrapper;
-    std::vector<size_t> sizeWrapper;
-    PyObject* map = PyDict_New();
-    for(size_t i=0; i<numQuantities; ++i)
-    {
-        int type = ergType2npyType(parser.quantityType(i));
-        PyObject* array = PyArray_SimpleNew(1, &rows, type);
+    npy_intp rows = records.size();
+    PyArrayObject* array = (PyArrayObject*)PyArray_SimpleNew(1, &rows, NPY_INTP);
+    if(array==nullptr)
+        return nullptr;
+    npy_intp* data = (npy_intp*)PyArray_DATA(array);
+    for(size_t i=0; i<records.size(); ++i)
+        data[i] = static_cast<npy_intp>(records[i]);
+    return (PyObject*)array;
+}
 
-        void* d = PyArray_DATA((PyArrayObject*)array);
-        dataWrapper.push_back(reinterpret_cast<uint8_t*>(d));
-        sizeWrapper.push_back(PyArray_NBYTES((PyArrayObject*)array));
+PyFUNC Parser_readWhere(Reader* self, PyObject* args, PyObject* keywds)
+{
+    PyObject* conditions = nullptr;
+    PyObject* columns = nullptr;
+    PyObject* dtype = nullptr;
+    static char* kwlist[] = {"conditions", "columns", "dtype", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "O|OO", kwlist, &conditions, &columns, &dtype))
+        return nullptr;
 
-        std::string name = parser.quantityName(i);
-        PyDict_SetItemString(map, name.c_str(), array);
+    int npyType = -1;
+    if(!dtypeFromPyObject(dtype, npyType))
+        return nullptr;
 
-        // No need to decref the array because i never incrref it.
+    std::vector<erg::Predicate> predicates;
+    if(!predicatesFromPyObject(self->parser, conditions, predicates))
+        return nullptr;
+
+    std::vector<size_t> qindices;
+    if(columns==nullptr || columns==Py_None) {
+        for(size_t i=0; i<self->parser->numQuanities(); ++i)
+            qindices.push_back(i);
+    } else {
+        qindices = indicesFromPyObject(self->parser, columns);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
     }
 
-    // Reset error variable, it should be already empty...
-    error.clear();
+    if(!beginRead(self))
+        return nullptr;
 
-    // Release the GIL because the readAll function is an I/O
-    // operation that read a file.
+    std::vector<std::vector<uint8_t>> values;
+    size_t count = 0;
+    std::string error;
     Py_BEGIN_ALLOW_THREADS;
         try {
-            parser.readAll(dataWrapper, sizeWrapper);
-        } catch(std::runtime_error e) {
+            count = self->parser->readWhere(predicates, qindices, values);
+        } catch(std::runtime_error& e) {
             error = e.what();
         }
-    // Reacquire the GIL
     Py_END_ALLOW_THREADS;
+    endRead(self);
 
-    // Check for exceptions
     if(error.length()>0) {
-        Py_DecRef(map);
         PyErr_SetString(PyExc_NameError, error.c_str());
         return nullptr;
     }
 
+    PyObject* map = PyDict_New();
+    npy_intp rows = count;
+    for(size_t i=0; i<qindices.size(); ++i)
+    {
+        const int type = ergType2npyType(self->parser->quantityType(qindices[i]));
+        PyObject* array = PyArray_SimpleNew(1, &rows, type);
+        if(array!=nullptr) {
+            std::memcpy(PyArray_DATA((PyArrayObject*)array), values[i].data(), values[i].size());
+            // Free the raw data as soon as it has been copied
+            std::vector<uint8_t>().swap(values[i]);
+            if(npyType>=0 && npyType!=type) {
+                PyObject* converted = PyArray_Cast((PyArrayObject*)array, npyType);
+                Py_DecRef(array);
+                array = converted;
+            }
+        }
+        if(array==nullptr) {
+            Py_DecRef(map);
+            return nullptr;
+        }
+        PyDict_SetItemString(map, self->parser->quantityName(qindices[i]).c_str(), array);
+        Py_DecRef(array);
+    }
+
     return map;
-    */
 }
 
-PyFUNC py_can_read(PyObject* self, PyObject* filename)
+PyFUNC Parser_buildZoneMap(Reader* self, PyObject* args, PyObject* keywds)
 {
-    // self is unused.
-    if(PyUnicode_Check(filename)==false) {
-        PyErr_SetString(PyExc_NameError, "The input arguments must be a string");
+    Py_ssize_t block = 4096;
+    int persist = 1;
+    static char* kwlist[] = {"block", "persist", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|np", kwlist, &block, &persist))
+        return nullptr;
+    if(block<=0) {
+        PyErr_SetString(PyExc_ValueError, "The number of records of each block must be positive.");
         return nullptr;
     }
 
-    const char* filenameStr = PyUnicode_AsUTF8(filename);
-    // Flag for check for exceptions in file opening
-    bool error = false;
+    if(!checkIdle(self))
+        return nullptr;
 
-    // Release the GIL because the open function is an I/O
-    // operation that read a file.
+    std::string error;
+    self->opening = 1;
     Py_BEGIN_ALLOW_THREADS;
         try {
-            // Try to read the file: if the file is valid,
-            // no exceptions are thrown
-            erg::Reader parser;
-            parser.open(filenameStr);
-        } catch(...) {
-            error = true;
+            self->parser->buildZoneMap(static_cast<size_t>(block), persist!=0);
+        } catch(std::runtime_error& e) {
+            error = e.what();
         }
-    // Reacquire the GIL
     Py_END_ALLOW_THREADS;
+    self->opening = 0;
 
-    if(error) {
-        Py_RETURN_FALSE;
+    if(error.length()>0) {
+        PyErr_SetString(PyExc_RuntimeError, error.c_str());
+        return nullptr;
     }
-
-    Py_RETURN_TRUE;
-}
-
-
-extern "C" void Parser_dealloc(Reader* self)
-{
-    PyTypeObject *tp = Py_TYPE(self);
-    // free references and buffers here
-    tp->tp_free(self);
-    Py_DECREF(tp);
+    Py_RETURN_NONE;
 }
 
-PyFUNC Parser_new(PyTypeObject* type, PyObject *args, PyObject *kwds)
+PyFUNC Parser_hasZoneMap(Reader* self)
 {
-    Reader* self = (Reader*)type->tp_alloc(type, 0);
-    if (self != nullptr) {
-        self->parser = new erg::Reader();
+    if(self->parser->hasZoneMap()) {
+        Py_RETURN_TRUE;
     }
 
-    return (PyObject*)self;
+    Py_RETURN_FALSE;
 }
 
-extern "C" int Parser_init(Reader* self, PyObject *args, PyObject *kwds)
+PyFUNC Parser_stats(Reader* self, PyObject* args, PyObject* keywds)
 {
-    if(args!=nullptr && PyTuple_Size(args)==1) {
-        // Initialize with a filename: open the file
-        PyObject* filename = PyTuple_GetItem(args, 0);
-
-        PyObject* result = Parser_open(self, filename);
-        if(result==nullptr)
-            return -1;
+    PyObject* columns = nullptr;
+    PyObject* objStart = nullptr;
+    Py_ssize_t count = -1;
+    Py_ssize_t bins = 0;
+    PyObject* range = nullptr;
+    static char* kwlist[] = {"columns", "start", "count", "bins", "range", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|OOnnO", kwlist, &columns, &objStart, &count, &bins, &range))
+        return nullptr;
 
-        // DecRef the None object
-        Py_DECREF(result);
+    erg::StatsOptions options;
+    if(bins<0) {
+        PyErr_SetString(PyExc_ValueError, "The number of bins can't be negative.");
+        return nullptr;
+    }
+    options.bins = bins;
+    if(bins>0) {
+        if(range==nullptr || range==Py_None || !PyArg_ParseTuple(range, "dd", &options.low, &options.high)) {
+            PyErr_Clear();
+            PyErr_SetString(PyExc_ValueError, "The histogram needs a (low, high) range.");
+            return nullptr;
+        }
+        if(!(options.high>options.low)) {
+            PyErr_SetString(PyExc_ValueError, "The histogram range must not be empty.");
+            return nullptr;
+        }
     }
 
-    return 0;
-}
+    std::vector<size_t> qindices;
+    if(columns==nullptr || columns==Py_None) {
+        for(size_t i=0; i<self->parser->numQuanities(); ++i)
+        {
+            if(self->parser->quantityType(i)!=erg::Type::Void)
+                qindices.push_back(i);
+        }
+    } else {
+        qindices = indicesFromPyObject(self->parser, columns);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
+    }
 
-PyFUNC Parser_open(Reader* self, PyObject* filename)
-{
-    if(PyUnicode_Check(filename)==false) {
-        PyErr_SetString(PyExc_NameError, "The function arguments must be a string");
+    size_t from = 0;
+    size_t rows = 0;
+    size_t stride = 1;
+    if(!rangeFromPyObject(self, objStart, count, 1, from, rows, stride))
+        return nullptr;
+    if(stride!=1) {
+        PyErr_SetString(PyExc_ValueError, "The statistics are computed on contiguous records.");
         return nullptr;
     }
 
-    const char* filenameStr = PyUnicode_AsUTF8(filename);
-    std::string error;
+    if(!beginRead(self))
+        return nullptr;
 
-    // Release the GIL because the open function is an I/O
-    // operation that read a file.
-    Py_BEGIN_ALLOW_THREADS
+    std::vector<erg::Stats> stats;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS;
         try {
-            self->parser->open(filenameStr);
-        } catch (std::runtime_error& FileOpenError) {
-            error = FileOpenError.what();
+            stats = self->parser->stats(qindices, from, rows, options);
+        } catch(std::runtime_error& e) {
+            error = e.what();
         }
-    // Reacquire the GIL
     Py_END_ALLOW_THREADS;
+    endRead(self);
 
-    if (error.length()>0) {
+    if(error.length()>0) {
         PyErr_SetString(PyExc_NameError, error.c_str());
         return nullptr;
     }
 
+    PyObject* map = PyDict_New();
+    for(size_t i=0; i<qindices.size(); ++i)
+    {
+        const erg::Stats& s = stats[i];
+        PyObject* item = Py_BuildValue("{s:n,s:n,s:d,s:d,s:d,s:d,s:d}",
+                                       "count", (Py_ssize_t)s.count,
+                                       "nan", (Py_ssize_t)s.nans,
+                                       "min", s.min,
+                                       "max", s.max,
+                                       "mean", s.mean,
+                                       "std", s.stddev,
+                                       "rms", s.rms);
+        if(item!=nullptr && options.bins>0) {
+            npy_intp n = s.histogram.size();
+            PyObject* histogram = PyArray_SimpleNew(1, &n, NPY_INTP);
+            if(histogram==nullptr) {
+                Py_DecRef(item);
+                item = nullptr;
+            } else {
+                npy_intp* data = (npy_intp*)PyArray_DATA((PyArrayObject*)histogram);
+                for(size_t b=0; b<s.histogram.size(); ++b)
+                    data[b] = static_cast<npy_intp>(s.histogram[b]);
+                PyDict_SetItemString(item, "histogram", histogram);
+                Py_DecRef(histogram);
+            }
+        }
+        if(item==nullptr) {
+            Py_DecRef(map);
+            return nullptr;
+        }
+        PyDict_SetItemString(map, self->parser->quantityName(qindices[i]).c_str(), item);
+        Py_DecRef(item);
+    }
 
-    Py_RETURN_NONE;
+    return map;
 }
 
-PyFUNC Parser_records(Reader* self)
-{
-    size_t records = self->parser->records();
-    return PyLong_FromSize_t(records);
-}
+//! Names of the access patterns, in the order of erg::Access
+static const char* ACCESS_NAMES[] = {"normal", "sequential", "random", "once", "direct"};
 
-PyFUNC Parser_recordSize(Reader* self)
+PyFUNC Parser_setAccess(Reader* self, PyObject* arg)
 {
-    size_t recordSize = self->parser->recordSize();
-    return PyLong_FromSize_t(recordSize);
+    if(!PyUnicode_Check(arg)) {
+        PyErr_SetString(PyExc_TypeError, "The access pattern must be a string.");
+        return nullptr;
+    }
+    if(!checkIdle(self))
+        return nullptr;
+
+    const std::string name = PyUnicode_AsUTF8(arg);
+    for(size_t i=0; i<sizeof(ACCESS_NAMES)/sizeof(ACCESS_NAMES[0]); ++i)
+    {
+        if(name==ACCESS_NAMES[i]) {
+            self->parser->setAccess(static_cast<erg::Access>(i));
+            Py_RETURN_NONE;
+        }
+    }
+
+    PyErr_SetString(PyExc_ValueError, ("Unknown access pattern: "+name).c_str());
+    return nullptr;
 }
 
-PyFUNC Parser_numQuanities(Reader* self)
+PyFUNC Parser_access(Reader* self)
 {
-    size_t numQ = self->parser->numQuanities();
-    return PyLong_FromSize_t(numQ);
+    return PyUnicode_FromString(ACCESS_NAMES[static_cast<size_t>(self->parser->access())]);
 }
 
-PyFUNC Parser_readAll(Reader* self)
+PyFUNC Parser_readAll(Reader* self, PyObject* args, PyObject* keywds)
 {
+    PyObject* dtype = nullptr;
+    static char* kwlist[] = {"dtype", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|O", kwlist, &dtype))
+        return nullptr;
+
+    int npyType = -1;
+    if(!dtypeFromPyObject(dtype, npyType))
+        return nullptr;
+
+    if(npyType>=0) {
+        std::vector<size_t> qindices;
+        for(size_t i=0; i<self->parser->numQuanities(); ++i)
+            qindices.push_back(i);
+        return readColumns(self, qindices, 0, self->parser->records(), 1, npyType);
+    }
+
     // Allocate a Dict of numpy arrays as the returned value.
     // Load all the numpy array raw data pointer for passing to
     // the erg::Parser::readAll() function.
@@ -335,7 +2081,13 @@ PyFUNC Parser_readAll(Reader* self)
         std::string name = self->parser->quantityName(i);
         PyDict_SetItemString(map, name.c_str(), array);
 
-        // No need to decref the array because i never incrref it.
+        // The Dict holds its own reference
+        Py_DecRef(array);
+    }
+
+    if(!beginRead(self)) {
+        Py_DecRef(map);
+        return nullptr;
     }
 
     std::string error;
@@ -346,6 +2098,7 @@ PyFUNC Parser_readAll(Reader* self)
             error = e.what();
         }
     Py_END_ALLOW_THREADS;
+    endRead(self);
 
     // Check for exceptions
     if(error.length()>0) {
@@ -360,39 +2113,204 @@ PyFUNC Parser_readAll(Reader* self)
 PyFUNC Parser_read(Reader* self, PyObject* args, PyObject* keywds)
 {
     PyObject* objIndex = nullptr;
+    PyObject* objNames = nullptr;
+    PyObject* objStart = nullptr;
+    PyObject* dtype = nullptr;
+    Py_ssize_t count = -1;
+    Py_ssize_t step = 1;
+    static char* kwlist[] = {"name", "start", "count", "step", "names", "dtype", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|OOnnOO", kwlist, &objIndex, &objStart, &count, &step,
+                                    &objNames, &dtype))
+        return nullptr;
+
+    int npyType = -1;
+    if(!dtypeFromPyObject(dtype, npyType))
+        return nullptr;
+
+    if((objIndex==nullptr) == (objNames==nullptr)) {
+        PyErr_SetString(PyExc_TypeError, "Either a quantity name or a list of names must be specified.");
+        return nullptr;
+    }
+
+    size_t from = 0;
+    size_t rows = 0;
+    size_t stride = 1;
+    if(!rangeFromPyObject(self, objStart, count, step, from, rows, stride))
+        return nullptr;
+
+    if(objNames!=nullptr) {
+        std::vector<size_t> qindices = indicesFromPyObject(self->parser, objNames);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
+        return readColumns(self, qindices, from, rows, stride, npyType);
+    }
+
+    return readSelection(self, objIndex, from, rows, stride, npyType);
+}
+
+PyFUNC Parser_getitem(Reader* self, PyObject* key)
+{
+    // reader[name], reader[name, start:stop:step], reader[[names], start:stop:step]
+    PyObject* selection = key;
+    PyObject* range = nullptr;
+    if(PyTuple_Check(key) && PyTuple_Size(key)==2 && PySlice_Check(PyTuple_GetItem(key, 1))) {
+        selection = PyTuple_GetItem(key, 0);
+        range = PyTuple_GetItem(key, 1);
+    }
+
     size_t from = 0;
-    size_t count = self->parser->records();
-    static char* kwlist[] = {"name", "start", "count", NULL};
-    if(!PyArg_ParseTupleAndKeywords(args, keywds, "O|ii", kwlist, &objIndex, &from, &count))
+    size_t rows = 0;
+    size_t stride = 1;
+    if(!rangeFromPyObject(self, range, -1, 1, from, rows, stride))
         return nullptr;
 
-    const size_t qindex = indexFromPyObject(self->parser, objIndex);
+    return readSelection(self, selection, from, rows, stride, -1);
+}
+
+PyFUNC Parser_view(Reader* self, PyObject* arg)
+{
+    if(PyList_Check(arg) || PyTuple_Check(arg)) {
+        std::vector<size_t> qindices = indicesFromPyObject(self->parser, arg);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
+        return viewColumns(self->parser, qindices);
+    }
+
+    const size_t qindex = indexFromPyObject(self->parser, arg);
     if(PyErr_Occurred()!=nullptr)
         return nullptr;
 
-    // Numpy array creation
-    npy_intp rows = count;
-    int type = ergType2npyType(self->parser->quantityType(qindex));
-    PyArrayObject* array = (PyArrayObject*)PyArray_SimpleNew(1, &rows, type);
-    uint8_t* outData = (uint8_t*)PyArray_DATA(array);
-    const npy_intp size = PyArray_NBYTES(array);
+    PyObject* mapping = mappingCapsule(self->parser);
+    if(mapping==nullptr)
+        return nullptr;
+    PyObject* array = viewColumn(self->parser, qindex, mapping);
+    Py_DecRef(mapping);
+    return array;
+}
+
+PyFUNC Parser_iterChunks(Reader* self, PyObject* args, PyObject* keywds)
+{
+    Py_ssize_t rows = 65536;
+    PyObject* columns = nullptr;
+    PyObject* dtype = nullptr;
+    static char* kwlist[] = {"rows", "columns", "dtype", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|nOO", kwlist, &rows, &columns, &dtype))
+        return nullptr;
+
+    if(rows<=0) {
+        PyErr_SetString(PyExc_ValueError, "The chunks must contain at least one row.");
+        return nullptr;
+    }
+
+    int npyType = -1;
+    if(!dtypeFromPyObject(dtype, npyType))
+        return nullptr;
+
+    std::vector<size_t> qindices;
+    if(columns==nullptr || columns==Py_None) {
+        for(size_t i=0; i<self->parser->numQuanities(); ++i)
+            qindices.push_back(i);
+    } else {
+        qindices = indicesFromPyObject(self->parser, columns);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
+    }
+
+    ChunkIterator* it = PyObject_New(ChunkIterator, &pyerg_ChunkIteratorType);
+    if(it==nullptr)
+        return nullptr;
+
+    Py_IncRef((PyObject*)self);
+    it->reader = self;
+    it->qindices = new std::vector<size_t>(qindices);
+    it->rows = rows;
+    it->next = 0;
+    it->npyType = npyType;
+    return (PyObject*)it;
+}
+
+PyFUNC Parser_refresh(Reader* self)
+{
+    if(!checkIdle(self))
+        return nullptr;
+
+    try {
+        return PyLong_FromSize_t(self->parser->refresh());
+    } catch (std::runtime_error& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+PyFUNC Parser_readNew(Reader* self, PyObject* args, PyObject* keywds)
+{
+    PyObject* columns = nullptr;
+    double timeout = 0.0;
+    static char* kwlist[] = {"columns", "timeout", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|Od", kwlist, &columns, &timeout))
+        return nullptr;
+
+    std::vector<size_t> qindices;
+    if(columns==nullptr || columns==Py_None) {
+        for(size_t i=0; i<self->parser->numQuanities(); ++i)
+            qindices.push_back(i);
+    } else {
+        qindices = indicesFromPyObject(self->parser, columns);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
+    }
 
-    std::string error;
-    Py_BEGIN_ALLOW_THREADS;
-        try {
-            self->parser->read(qindex, from, count, outData, size);
-        } catch(std::runtime_error& e) {
-            error = e.what();
+    PyObject* ret = Parser_refresh(self);
+    if(ret==nullptr)
+        return nullptr;
+    Py_DecRef(ret);
+
+    if(self->parser->newRecords()==0 && timeout>0.0) {
+        if(!beginRead(self))
+            return nullptr;
+        const size_t timeoutMs = static_cast<size_t>(timeout * 1000.0);
+        bool grown = false;
+        Py_BEGIN_ALLOW_THREADS;
+            grown = self->parser->waitForGrowth(timeoutMs);
+        Py_END_ALLOW_THREADS;
+        endRead(self);
+
+        if(grown) {
+            ret = Parser_refresh(self);
+            if(ret==nullptr)
+                return nullptr;
+            Py_DecRef(ret);
         }
-    Py_END_ALLOW_THREADS;
+    }
 
-    if(error.length()>0) {
-        Py_DecRef((PyObject*)array);
-        PyErr_SetString(PyExc_NameError, error.c_str());
+    // Allocate a Dict of numpy arrays for the new records
+    std::vector<std::string> names;
+    std::vector<int> types;
+    try {
+        for(size_t qindex: qindices)
+        {
+            names.push_back(self->parser->quantityName(qindex));
+            types.push_back(ergType2npyType(self->parser->quantityType(qindex)));
+        }
+    } catch(std::runtime_error& e) {
+        PyErr_SetString(PyExc_NameError, e.what());
+        return nullptr;
+    }
+    std::vector<uint8_t*> dataWrapper;
+    std::vector<size_t> sizeWrapper;
+    PyObject* map = newColumns(names, types, self->parser->newRecords(), dataWrapper, sizeWrapper);
+    if(map==nullptr)
+        return nullptr;
+    try {
+        // The read cursor is updated: keep the GIL to serialize the calls.
+        self->parser->readNew(qindices, dataWrapper, sizeWrapper);
+    } catch(std::runtime_error& e) {
+        Py_DecRef(map);
+        PyErr_SetString(PyExc_NameError, e.what());
         return nullptr;
     }
 
-    return (PyObject*)array;
+    return map;
 }
 
 PyFUNC Parser_quantitySize(Reader* self, PyObject* arg)
@@ -494,6 +2412,9 @@ PyFUNC Parser_has(Reader* self, PyObject* arg)
         return nullptr;
     }
 
+    if(!loadQuantities(self))
+        return nullptr;
+
     const char* qname = PyUnicode_AsUTF8(arg);
     if(self->parser->has(qname)) {
         Py_RETURN_TRUE;
@@ -502,8 +2423,558 @@ PyFUNC Parser_has(Reader* self, PyObject* arg)
     Py_RETURN_FALSE;
 }
 
+PyFUNC Parser_select(Reader* self, PyObject* args, PyObject* keywds)
+{
+    const char* pattern = nullptr;
+    int regex = 0;
+    static char* kwlist[] = {"pattern", "regex", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "s|p", kwlist, &pattern, &regex))
+        return nullptr;
+
+    if(!loadQuantities(self))
+        return nullptr;
+
+    std::vector<size_t> qindices;
+    try {
+        if(regex)
+            qindices = self->parser->select(std::regex(pattern));
+        else
+            qindices = self->parser->select(std::string(pattern));
+    } catch (std::regex_error& e) {
+        PyErr_SetString(PyExc_ValueError, e.what());
+        return nullptr;
+    } catch (std::exception& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+
+    PyObject* list = PyList_New(qindices.size());
+    if(list==nullptr)
+        return nullptr;
+    for(size_t i=0; i<qindices.size(); ++i)
+        PyList_SET_ITEM(list, i, PyLong_FromSize_t(qindices[i]));
+    return list;
+}
+
+/*!
+ * \brief Datasets exported through the Arrow C data interface.
+ *
+ * The buffers are shared by the ArrowBatch and by all the arrays exported
+ * from it, and they are freed when the last one is released.
+ */
+struct ArrowColumns
+{
+    size_t rows;                        //!< Number of rows of each column
+    std::vector<std::string> names;     //!< Name of each column
+    std::vector<std::string> units;     //!< Unit of each column, empty if none
+    std::vector<erg::Type> types;       //!< Type of each column
+    std::vector< std::vector<uint8_t> > data;   //!< Values of each column, in host byte order
+};
+
+/*!
+ * \brief Arrow format string of an ERG type.
+ * \param t ERG type.
+ * \return The format of the primitive Arrow type.
+ * \throws Exception if ERG type is Void.
+ */
+static const char* ergType2arrowFormat(const erg::Type t)
+{
+    switch (t)
+    {
+    case erg::Type::Int8:
+        return "c";
+    case erg::Type::Uint8:
+        return "C";
+    case erg::Type::Int16:
+        return "s";
+    case erg::Type::Uint16:
+        return "S";
+    case erg::Type::Int32:
+        return "i";
+    case erg::Type::Uint32:
+        return "I";
+    case erg::Type::Int64:
+        return "l";
+    case erg::Type::Uint64:
+        return "L";
+    case erg::Type::Float:
+        return "f";
+    case erg::Type::Double:
+        return "g";
+    case erg::Type::Void:
+    default:
+        throw std::runtime_error("Unknown data type.");
+    }
+}
+
+/*!
+ * \brief Encode the metadata of an Arrow field.
+ *
+ * The pairs are stored as native 32 bits lengths followed by the bytes of
+ * the key and of the value.
+ * \param pairs Keys and values.
+ * \return The encoded metadata.
+ */
+static std::string arrowMetadata(const std::vector< std::pair<std::string, std::string> >& pairs)
+{
+    std::string metadata;
+    auto append = [&metadata](const int32_t value) {
+        metadata.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    append(static_cast<int32_t>(pairs.size()));
+    for(const auto& pair: pairs)
+    {
+        append(static_cast<int32_t>(pair.first.size()));
+        metadata += pair.first;
+        append(static_cast<int32_t>(pair.second.size()));
+        metadata += pair.second;
+    }
+    return metadata;
+}
+
+//! Strings and children owned by an exported ArrowSchema
+struct ArrowSchemaPrivate
+{
+    std::string format;
+    std::string name;
+    std::string metadata;
+    std::vector<ArrowSchema> children;
+    std::vector<ArrowSchema*> pointers;
+};
+
+extern "C" void releaseArrowSchema(ArrowSchema* schema)
+{
+    ArrowSchemaPrivate* p = reinterpret_cast<ArrowSchemaPrivate*>(schema->private_data);
+    // The consumer can move the children: only the ones still here are released
+    for(ArrowSchema& child: p->children)
+    {
+        if(child.release!=nullptr)
+            child.release(&child);
+    }
+    delete p;
+    schema->release = nullptr;
+}
+
+/*!
+ * \brief Fill an ArrowSchema that owns its strings.
+ */
+static void fillArrowSchema(ArrowSchema* schema, ArrowSchemaPrivate* p)
+{
+    schema->format = p->format.c_str();
+    schema->name = p->name.c_str();
+    schema->metadata = p->metadata.empty() ? nullptr : p->metadata.data();
+    schema->flags = 0;
+    schema->n_children = p->children.size();
+    schema->children = p->pointers.empty() ? nullptr : p->pointers.data();
+    schema->dictionary = nullptr;
+    schema->release = &releaseArrowSchema;
+    schema->private_data = p;
+}
+
+/*!
+ * \brief Export the schema of the columns: a struct with a field for each column.
+ * \param columns The columns.
+ * \param schema The schema to fill, released by the consumer.
+ */
+static void exportArrowSchema(const ArrowColumns& columns, ArrowSchema* schema)
+{
+    std::unique_ptr<ArrowSchemaPrivate> p(new ArrowSchemaPrivate);
+    p->format = "+s";
+    p->children.resize(columns.names.size());
+    try {
+        for(size_t i=0; i<columns.names.size(); ++i)
+        {
+            std::unique_ptr<ArrowSchemaPrivate> child(new ArrowSchemaPrivate);
+            child->format = ergType2arrowFormat(columns.types[i]);
+            child->name = columns.names[i];
+            if(!columns.units[i].empty())
+                child->metadata = arrowMetadata({{"unit", columns.units[i]}});
+            p->pointers.push_back(&p->children[i]);
+            fillArrowSchema(&p->children[i], child.release());
+        }
+    } catch(...) {
+        for(ArrowSchema& child: p->children)
+        {
+            if(child.release!=nullptr)
+                child.release(&child);
+        }
+        throw;
+    }
+    fillArrowSchema(schema, p.release());
+}
+
+//! Buffers and children owned by an exported ArrowArray
+struct ArrowArrayPrivate
+{
+    std::shared_ptr<ArrowColumns> columns;  //!< Keeps the data alive
+    std::vector<const void*> buffers;
+    std::vector<ArrowArray> children;
+    std::vector<ArrowArray*> pointers;
+};
+
+extern "C" void releaseArrowArray(ArrowArray* array)
+{
+    ArrowArrayPrivate* p = reinterpret_cast<ArrowArrayPrivate*>(array->private_data);
+    for(ArrowArray& child: p->children)
+    {
+        if(child.release!=nullptr)
+            child.release(&child);
+    }
+    delete p;
+    array->release = nullptr;
+}
+
+/*!
+ * \brief Fill an ArrowArray without nulls.
+ */
+static void fillArrowArray(ArrowArray* array, ArrowArrayPrivate* p, const size_t length)
+{
+    array->length = length;
+    array->null_count = 0;
+    array->offset = 0;
+    array->n_buffers = p->buffers.size();
+    array->n_children = p->children.size();
+    array->buffers = p->buffers.data();
+    array->children = p->pointers.empty() ? nullptr : p->pointers.data();
+    array->dictionary = nullptr;
+    array->release = &releaseArrowArray;
+    array->private_data = p;
+}
+
+/*!
+ * \brief Export the columns as a struct array, without copying the data.
+ * \param columns The columns.
+ * \param array The array to fill, released by the consumer.
+ */
+static void exportArrowArray(const std::shared_ptr<ArrowColumns>& columns, ArrowArray* array)
+{
+    std::unique_ptr<ArrowArrayPrivate> p(new ArrowArrayPrivate);
+    p->columns = columns;
+    // No validity bitmap: there are no nulls
+    p->buffers.push_back(nullptr);
+    p->children.resize(columns->data.size());
+    try {
+        for(size_t i=0; i<columns->data.size(); ++i)
+        {
+            // Each child keeps the data alive, because the consumer can move it
+            std::unique_ptr<ArrowArrayPrivate> child(new ArrowArrayPrivate);
+            child->columns = columns;
+            child->buffers.push_back(nullptr);
+            child->buffers.push_back(columns->data[i].data());
+            p->pointers.push_back(&p->children[i]);
+            fillArrowArray(&p->children[i], child.release(), columns->rows);
+        }
+    } catch(...) {
+        for(ArrowArray& child: p->children)
+        {
+            if(child.release!=nullptr)
+                child.release(&child);
+        }
+        throw;
+    }
+    fillArrowArray(array, p.release(), columns->rows);
+}
+
+//! State of an exported ArrowArrayStream
+struct ArrowStreamPrivate
+{
+    std::shared_ptr<ArrowColumns> columns;  //!< The only batch of the stream
+    bool done;                              //!< The batch has been returned
+};
+
+extern "C" int arrowStreamSchema(ArrowArrayStream* stream, ArrowSchema* out)
+{
+    try {
+        exportArrowSchema(*reinterpret_cast<ArrowStreamPrivate*>(stream->private_data)->columns, out);
+    } catch(std::exception&) {
+        return ENOMEM;
+    }
+    return 0;
+}
+
+extern "C" int arrowStreamNext(ArrowArrayStream* stream, ArrowArray* out)
+{
+    ArrowStreamPrivate* p = reinterpret_cast<ArrowStreamPrivate*>(stream->private_data);
+    if(p->done) {
+        // Released array: end of the stream
+        out->release = nullptr;
+        return 0;
+    }
+    try {
+        exportArrowArray(p->columns, out);
+    } catch(std::exception&) {
+        return ENOMEM;
+    }
+    p->done = true;
+    return 0;
+}
+
+extern "C" const char* arrowStreamError(ArrowArrayStream*)
+{
+    return nullptr;
+}
+
+extern "C" void releaseArrowStream(ArrowArrayStream* stream)
+{
+    delete reinterpret_cast<ArrowStreamPrivate*>(stream->private_data);
+    stream->release = nullptr;
+}
+
+//! Names of the capsules of the Arrow PyCapsule interface
+static const char* ARROW_SCHEMA_CAPSULE = "arrow_schema";
+static const char* ARROW_ARRAY_CAPSULE = "arrow_array";
+static const char* ARROW_STREAM_CAPSULE = "arrow_array_stream";
+
+extern "C" void releaseArrowSchemaCapsule(PyObject* capsule)
+{
+    ArrowSchema* schema = reinterpret_cast<ArrowSchema*>(PyCapsule_GetPointer(capsule, ARROW_SCHEMA_CAPSULE));
+    // A consumer that imported the schema has marked it as released
+    if(schema->release!=nullptr)
+        schema->release(schema);
+    delete schema;
+}
+
+extern "C" void releaseArrowArrayCapsule(PyObject* capsule)
+{
+    ArrowArray* array = reinterpret_cast<ArrowArray*>(PyCapsule_GetPointer(capsule, ARROW_ARRAY_CAPSULE));
+    if(array->release!=nullptr)
+        array->release(array);
+    delete array;
+}
+
+extern "C" void releaseArrowStreamCapsule(PyObject* capsule)
+{
+    ArrowArrayStream* stream = reinterpret_cast<ArrowArrayStream*>(PyCapsule_GetPointer(capsule, ARROW_STREAM_CAPSULE));
+    if(stream->release!=nullptr)
+        stream->release(stream);
+    delete stream;
+}
+
+/*!
+ * \brief Capsule with the schema of the columns.
+ * \return The capsule or nullptr on errors.
+ */
+static PyObject* arrowSchemaCapsule(const ArrowColumns& columns)
+{
+    ArrowSchema* schema = nullptr;
+    try {
+        std::unique_ptr<ArrowSchema> exported(new ArrowSchema);
+        exportArrowSchema(columns, exported.get());
+        schema = exported.release();
+    } catch(std::exception& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    PyObject* capsule = PyCapsule_New(schema, ARROW_SCHEMA_CAPSULE, &releaseArrowSchemaCapsule);
+    if(capsule==nullptr) {
+        schema->release(schema);
+        delete schema;
+    }
+    return capsule;
+}
+
+/*!
+ * \brief Read datasets into an ArrowBatch.
+ * \param self The Python reader.
+ * \param qindices Quantities to read.
+ * \param from First record.
+ * \param count Maximum number of records.
+ * \return The batch or nullptr on errors.
+ */
+static PyObject* readArrowBatch(Reader* self, const std::vector<size_t>& qindices, const size_t from,
+                                const size_t count)
+{
+    std::shared_ptr<ArrowColumns> columns;
+    std::vector<uint8_t*> values;
+    std::vector<size_t> sizes;
+    try {
+        columns = std::make_shared<ArrowColumns>();
+        columns->rows = self->parser->rangeSize(from, count);
+        for(size_t qindex: qindices)
+        {
+            columns->names.push_back(self->parser->quantityName(qindex));
+            columns->units.push_back(self->parser->quantityUnit(qindex));
+            columns->types.push_back(self->parser->quantityType(qindex));
+            columns->data.push_back(std::vector<uint8_t>(columns->rows * erg::Reader::dataSize(columns->types.back())));
+        }
+        for(std::vector<uint8_t>& data: columns->data)
+        {
+            values.push_back(data.data());
+            sizes.push_back(data.size());
+        }
+    } catch(std::runtime_error& e) {
+        PyErr_SetString(PyExc_NameError, e.what());
+        return nullptr;
+    } catch(std::exception& e) {
+        // The columns are allocated with the size of the whole selection
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+
+    if(!beginRead(self))
+        return nullptr;
+
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS;
+        try {
+            if(!qindices.empty())
+                self->parser->read(qindices, from, columns->rows, 1, values, sizes);
+        } catch(std::exception& e) {
+            error = e.what();
+        }
+    Py_END_ALLOW_THREADS;
+    endRead(self);
+
+    if(!error.empty()) {
+        PyErr_SetString(PyExc_NameError, error.c_str());
+        return nullptr;
+    }
+
+    ArrowBatch* batch = PyObject_New(ArrowBatch, &pyerg_ArrowBatchType);
+    if(batch==nullptr)
+        return nullptr;
+    try {
+        batch->columns = new std::shared_ptr<ArrowColumns>(columns);
+    } catch(std::exception& e) {
+        batch->columns = nullptr;
+        Py_DecRef((PyObject*)batch);
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    return (PyObject*)batch;
+}
+
+PyFUNC Parser_arrow(Reader* self, PyObject* args, PyObject* keywds)
+{
+    PyObject* columns = nullptr;
+    Py_ssize_t start = 0;
+    Py_ssize_t count = -1;
+    static char* kwlist[] = {"columns", "start", "count", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|Onn", kwlist, &columns, &start, &count))
+        return nullptr;
+
+    if(start<0) {
+        PyErr_SetString(PyExc_ValueError, "The start can't be negative.");
+        return nullptr;
+    }
+
+    std::vector<size_t> qindices;
+    if(columns==nullptr || columns==Py_None) {
+        for(size_t i=0; i<self->parser->numQuanities(); ++i)
+            qindices.push_back(i);
+    } else {
+        qindices = indicesFromPyObject(self->parser, columns);
+        if(PyErr_Occurred()!=nullptr)
+            return nullptr;
+    }
+
+    return readArrowBatch(self, qindices, start, count<0 ? self->parser->records() : count);
+}
+
+PyFUNC Parser_arrowCStream(Reader* self, PyObject* args, PyObject* keywds)
+{
+    PyObject* requestedSchema = nullptr;
+    static char* kwlist[] = {"requested_schema", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|O", kwlist, &requestedSchema))
+        return nullptr;
+
+    std::vector<size_t> qindices;
+    for(size_t i=0; i<self->parser->numQuanities(); ++i)
+        qindices.push_back(i);
+
+    PyObject* batch = readArrowBatch(self, qindices, 0, self->parser->records());
+    if(batch==nullptr)
+        return nullptr;
+    PyObject* stream = ArrowBatch_stream((ArrowBatch*)batch, args, keywds);
+    Py_DecRef(batch);
+    return stream;
+}
+
+extern "C" void ArrowBatch_dealloc(ArrowBatch* self)
+{
+    delete self->columns;
+    PyObject_Del(self);
+}
+
+extern "C" Py_ssize_t ArrowBatch_length(ArrowBatch* self)
+{
+    return (*self->columns)->rows;
+}
+
+PyFUNC ArrowBatch_schema(ArrowBatch* self)
+{
+    return arrowSchemaCapsule(**self->columns);
+}
+
+PyFUNC ArrowBatch_array(ArrowBatch* self, PyObject* args, PyObject* keywds)
+{
+    PyObject* requestedSchema = nullptr;
+    static char* kwlist[] = {"requested_schema", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|O", kwlist, &requestedSchema))
+        return nullptr;
+
+    PyObject* schema = arrowSchemaCapsule(**self->columns);
+    if(schema==nullptr)
+        return nullptr;
+
+    ArrowArray* array = nullptr;
+    try {
+        std::unique_ptr<ArrowArray> exported(new ArrowArray);
+        exportArrowArray(*self->columns, exported.get());
+        array = exported.release();
+    } catch(std::exception& e) {
+        Py_DecRef(schema);
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    PyObject* capsule = PyCapsule_New(array, ARROW_ARRAY_CAPSULE, &releaseArrowArrayCapsule);
+    if(capsule==nullptr) {
+        array->release(array);
+        delete array;
+        Py_DecRef(schema);
+        return nullptr;
+    }
+
+    PyObject* result = PyTuple_Pack(2, schema, capsule);
+    Py_DecRef(schema);
+    Py_DecRef(capsule);
+    return result;
+}
+
+PyFUNC ArrowBatch_stream(ArrowBatch* self, PyObject* args, PyObject* keywds)
+{
+    PyObject* requestedSchema = nullptr;
+    static char* kwlist[] = {"requested_schema", NULL};
+    if(!PyArg_ParseTupleAndKeywords(args, keywds, "|O", kwlist, &requestedSchema))
+        return nullptr;
+
+    ArrowArrayStream* stream = nullptr;
+    try {
+        std::unique_ptr<ArrowArrayStream> exported(new ArrowArrayStream);
+        exported->private_data = new ArrowStreamPrivate{*self->columns, false};
+        exported->get_schema = &arrowStreamSchema;
+        exported->get_next = &arrowStreamNext;
+        exported->get_last_error = &arrowStreamError;
+        exported->release = &releaseArrowStream;
+        stream = exported.release();
+    } catch(std::exception& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+
+    PyObject* capsule = PyCapsule_New(stream, ARROW_STREAM_CAPSULE, &releaseArrowStreamCapsule);
+    if(capsule==nullptr) {
+        stream->release(stream);
+        delete stream;
+    }
+    return capsule;
+}
+
 PyFUNC Parser_close(Reader* self)
 {
+    if(!checkIdle(self))
+        return nullptr;
+
     self->parser->close();
     Py_RETURN_NONE;
 }
@@ -527,6 +2998,15 @@ PyMODINIT_FUNC PyInit_pyerg(void)
     if (PyType_Ready(&pyerg_ReaderType) < 0)
         return NULL;
 
+    if (PyType_Ready(&pyerg_ChunkIteratorType) < 0)
+        return NULL;
+
+    if (PyType_Ready(&pyerg_BatchIteratorType) < 0)
+        return NULL;
+
+    if (PyType_Ready(&pyerg_ArrowBatchType) < 0)
+        return NULL;
+
     Py_INCREF(&pyerg_ReaderType);
     if (PyModule_AddObject(pyergModule, "Reader", (PyObject*)&pyerg_ReaderType) < 0) {
         Py_DECREF(pyergModule);
@@ -33,6 +33,7 @@
 
 // Workaround for some compiler that need cmath included before python
 #include <cmath>
+#include <cerrno>
 
 #include <Python.h>
 #include <structmember.h>
@@ -40,7 +41,16 @@
 #define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
 #include <numpy/arrayobject.h>
 
+// Numpy < 2.0 does not provide the descriptor accessors
+#if NPY_ABI_VERSION < 0x02000000
+#define PyDataType_ELSIZE(descr) ((descr)->elsize)
+#endif
+
 #include "erg.h"
+#include "multireader.h"
+#include "segmentedreader.h"
+#include "writer.h"
+#include "arrow.h"
 #include "pyerg_docstrings.h"
 
 #define PyFUNC extern "C" PyObject*
@@ -49,6 +59,8 @@
 typedef struct {
     PyObject_HEAD
     erg::Reader* parser;    //!< The parser C++ implementation
+    int readers;            //!< Number of reads running with the GIL released
+    int opening;            //!< Non zero while open() runs with the GIL released
 } Reader;
 
 extern "C" void Parser_dealloc(Reader* self);
@@ -58,8 +70,34 @@ PyFUNC Parser_open(Reader* self, PyObject *args);
 PyFUNC Parser_records(Reader* self);
 PyFUNC Parser_recordSize(Reader* self);
 PyFUNC Parser_numQuanities(Reader* self);
-PyFUNC Parser_readAll(Reader* self);
+PyFUNC Parser_setThreads(Reader* self, PyObject* arg);
+PyFUNC Parser_threads(Reader* self);
+PyFUNC Parser_setPrefetch(Reader* self, PyObject* arg);
+PyFUNC Parser_prefetch(Reader* self);
+PyFUNC Parser_setAccess(Reader* self, PyObject* arg);
+PyFUNC Parser_access(Reader* self);
+PyFUNC Parser_setCacheSize(Reader* self, PyObject* arg);
+PyFUNC Parser_cacheSize(Reader* self);
+PyFUNC Parser_cacheStats(Reader* self);
+PyFUNC Parser_buildSidecar(Reader* self);
+PyFUNC Parser_hasSidecar(Reader* self);
+PyFUNC Parser_recordAt(Reader* self, PyObject* arg);
+PyFUNC Parser_readTimeRange(Reader* self, PyObject *args, PyObject *keywds);
+PyFUNC Parser_resample(Reader* self, PyObject *args, PyObject *keywds);
+PyFUNC Parser_buildTimeIndex(Reader* self, PyObject *args, PyObject *keywds);
+PyFUNC Parser_hasTimeIndex(Reader* self);
+PyFUNC Parser_where(Reader* self, PyObject* arg);
+PyFUNC Parser_readWhere(Reader* self, PyObject *args, PyObject *keywds);
+PyFUNC Parser_buildZoneMap(Reader* self, PyObject *args, PyObject *keywds);
+PyFUNC Parser_hasZoneMap(Reader* self);
+PyFUNC Parser_stats(Reader* self, PyObject *args, PyObject *keywds);
+PyFUNC Parser_readAll(Reader* self, PyObject *args, PyObject *keywds);
 PyFUNC Parser_read(Reader* self, PyObject *args, PyObject *keywds);
+PyFUNC Parser_getitem(Reader* self, PyObject* key);
+PyFUNC Parser_view(Reader* self, PyObject* arg);
+PyFUNC Parser_iterChunks(Reader* self, PyObject *args, PyObject *keywds);
+PyFUNC Parser_refresh(Reader* self);
+PyFUNC Parser_readNew(Reader* self, PyObject *args, PyObject *keywds);
 PyFUNC Parser_quantitySize(Reader* self, PyObject* arg);
 PyFUNC Parser_quantityName(Reader* self, PyObject* arg);
 PyFUNC Parser_quantityType(Reader* self, PyObject* arg);
@@ -68,6 +106,9 @@ PyFUNC Parser_index(Reader* self, PyObject* arg);
 PyFUNC Parser_isErg(Reader* self);
 PyFUNC Parser_isFortran(Reader* self);
 PyFUNC Parser_has(Reader* self, PyObject* arg);
+PyFUNC Parser_select(Reader* self, PyObject* args, PyObject* keywds);
+PyFUNC Parser_arrow(Reader* self, PyObject* args, PyObject* keywds);
+PyFUNC Parser_arrowCStream(Reader* self, PyObject* args, PyObject* keywds);
 PyFUNC Parser_close(Reader* self);
 
 static PyMethodDef parser_methods[] = {
@@ -88,13 +129,113 @@ static PyMethodDef parser_methods[] = {
         PYERG_PARSER_NUMQUANITIES_DOC
     },
     {
-        "readAll", (PyCFunction)Parser_readAll, METH_NOARGS,
+        "setThreads", (PyCFunction)Parser_setThreads, METH_O,
+        PYERG_PARSER_SETTHREADS_DOC
+    },
+    {
+        "threads", (PyCFunction)Parser_threads, METH_NOARGS,
+        PYERG_PARSER_THREADS_DOC
+    },
+    {
+        "setPrefetch", (PyCFunction)Parser_setPrefetch, METH_O,
+        PYERG_PARSER_SETPREFETCH_DOC
+    },
+    {
+        "prefetch", (PyCFunction)Parser_prefetch, METH_NOARGS,
+        PYERG_PARSER_PREFETCH_DOC
+    },
+    {
+        "setAccess", (PyCFunction)Parser_setAccess, METH_O,
+        PYERG_PARSER_SETACCESS_DOC
+    },
+    {
+        "access", (PyCFunction)Parser_access, METH_NOARGS,
+        PYERG_PARSER_ACCESS_DOC
+    },
+    {
+        "setCacheSize", (PyCFunction)Parser_setCacheSize, METH_O,
+        PYERG_PARSER_SETCACHESIZE_DOC
+    },
+    {
+        "cacheSize", (PyCFunction)Parser_cacheSize, METH_NOARGS,
+        PYERG_PARSER_CACHESIZE_DOC
+    },
+    {
+        "cacheStats", (PyCFunction)Parser_cacheStats, METH_NOARGS,
+        PYERG_PARSER_CACHESTATS_DOC
+    },
+    {
+        "buildSidecar", (PyCFunction)Parser_buildSidecar, METH_NOARGS,
+        PYERG_PARSER_BUILDSIDECAR_DOC
+    },
+    {
+        "hasSidecar", (PyCFunction)Parser_hasSidecar, METH_NOARGS,
+        PYERG_PARSER_HASSIDECAR_DOC
+    },
+    {
+        "recordAt", (PyCFunction)Parser_recordAt, METH_O,
+        PYERG_PARSER_RECORDAT_DOC
+    },
+    {
+        "readTimeRange", (PyCFunction)Parser_readTimeRange, METH_VARARGS | METH_KEYWORDS,
+        PYERG_PARSER_READTIMERANGE_DOC
+    },
+    {
+        "resample", (PyCFunction)Parser_resample, METH_VARARGS | METH_KEYWORDS,
+        PYERG_PARSER_RESAMPLE_DOC
+    },
+    {
+        "buildTimeIndex", (PyCFunction)Parser_buildTimeIndex, METH_VARARGS | METH_KEYWORDS,
+        PYERG_PARSER_BUILDTIMEINDEX_DOC
+    },
+    {
+        "hasTimeIndex", (PyCFunction)Parser_hasTimeIndex, METH_NOARGS,
+        PYERG_PARSER_HASTIMEINDEX_DOC
+    },
+    {
+        "where", (PyCFunction)Parser_where, METH_O,
+        PYERG_PARSER_WHERE_DOC
+    },
+    {
+        "readWhere", (PyCFunction)Parser_readWhere, METH_VARARGS | METH_KEYWORDS,
+        PYERG_PARSER_READWHERE_DOC
+    },
+    {
+        "buildZoneMap", (PyCFunction)Parser_buildZoneMap, METH_VARARGS | METH_KEYWORDS,
+        PYERG_PARSER_BUILDZONEMAP_DOC
+    },
+    {
+        "hasZoneMap", (PyCFunction)Parser_hasZoneMap, METH_NOARGS,
+        PYERG_PARSER_HASZONEMAP_DOC
+    },
+    {
+        "stats", (PyCFunction)Parser_stats, METH_VARARGS | METH_KEYWORDS,
+        PYERG_PARSER_STATS_DOC
+    },
+    {
+        "readAll", (PyCFunction)Parser_readAll, METH_VARARGS|METH_KEYWORDS,
         PYERG_PARSER_READALL_DOC
     },
     {
         "read", (PyCFunction)Parser_read, METH_VARARGS|METH_KEYWORDS,
         PYERG_PARSER_READ_DOC
     },
+    {
+        "refresh", (PyCFunction)Parser_refresh, METH_NOARGS,
+        PYERG_PARSER_REFRESH_DOC
+    },
+    {
+        "read_new", (PyCFunction)Parser_readNew, METH_VARARGS|METH_KEYWORDS,
+        PYERG_PARSER_READNEW_DOC
+    },
+    {
+        "iter_chunks", (PyCFunction)Parser_iterChunks, METH_VARARGS|METH_KEYWORDS,
+        PYERG_PARSER_ITERCHUNKS_DOC
+    },
+    {
+        "view", (PyCFunction)Parser_view, METH_O,
+        PYERG_PARSER_VIEW_DOC
+    },
     {
         "quantitySize", (PyCFunction)Parser_quantitySize, METH_O,
         PYERG_PARSER_QUANTITYSIZE_DOC
@@ -127,6 +268,18 @@ static PyMethodDef parser_methods[] = {
         "has", (PyCFunction)Parser_has, METH_O,
         PYERG_PARSER_HAS_DOC
     },
+    {
+        "select", (PyCFunction)Parser_select, METH_VARARGS|METH_KEYWORDS,
+        PYERG_PARSER_SELECT_DOC
+    },
+    {
+        "arrow", (PyCFunction)Parser_arrow, METH_VARARGS|METH_KEYWORDS,
+        PYERG_PARSER_ARROW_DOC
+    },
+    {
+        "__arrow_c_stream__", (PyCFunction)Parser_arrowCStream, METH_VARARGS|METH_KEYWORDS,
+        PYERG_PARSER_ARROWCSTREAM_DOC
+    },
     {
         "close", (PyCFunction)Parser_close, METH_NOARGS,
         PYERG_PARSER_CLOSE_DOC
@@ -134,6 +287,12 @@ static PyMethodDef parser_methods[] = {
     {nullptr}  /* Sentinel */
 };
 
+static PyMappingMethods parser_mapping = {
+    0,                              /* mp_length */
+    (binaryfunc)Parser_getitem,     /* mp_subscript */
+    0,                              /* mp_ass_subscript */
+};
+
 static PyTypeObject pyerg_ReaderType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyerg.Reader",            /*tp_name*/
@@ -147,7 +306,7 @@ static PyTypeObject pyerg_ReaderType = {
     0,                         /*tp_repr*/
     0,                         /*tp_as_number*/
     0,                         /*tp_as_sequence*/
-    0,                         /*tp_as_mapping*/
+    &parser_mapping,           /*tp_as_mapping*/
     0,                         /*tp_hash */
     0,                         /*tp_call*/
     0,                         /*tp_str*/
@@ -175,14 +334,163 @@ static PyTypeObject pyerg_ReaderType = {
     Parser_new,                 /* tp_new */
 };
 
-PyFUNC py_read(PyObject* self, PyObject* filename);
+typedef struct {
+    PyObject_HEAD
+    Reader* reader;                 //!< The Python reader, a reference is held
+    std::vector<size_t>* qindices;  //!< Quantities to read
+    size_t rows;                    //!< Maximum number of records in each chunk
+    size_t next;                    //!< First record of the next chunk
+    int npyType;                    //!< Numpy type of the arrays, `-1` for the file types
+} ChunkIterator;
+
+extern "C" void ChunkIterator_dealloc(ChunkIterator* self);
+PyFUNC ChunkIterator_next(ChunkIterator* self);
+
+static PyTypeObject pyerg_ChunkIteratorType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyerg.ChunkIterator",     /*tp_name*/
+    sizeof(ChunkIterator),     /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)ChunkIterator_dealloc,     /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    PYERG_CHUNKITERATOR_DOC,   /* tp_doc */
+    0,		               /* tp_traverse */
+    0,		               /* tp_clear */
+    0,		               /* tp_richcompare */
+    0,		               /* tp_weaklistoffset */
+    PyObject_SelfIter,         /* tp_iter */
+    (iternextfunc)ChunkIterator_next,  /* tp_iternext */
+};
+
+typedef struct {
+    PyObject_HEAD
+    erg::MultiReader* batch;    //!< The batch being read
+} BatchIterator;
+
+extern "C" void BatchIterator_dealloc(BatchIterator* self);
+PyFUNC BatchIterator_next(BatchIterator* self);
+
+static PyTypeObject pyerg_BatchIteratorType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyerg.BatchIterator",     /*tp_name*/
+    sizeof(BatchIterator),     /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)BatchIterator_dealloc,     /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    PYERG_BATCHITERATOR_DOC,   /* tp_doc */
+    0,		               /* tp_traverse */
+    0,		               /* tp_clear */
+    0,		               /* tp_richcompare */
+    0,		               /* tp_weaklistoffset */
+    PyObject_SelfIter,         /* tp_iter */
+    (iternextfunc)BatchIterator_next,  /* tp_iternext */
+};
+
+struct ArrowColumns;
+
+typedef struct {
+    PyObject_HEAD
+    std::shared_ptr<ArrowColumns>* columns; //!< Columns, shared with the exported arrays
+} ArrowBatch;
+
+extern "C" void ArrowBatch_dealloc(ArrowBatch* self);
+PyFUNC ArrowBatch_schema(ArrowBatch* self);
+PyFUNC ArrowBatch_array(ArrowBatch* self, PyObject* args, PyObject* keywds);
+PyFUNC ArrowBatch_stream(ArrowBatch* self, PyObject* args, PyObject* keywds);
+extern "C" Py_ssize_t ArrowBatch_length(ArrowBatch* self);
+
+static PyMethodDef arrowbatch_methods[] = {
+    {
+        "__arrow_c_schema__", (PyCFunction)ArrowBatch_schema, METH_NOARGS,
+        PYERG_ARROWBATCH_SCHEMA_DOC
+    },
+    {
+        "__arrow_c_array__", (PyCFunction)ArrowBatch_array, METH_VARARGS|METH_KEYWORDS,
+        PYERG_ARROWBATCH_ARRAY_DOC
+    },
+    {
+        "__arrow_c_stream__", (PyCFunction)ArrowBatch_stream, METH_VARARGS|METH_KEYWORDS,
+        PYERG_ARROWBATCH_STREAM_DOC
+    },
+    {nullptr}  /* Sentinel */
+};
+
+static PySequenceMethods arrowbatch_sequence = {
+    (lenfunc)ArrowBatch_length,     /* sq_length */
+};
+
+static PyTypeObject pyerg_ArrowBatchType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyerg.ArrowBatch",        /*tp_name*/
+    sizeof(ArrowBatch),        /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)ArrowBatch_dealloc,        /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    &arrowbatch_sequence,      /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    PYERG_ARROWBATCH_DOC,      /* tp_doc */
+    0,		               /* tp_traverse */
+    0,		               /* tp_clear */
+    0,		               /* tp_richcompare */
+    0,		               /* tp_weaklistoffset */
+    0,		               /* tp_iter */
+    0,		               /* tp_iternext */
+    arrowbatch_methods,        /* tp_methods */
+};
+
+PyFUNC py_read(PyObject* self, PyObject* args, PyObject* keywds);
 PyFUNC py_can_read(PyObject* self, PyObject* filename);
+PyFUNC py_probe(PyObject* self, PyObject* filename);
+PyFUNC py_open_view(PyObject* self, PyObject* filename);
+PyFUNC py_read_many(PyObject* self, PyObject* args, PyObject* keywds);
+PyFUNC py_read_segments(PyObject* self, PyObject* args, PyObject* keywds);
+PyFUNC py_write(PyObject* self, PyObject* args, PyObject* keywds);
 
 static PyMethodDef pyerg_methods[] = {
     {
         "read",
-        py_read,
-        METH_O,
+        (PyCFunction)py_read,
+        METH_VARARGS|METH_KEYWORDS,
         PYERG_READ_DOC
     },
     {
@@ -191,6 +499,36 @@ static PyMethodDef pyerg_methods[] = {
         METH_O,
         PYERG_CAN_READ_DOC
     },
+    {
+        "probe",
+        py_probe,
+        METH_O,
+        PYERG_PROBE_DOC
+    },
+    {
+        "open_view",
+        py_open_view,
+        METH_O,
+        PYERG_OPEN_VIEW_DOC
+    },
+    {
+        "read_many",
+        (PyCFunction)py_read_many,
+        METH_VARARGS|METH_KEYWORDS,
+        PYERG_READ_MANY_DOC
+    },
+    {
+        "read_segments",
+        (PyCFunction)py_read_segments,
+        METH_VARARGS|METH_KEYWORDS,
+        PYERG_READ_SEGMENTS_DOC
+    },
+    {
+        "write",
+        (PyCFunction)py_write,
+        METH_VARARGS|METH_KEYWORDS,
+        PYERG_WRITE_DOC
+    },
     {nullptr}
 };
 
@@ -55,11 +55,13 @@
 
 
 #define PYERG_READ_DOC  \
-    "data = read(filename)\n" \
+    "data = read(filename, columns=None, dtype=None)\n" \
     "Read a CarMaker *.erg file (with its *.erg.info file) and returns a Dict object " \
     "with all the datasets. The names of the datasets are the keys of the Dict.\n\n" \
     "Args:\n" \
     "    filename: Pathname of the erg file.\n" \
+    "    columns: Optional list of names or indices of the datasets to read.\n" \
+    "    dtype: Optional numpy integer or floating point type of the returned arrays.\n" \
     "Returns:\n" \
     "    Dict of numpy ndarray with the datasets in the file. The names of the datasets are " \
     "the keys of the Dict.\n" \
@@ -68,16 +70,91 @@
 
 #define PYERG_CAN_READ_DOC  \
     "ok = can_read(filename)\n" \
-    "Check if the CarMaker *.erg file (with its *.erg.info file) is valid and readable.\n\n" \
+    "Check if the CarMaker *.erg file (with its *.erg.info file) is valid and readable.\n" \
+    "Only the headers of the files are checked, see probe().\n\n" \
     "Args:\n" \
     "    filename: Pathname of the erg file.\n" \
     "Returns:\n" \
     "    True if the file is readable and a valid ERG, False otherwise." \
 
+#define PYERG_PROBE_DOC  \
+    "info = probe(filename)\n" \
+    "Check a CarMaker *.erg file (with its *.erg.info file) without parsing its datasets: " \
+    "only the header line, File.Format and File.ByteOrder of the info file and the header " \
+    "of the erg file are read.\n\n" \
+    "Args:\n" \
+    "    filename: Pathname of the erg file.\n" \
+    "Returns:\n" \
+    "    Dict with the 'format' ('erg' or 'fortran'), the 'byteOrder' ('little' or 'big'), " \
+    "the 'recordSize' in bytes and the number of 'records' of the file.\n" \
+    "Raises:\n" \
+    "    Exception if the file can't be read or is not an ERG file."
+
+#define PYERG_OPEN_VIEW_DOC  \
+    "data = open_view(filename)\n" \
+    "Memory map a CarMaker *.erg file (with its *.erg.info file) and returns a Dict object " \
+    "with read-only views of all the datasets. No data is read until the arrays are accessed.\n\n" \
+    "Args:\n" \
+    "    filename: Pathname of the erg file.\n" \
+    "Returns:\n" \
+    "    Dict of numpy ndarray views over the mapped file. The names of the datasets are " \
+    "the keys of the Dict.\n" \
+    "Raises:\n" \
+    "    Exception if the file can't be read, is not an ERG file or can't be memory mapped."
+
+#define PYERG_READ_MANY_DOC  \
+    "for filename, data in read_many(paths, columns=None, workers=0, chunk=262144)\n" \
+    "Read a batch of CarMaker *.erg files in parallel and yield each file as soon as it " \
+    "has been read, in completion order.\n\n" \
+    "A pool of threads opens the files and splits them in tasks of `chunk` rows: an idle " \
+    "thread steals the tasks of the busy ones, so a large file does not delay the batch.\n\n" \
+    "Args:\n" \
+    "    paths: List of pathnames of the erg files.\n" \
+    "    columns: List of names of the datasets to read, all the datasets if None.\n" \
+    "    workers: Number of threads, at most 1024, 0 for all the hardware threads.\n" \
+    "    chunk: Maximum number of rows read by each task.\n" \
+    "Returns:\n" \
+    "    Iterator of (filename, Dict) tuples. The Dict holds a numpy ndarray for each " \
+    "dataset, with the names of the datasets as keys.\n" \
+    "Raises:\n" \
+    "    RuntimeError when the iteration reaches a file that can't be read or misses a dataset."
+
+#define PYERG_READ_SEGMENTS_DOC  \
+    "data = read_segments(paths, columns=None, start=0, count=-1, dtype=None, threads=1)\n" \
+    "Read consecutive segments of a recording, split in several *.erg files with the same " \
+    "datasets, as a single file. Each dataset is read in place into a single array, without " \
+    "concatenating the arrays of the segments.\n\n" \
+    "Args:\n" \
+    "    paths: List of pathnames of the erg files, in record order.\n" \
+    "    columns: List of names of the datasets to read, all the datasets if None.\n" \
+    "    start: Index of the first row, counted from the start of the first segment.\n" \
+    "    count: Maximum number of rows, all the rows up to the end of the last segment if negative.\n" \
+    "    dtype: Optional numpy type of the returned arrays.\n" \
+    "    threads: Number of segments read concurrently, 0 for all the hardware threads.\n" \
+    "Returns:\n" \
+    "    Dict of numpy ndarray. The names of the datasets are the keys of the Dict.\n" \
+    "Raises:\n" \
+    "    Exception if a segment can't be read or its datasets differ from the first segment."
+
+#define PYERG_WRITE_DOC  \
+    "write(filename, data, units=None, byteorder='little')\n" \
+    "Write a CarMaker *.erg file and its *.erg.info file from a Dict of arrays. The arrays " \
+    "are transposed into the records in C++, without a Python loop over the rows.\n\n" \
+    "Args:\n" \
+    "    filename: Pathname of the erg file.\n" \
+    "    data: Dict of 1-D numpy arrays with the same length, with the names of the datasets " \
+    "as keys. Integer, boolean and floating point types are supported.\n" \
+    "    units: Optional Dict with the unit of some datasets.\n" \
+    "    byteorder: Byte order of the file, 'little' or 'big'.\n" \
+    "Raises:\n" \
+    "    Exception if the file can't be written or a dataset can't be stored."
+
 
 #define PYERG_PARSER_OPEN_DOC   \
     "Open an `.erg` file, parse the its header and the companion file.\n" \
-    "This function look for the `<filename>.info` in the same place of the `.erg` file.\n\n" \
+    "This function look for the `<filename>.info` in the same place of the `.erg` file.\n" \
+    "With pyerg.Reader(lazy=True) the datasets are parsed by the first access to them " \
+    "or to the data, which raises the errors in their definitions.\n\n" \
     "Args:\n" \
     "    filename: Pathname of the erg file.\n" \
     "Raises:\n" \
@@ -100,8 +177,189 @@
     "Returns:\n" \
     "    The number of quantities.\n"
 
+#define PYERG_PARSER_SETTHREADS_DOC   \
+    "Set the number of threads used to read the data.\n" \
+    "Large reads are split in ranges of records that are read concurrently.\n\n" \
+    "Args:\n" \
+    "    threads: Number of threads, 0 to use all the hardware threads. Default is 1."
+
+#define PYERG_PARSER_THREADS_DOC   \
+    "Number of threads used to read the data.\n\n" \
+    "Returns:\n" \
+    "    The number of threads."
+
+#define PYERG_PARSER_SETPREFETCH_DOC   \
+    "Set the number of blocks of records read ahead of the decoding.\n" \
+    "A background thread loads the next blocks while the current one is decoded, so that " \
+    "the I/O and the decoding overlap.\n\n" \
+    "Args:\n" \
+    "    buffers: Number of blocks read ahead, 0 to disable the pipeline. Default is 0."
+
+#define PYERG_PARSER_PREFETCH_DOC   \
+    "Number of blocks of records read ahead of the decoding.\n\n" \
+    "Returns:\n" \
+    "    The number of blocks, 0 if the pipeline is disabled."
+
+#define PYERG_PARSER_SETACCESS_DOC   \
+    "Set the expected access pattern to the data, forwarded to the kernel as I/O hints.\n" \
+    "It can be set in the constructor as well: pyerg.Reader(filename, access='sequential').\n\n" \
+    "Args:\n" \
+    "    access: 'normal', 'sequential' for full scans, 'random' for small windows, 'once' to " \
+    "drop the data from the page cache after reading it or 'direct' to bypass the page cache. " \
+    "'direct' falls back to 'once' if the file system does not support it."
+
+#define PYERG_PARSER_ACCESS_DOC   \
+    "Access pattern to the data.\n\n" \
+    "Returns:\n" \
+    "    The name of the access pattern in use."
+
+#define PYERG_PARSER_SETCACHESIZE_DOC   \
+    "Set the memory budget of the decoded dataset cache.\n" \
+    "A read of most of a dataset decodes all of it into the cache, if it fits the budget, and " \
+    "the following reads of any range of it, with any dtype, are served from the cache. The " \
+    "least recently used datasets are evicted to " \
+    "stay within the budget. The cache is cleared by open(), close() and refresh().\n\n" \
+    "Args:\n" \
+    "    bytes: Memory budget in bytes, 0 to disable the cache. Default is 0."
+
+#define PYERG_PARSER_CACHESIZE_DOC   \
+    "Memory budget of the decoded dataset cache.\n\n" \
+    "Returns:\n" \
+    "    The budget in bytes, 0 if the cache is disabled."
+
+#define PYERG_PARSER_CACHESTATS_DOC   \
+    "Statistics of the decoded dataset cache.\n\n" \
+    "Returns:\n" \
+    "    Dict with the number of 'hits', 'misses' and 'evictions', the 'bytes' used and the " \
+    "number of cached 'columns'."
+
+#define PYERG_PARSER_BUILDSIDECAR_DOC   \
+    "Write the column-major sidecar file (`<filename>.col`) of the open file.\n" \
+    "The sidecar file stores each dataset as a contiguous array, so a dataset is read with " \
+    "a single contiguous read. It is used by open() while the `.erg` file does not change. " \
+    "It can be built by open() as well: pyerg.Reader(filename, sidecar='build'), while " \
+    "sidecar='ignore' never reads it.\n\n" \
+    "Raises:\n" \
+    "    If the sidecar file can't be written."
+
+#define PYERG_PARSER_HASSIDECAR_DOC   \
+    "Check if the reads are served by a sidecar file.\n\n" \
+    "Returns:\n" \
+    "    True if a valid sidecar file is in use."
+
+#define PYERG_PARSER_RECORDAT_DOC   \
+    "Index of the first record at or after a time.\n" \
+    "The `Time` dataset is searched with a binary search that reads only O(log n) records, so it " \
+    "must be monotonic. A time index built by buildTimeIndex() serves non-monotonic or " \
+    "multi-segment files as well.\n\n" \
+    "Args:\n" \
+    "    time: The time to search.\n" \
+    "Returns:\n" \
+    "    The index of the record, records() if all the records are before time.\n" \
+    "Raises:\n" \
+    "    NameError if the file has no `Time` dataset."
+
+#define PYERG_PARSER_READTIMERANGE_DOC   \
+    "Read the records in a time interval.\n" \
+    "The records start at recordAt(t0) and end before the first following record with a time " \
+    "outside [t0, t1].\n\n" \
+    "Args:\n" \
+    "    t0: Start of the interval.\n" \
+    "    t1: End of the interval, included.\n" \
+    "    columns: Optional list of dataset names or indices. Default are all the datasets.\n" \
+    "    dtype: Optional numpy integer or floating point type of the returned arrays.\n" \
+    "Returns:\n" \
+    "    Dict of numpy ndarray with the quantity names as keys.\n" \
+    "Raises:\n" \
+    "    NameError if the file has no `Time` dataset."
+
+#define PYERG_PARSER_RESAMPLE_DOC   \
+    "Read datasets resampled on the uniform time grid t0 + k*dt in [t0, t1].\n" \
+    "The records are interpolated against the `Time` dataset, which must be monotonic, while " \
+    "they are streamed: the full rate datasets are never read into arrays. The points outside " \
+    "of the file get the first or the last value.\n\n" \
+    "Args:\n" \
+    "    t0: First time of the grid.\n" \
+    "    t1: Last time of the grid.\n" \
+    "    dt: Time step.\n" \
+    "    columns: Optional list of dataset names or indices. Default are all the numeric datasets.\n" \
+    "    method: 'linear' (default), 'nearest' or 'previous' (zero-order hold).\n" \
+    "Returns:\n" \
+    "    Dict of float64 numpy ndarray with the quantity names as keys.\n" \
+    "Raises:\n" \
+    "    NameError if the file has no `Time` dataset."
+
+#define PYERG_PARSER_BUILDTIMEINDEX_DOC   \
+    "Write the sparse time index (`<filename>.tidx`) of the open file.\n" \
+    "The index stores the minimum and maximum time of each block of records. It is loaded by " \
+    "open() while the `.erg` file does not change.\n\n" \
+    "Args:\n" \
+    "    block: Number of records of each block. Default is 4096.\n" \
+    "Raises:\n" \
+    "    If the time index can't be written."
+
+#define PYERG_PARSER_HASTIMEINDEX_DOC   \
+    "Check if the time searches are served by a time index.\n\n" \
+    "Returns:\n" \
+    "    True if a valid time index is loaded."
+
+#define PYERG_PARSER_WHERE_DOC   \
+    "Indices of the records matching all the conditions.\n" \
+    "The records are scanned in blocks: with a zone map the blocks that can't match are skipped " \
+    "without reading them.\n\n" \
+    "Args:\n" \
+    "    conditions: List of (quantity, operator, value) tuples, with the quantity name or index " \
+    "and one of the operators '<', '<=', '>', '>=', '==' and '!='.\n" \
+    "Returns:\n" \
+    "    Numpy ndarray with the indices of the matching records.\n" \
+    "Example:\n" \
+    "    rows = reader.where([('Vhcl.v', '>', 30), ('Brake.Pedal', '>', 0.1)])"
+
+#define PYERG_PARSER_READWHERE_DOC   \
+    "Read the records matching all the conditions.\n" \
+    "Only the matching records are returned, without reading the whole datasets.\n\n" \
+    "Args:\n" \
+    "    conditions: List of (quantity, operator, value) tuples, as in where().\n" \
+    "    columns: Optional list of dataset names or indices. Default are all the datasets.\n" \
+    "    dtype: Optional numpy integer or floating point type of the returned arrays.\n" \
+    "Returns:\n" \
+    "    Dict of numpy ndarray with the quantity names as keys."
+
+#define PYERG_PARSER_BUILDZONEMAP_DOC   \
+    "Compute the zone map of the open file: the minimum and maximum of each dataset in each " \
+    "block of records, used by where() and readWhere() to skip the blocks.\n" \
+    "A persisted zone map (`<filename>.zmap`) is loaded by open() while the `.erg` file does not change.\n\n" \
+    "Args:\n" \
+    "    block: Number of records of each block. Default is 4096.\n" \
+    "    persist: Write the zone map next to the file. Default is True.\n" \
+    "Raises:\n" \
+    "    If the zone map can't be written."
+
+#define PYERG_PARSER_HASZONEMAP_DOC   \
+    "Check if the filtered reads are served by a zone map.\n\n" \
+    "Returns:\n" \
+    "    True if a zone map is loaded."
+
+#define PYERG_PARSER_STATS_DOC   \
+    "Statistics of a range of records, computed in a single pass without reading the datasets " \
+    "into arrays. The range is split between the reader threads.\n\n" \
+    "Args:\n" \
+    "    columns: Optional list of dataset names or indices. Default are all the numeric datasets.\n" \
+    "    start: Index of the first record or a slice. Default is 0.\n" \
+    "    count: Number of records. Default are all the records.\n" \
+    "    bins: Number of bins of the histogram. Default is 0, no histogram.\n" \
+    "    range: (low, high) edges of the histogram, required with bins.\n" \
+    "Returns:\n" \
+    "    Dict with the quantity names as keys of dicts with count, nan, min, max, mean, " \
+    "std (population standard deviation), rms and histogram. The NaN values are counted in " \
+    "nan and excluded from the other statistics."
+
 #define PYERG_PARSER_READALL_DOC   \
     "Read all the datasets from the file.\n\n" \
+    "Args:\n" \
+    "    dtype: Optional numpy integer or floating point type of the returned arrays: the data is " \
+    "converted while it is read. Floating point values are saturated to the range of an integer " \
+    "type, and nan is converted to 0.\n" \
     "Returns:\n" \
     "    Dict with all the datasets as numpy ndarray with the quantity names as keys." \
     "See:\n" \
@@ -109,16 +367,103 @@
     "that will be used."
 
 #define PYERG_PARSER_READ_DOC   \
-    "Read a single dataset from the file.\n\n" \
+    "Read a single dataset, or a list of datasets in a single pass, from the file.\n\n" \
+    "The datasets can be read with the subscript operator as well: " \
+    "reader[name], reader[name, start:stop:step] or reader[[names], start:stop:step].\n\n" \
     "Args:\n" \
-    "    name: Index or name of the dataset to read.\n" \
-    "    start: Index of the row from which to start reading.\n" \
-    "    count: Number of rows to read.\n" \
+    "    name: Index or name of the dataset to read, or a list of them.\n" \
+    "    start: Index of the row from which to start reading, negative values count from the end " \
+    "of the file. It can be a slice object as well.\n" \
+    "    count: Number of rows to read, all the rows up to the end of the file if negative.\n" \
+    "    step: Read a row every step rows.\n" \
+    "    names: List of indices or names of the datasets to read.\n" \
+    "    dtype: Optional numpy integer or floating point type of the returned arrays: the data is " \
+    "converted while it is read. Floating point values are saturated to the range of an integer " \
+    "type, and nan is converted to 0.\n" \
     "Returns:\n" \
-    "    Numpy ndarray with the data.\n"  \
+    "    Numpy ndarray with the data, or a Dict of numpy ndarray with the dataset names " \
+    "as keys if a list of datasets is requested.\n"  \
     "Raises:\n" \
     "    If the quantity index is out of range or the quantity name does not exists."
 
+#define PYERG_PARSER_REFRESH_DOC   \
+    "Update the number of rows of a file that is still being written.\n\n" \
+    "Only the file size is checked: a trailing partial row is ignored until it is complete.\n\n" \
+    "Returns:\n" \
+    "    The number of rows appended since the previous update.\n" \
+    "Raises:\n" \
+    "    If another thread is reading from the file."
+
+#define PYERG_PARSER_READNEW_DOC   \
+    "Read the rows appended to the file since the previous call.\n\n" \
+    "The record count is refreshed first, and the first call returns all the rows in the file.\n\n" \
+    "Args:\n" \
+    "    columns: Optional list of indices or names of the datasets to read, all the datasets " \
+    "if None.\n" \
+    "    timeout: Seconds to wait for new rows if there are none, the default does not wait.\n" \
+    "Returns:\n" \
+    "    Dict of numpy ndarray with the dataset names as keys. The arrays are empty if no row " \
+    "has been appended.\n" \
+    "Raises:\n" \
+    "    If a quantity does not exists or another thread is reading from the file."
+
+#define PYERG_PARSER_ITERCHUNKS_DOC   \
+    "Iterate over the file in chunks of rows, for files larger than the memory.\n\n" \
+    "Each chunk is read in a single pass over the records and only one chunk at a time " \
+    "needs to be kept in memory.\n\n" \
+    "    for batch in reader.iter_chunks(rows=1000000, columns=['Time', 'Vhcl.v']):\n" \
+    "        ...\n\n" \
+    "Args:\n" \
+    "    rows: Maximum number of rows in each chunk.\n" \
+    "    columns: Optional list of indices or names of the datasets to read, all the datasets " \
+    "if None.\n" \
+    "    dtype: Optional numpy integer or floating point type of the returned arrays.\n" \
+    "Returns:\n" \
+    "    Iterator of Dict of numpy ndarray with the dataset names as keys.\n" \
+    "Raises:\n" \
+    "    If a quantity does not exists or rows is not positive."
+
+#define PYERG_CHUNKITERATOR_DOC   \
+    "Iterator over the chunks of rows of a file, returned by Reader.iter_chunks()."
+
+#define PYERG_BATCHITERATOR_DOC   \
+    "Iterator over the files of a batch, returned by read_many()."
+
+#define PYERG_ARROWBATCH_DOC   \
+    "Datasets read by Reader.arrow(), exported through the Arrow PyCapsule interface as a " \
+    "struct array with a child for each dataset. len() is the number of rows."
+
+#define PYERG_ARROWBATCH_SCHEMA_DOC   \
+    "Arrow PyCapsule interface: schema of the batch.\n\n" \
+    "Returns:\n" \
+    "    A PyCapsule named 'arrow_schema'."
+
+#define PYERG_ARROWBATCH_ARRAY_DOC   \
+    "Arrow PyCapsule interface: schema and data of the batch.\n\n" \
+    "Args:\n" \
+    "    requested_schema: Ignored, the datasets are exported with their own types.\n" \
+    "Returns:\n" \
+    "    A tuple of PyCapsules named 'arrow_schema' and 'arrow_array'."
+
+#define PYERG_ARROWBATCH_STREAM_DOC   \
+    "Arrow PyCapsule interface: stream with the batch as its only array.\n\n" \
+    "Args:\n" \
+    "    requested_schema: Ignored, the datasets are exported with their own types.\n" \
+    "Returns:\n" \
+    "    A PyCapsule named 'arrow_array_stream'."
+
+#define PYERG_PARSER_VIEW_DOC   \
+    "Read-only views of datasets over the memory mapped file.\n\n" \
+    "The arrays use the record size as stride and share the mapping, which stays valid " \
+    "after the reader is closed: the pages of the file are loaded only when they are accessed.\n\n" \
+    "Args:\n" \
+    "    name: Index or name of the dataset, or a list of them.\n" \
+    "Returns:\n" \
+    "    Numpy ndarray view of the dataset, or a Dict of numpy ndarray views with the dataset " \
+    "names as keys if a list of datasets is requested.\n" \
+    "Raises:\n" \
+    "    If the quantity does not exists or the file is not memory mapped."
+
 #define PYERG_PARSER_QUANTITYSIZE_DOC   \
     "Size in bytes of the dataset at the current index.\n" \
     "Args:\n" \
@@ -181,6 +526,42 @@
     "Returns:\n" \
     "    True if the quantity is present inside the file, False otherwise."
 
+#define PYERG_PARSER_SELECT_DOC   \
+    "Indices of the quantities with the names that match a pattern.\n\n" \
+    "Args:\n" \
+    "    pattern: Wildcard pattern, where `*` matches any sequence of characters and `?` " \
+    "any character, e.g. 'Car.WheelSpd_*'.\n" \
+    "    regex: If True, the pattern is a regular expression (ECMAScript syntax) that must " \
+    "match the whole name.\n" \
+    "Returns:\n" \
+    "    List of quantity indices in file order, usable as the `names` of read().\n" \
+    "Raises:\n" \
+    "    ValueError if the regular expression is not valid."
+
+#define PYERG_PARSER_ARROW_DOC   \
+    "Read datasets into a batch that implements the Arrow PyCapsule interface.\n\n" \
+    "The datasets are read once into buffers that pyarrow, polars, duckdb and the other " \
+    "Arrow consumers take over without copying them, e.g. pyarrow.record_batch(batch) or " \
+    "polars.DataFrame(batch). The unit of each dataset is stored in the 'unit' metadata of " \
+    "its field.\n\n" \
+    "Args:\n" \
+    "    columns: Optional list of names or indices of the datasets, all the datasets if None.\n" \
+    "    start: Index of the first row.\n" \
+    "    count: Maximum number of rows, all the rows up to the end of the file if negative.\n" \
+    "Returns:\n" \
+    "    An ArrowBatch with a column for each dataset.\n" \
+    "Raises:\n" \
+    "    If a quantity does not exists or the data can't be read."
+
+#define PYERG_PARSER_ARROWCSTREAM_DOC   \
+    "Arrow PyCapsule interface: export all the datasets as a stream with a single batch.\n\n" \
+    "Args:\n" \
+    "    requested_schema: Ignored, the datasets are exported with their own types.\n" \
+    "Returns:\n" \
+    "    A PyCapsule named 'arrow_array_stream'.\n" \
+    "See also:\n" \
+    "    arrow()"
+
 #define PYERG_PARSER_CLOSE_DOC   \
     "Close the current file and clear the data." \
 
@@ -33,9 +33,10 @@ numpyInclude0 = python_libs[0] + '/numpy/core/include'
 numpyInclude1 = python_libs[1] + '/numpy/core/include'
 
 pyergCmodule = Extension('pyerg',
-                         ['erg/erg.cpp', 'pyerg/pyerg.cpp'],
+                         ['erg/erg.cpp', 'erg/multireader.cpp', 'erg/segmentedreader.cpp', 'erg/writer.cpp', 'pyerg/pyerg.cpp'],
                          include_dirs=[numpyInclude0, numpyInclude1, 'erg'],
-                         extra_compile_args=['-std=c++11'],
+                         extra_compile_args=['-std=c++11', '-pthread'],
+                         extra_link_args=['-pthread'],
                          language='c++')
 
 classifiers = [
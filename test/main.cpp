@@ -30,8 +30,20 @@
 
 #include <gtest/gtest.h>
 #include <math.h>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <dirent.h>
+#include <unistd.h>
 
 #include "erg.h"
+#include "multireader.h"
+#include "segmentedreader.h"
+#include "writer.h"
 
 const std::string ERG_1_FILENAME = "../../test-data/Test-Dataset-1_175937.erg";
 //const std::string ERG_2_FILENAME = "../../test-data/test_data2.erg";
@@ -39,6 +51,60 @@ const std::string ERG_1_FILENAME = "../../test-data/Test-Dataset-1_175937.erg";
 //const std::string ERG_4_FILENAME = "../../test-data/fortran_data.erg";
 
 
+/*!
+ * \brief Tests that write next to a copy of the test dataset.
+ *
+ * The copies live in a temporary directory, which is removed also when an
+ * assertion fails.
+ */
+class ReaderFiles : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        std::string pattern = ::testing::TempDir() + "erg-test-XXXXXX";
+        ASSERT_NE(mkdtemp(&pattern[0]), nullptr);
+        mFolder = pattern;
+    }
+
+    void TearDown() override
+    {
+        DIR* dir = opendir(mFolder.c_str());
+        if(dir!=nullptr) {
+            for(dirent* entry=readdir(dir); entry!=nullptr; entry=readdir(dir))
+            {
+                if(std::strcmp(entry->d_name, ".")!=0 && std::strcmp(entry->d_name, "..")!=0)
+                    std::remove(path(entry->d_name).c_str());
+            }
+            closedir(dir);
+        }
+        rmdir(mFolder.c_str());
+    }
+
+    //! Path of a file in the temporary directory
+    std::string path(const std::string& name) const
+    {
+        return mFolder + "/" + name;
+    }
+
+    //! Copy the test dataset and its info file as `name` in the temporary directory
+    std::string copyDataset(const std::string& name) const
+    {
+        const std::string filename = path(name);
+        std::ifstream src(ERG_1_FILENAME, std::ios_base::binary);
+        std::ofstream dst(filename, std::ios_base::binary);
+        dst << src.rdbuf();
+        std::ifstream srcInfo(ERG_1_FILENAME+".info");
+        std::ofstream info(filename+".info");
+        info << srcInfo.rdbuf();
+        return filename;
+    }
+
+private:
+    std::string mFolder;
+};
+
+
 TEST(Reader, Open)
 {
     // If the file is ok, the open function don't throws
@@ -312,6 +378,1225 @@ TEST(Reader, Read)
     }
 }
 
+TEST(Reader, ReadProjection)
+{
+    erg::Reader parser;
+    ASSERT_NO_THROW(parser.open(ERG_1_FILENAME));
+
+    std::vector<double> Time(100, 0.0);
+    std::vector<float> speed(100, 0.0f);
+    std::vector<int32_t> gear(100, 0);
+    std::vector<uint8_t*> values = {reinterpret_cast<uint8_t*>(Time.data()),
+                                    reinterpret_cast<uint8_t*>(speed.data()),
+                                    reinterpret_cast<uint8_t*>(gear.data())};
+    std::vector<size_t> sizes = {Time.size()*sizeof(double), speed.size()*sizeof(float), gear.size()*sizeof(int32_t)};
+    std::vector<std::string> names = {"Time", "Vhcl.v", "Driver.GearNo"};
+    size_t numRows = parser.read(names, 1000, 100, values, sizes);
+    ASSERT_EQ(numRows, 100);
+
+    std::vector<float> speed2(100, 0.0f);
+    parser.read(parser.index("Vhcl.v"), 1000, 100, reinterpret_cast<uint8_t*>(speed2.data()), speed2.size()*sizeof(float));
+    ASSERT_TRUE(speed==speed2);
+
+    for(size_t i=0; i<numRows; ++i)
+    {
+        const long value = std::lround(Time[i]*1000.0);
+        ASSERT_EQ(value, static_cast<long>(i+1000));
+    }
+
+    std::vector<size_t> badIndices = {0, parser.numQuanities()};
+    std::vector<uint8_t*> badValues(2, values[0]);
+    std::vector<size_t> badSizes(2, sizes[0]);
+    ASSERT_ANY_THROW(parser.read(badIndices, 0, 100, badValues, badSizes));
+    sizes[1] = 10;
+    ASSERT_ANY_THROW(parser.read(names, 0, 100, values, sizes));
+}
+
+TEST(Reader, ReadStep)
+{
+    for(erg::Backend backend: {erg::Backend::Mmap, erg::Backend::Stream})
+    {
+        erg::Reader parser(ERG_1_FILENAME, backend);
+        const size_t timeIndex = parser.index("Time");
+
+        std::vector<double> Time(parser.records(), 0.0);
+        parser.read(timeIndex, reinterpret_cast<uint8_t*>(Time.data()), Time.size()*sizeof(double));
+
+        for(size_t step: {1, 3, 200, 100000})
+        {
+            for(size_t threads: {1, 4})
+            {
+                parser.setThreads(threads);
+                const size_t from = 17;
+                const size_t rows = parser.rangeSize(from, parser.records(), step);
+                ASSERT_EQ(rows, (parser.records() - from + step - 1) / step);
+
+                std::vector<double> strided(rows, 0.0);
+                size_t numRows = parser.read(timeIndex, from, parser.records(), step,
+                                             reinterpret_cast<uint8_t*>(strided.data()), strided.size()*sizeof(double));
+                ASSERT_EQ(numRows, rows);
+                for(size_t i=0; i<rows; ++i)
+                    ASSERT_EQ(strided[i], Time[from + i*step]);
+            }
+        }
+
+        ASSERT_EQ(parser.rangeSize(parser.records(), 10, 1), 0);
+        ASSERT_ANY_THROW(parser.read(timeIndex, 0, 10, 0, reinterpret_cast<uint8_t*>(Time.data()), Time.size()*sizeof(double)));
+    }
+}
+
+TEST(Reader, ReadTyped)
+{
+    erg::Reader parser(ERG_1_FILENAME);
+    parser.setThreads(4);
+
+    const size_t speedIndex = parser.index("Vhcl.v");
+    const size_t gearIndex = parser.index("Driver.GearNo");
+    std::vector<float> speed(parser.records(), 0.0f);
+    std::vector<int32_t> gear(parser.records(), 0);
+    parser.read(speedIndex, reinterpret_cast<uint8_t*>(speed.data()), speed.size()*sizeof(float));
+    parser.read(gearIndex, reinterpret_cast<uint8_t*>(gear.data()), gear.size()*sizeof(int32_t));
+
+    std::vector<double> speed2(parser.records(), 0.0);
+    ASSERT_EQ(parser.read<double>(speedIndex, 0, parser.records(), speed2.data()), parser.records());
+    std::vector<double> gear2(parser.records(), 0.0);
+    ASSERT_EQ(parser.read<double>(gearIndex, 0, parser.records(), gear2.data()), parser.records());
+    for(size_t i=0; i<parser.records(); ++i)
+    {
+        ASSERT_EQ(speed2[i], static_cast<double>(speed[i]));
+        ASSERT_EQ(gear2[i], static_cast<double>(gear[i]));
+    }
+
+    std::vector<float> Time(100, 0.0f);
+    ASSERT_EQ(parser.read<float>(parser.index("Time"), 1000, 100, 10, Time.data()), 100);
+    for(size_t i=0; i<Time.size(); ++i)
+        ASSERT_EQ(std::lround(Time[i]*1000.0), 1000 + i*10);
+
+    std::vector< std::vector<double> > data(parser.numQuanities(), std::vector<double>(parser.records()));
+    std::vector<double*> values;
+    for(std::vector<double>& v: data)
+        values.push_back(v.data());
+    ASSERT_EQ(parser.readAll<double>(values), parser.records());
+    ASSERT_TRUE(data[speedIndex]==speed2);
+    ASSERT_TRUE(data[gearIndex]==gear2);
+
+    ASSERT_ANY_THROW(parser.read<double>(parser.numQuanities(), 0, 10, speed2.data()));
+}
+
+TEST_F(ReaderFiles, ReadTypedSaturated)
+{
+    const std::string filename = path("saturated.erg");
+
+    // Floating point values out of the range of the integer types, and nan
+    std::vector<erg::Quantity> quantities(1);
+    quantities[0].name = "Value";
+    quantities[0].type = erg::Type::Double;
+    const std::vector<double> values = {std::nan(""), 1e300, -1e300, 3e9, -3e9, 42.7, -42.7};
+    {
+        erg::Writer writer(filename, quantities);
+        writer.writeColumns({values.data()}, values.size());
+    }
+
+    erg::Reader parser(filename);
+    std::vector<int32_t> i32(values.size());
+    ASSERT_EQ(parser.read<int32_t>(0, 0, values.size(), i32.data()), values.size());
+    const std::vector<int32_t> expected32 = {0, std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min(),
+                                             std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min(),
+                                             42, -42};
+    ASSERT_EQ(i32, expected32);
+
+    std::vector<uint64_t> u64(values.size());
+    ASSERT_EQ(parser.read<uint64_t>(0, 0, values.size(), u64.data()), values.size());
+    const std::vector<uint64_t> expected64 = {0, std::numeric_limits<uint64_t>::max(), 0, 3000000000ULL, 0, 42, 0};
+    ASSERT_EQ(u64, expected64);
+}
+
+TEST(Reader, ReadAllThreads)
+{
+    for(erg::Backend backend: {erg::Backend::Mmap, erg::Backend::Stream})
+    {
+        erg::Reader serial(ERG_1_FILENAME, backend);
+        erg::Reader parallel(ERG_1_FILENAME, backend);
+        parallel.setThreads(4);
+        ASSERT_EQ(parallel.threads(), 4);
+
+        std::vector< std::vector<uint8_t> > d0(serial.numQuanities());
+        std::vector< std::vector<uint8_t> > d1(parallel.numQuanities());
+        std::vector<uint8_t*> p0, p1;
+        std::vector<size_t> s0, s1;
+        for(size_t i=0; i<serial.numQuanities(); ++i)
+        {
+            d0[i].assign(serial.quantitySize(i), 0);
+            d1[i].assign(parallel.quantitySize(i), 1);
+            p0.push_back(d0[i].data());
+            p1.push_back(d1[i].data());
+            s0.push_back(d0[i].size());
+            s1.push_back(d1[i].size());
+        }
+        ASSERT_EQ(serial.readAll(p0, s0), serial.records());
+        ASSERT_EQ(parallel.readAll(p1, s1), parallel.records());
+        ASSERT_TRUE(d0==d1);
+    }
+
+    erg::Reader parser;
+    parser.setThreads(0);
+    ASSERT_GE(parser.threads(), 1);
+}
+
+TEST(Reader, ConcurrentRead)
+{
+    for(erg::Backend backend: {erg::Backend::Mmap, erg::Backend::Stream})
+    {
+        const erg::Reader parser(ERG_1_FILENAME, backend);
+        const size_t numThreads = 8;
+
+        // Each thread reads a different quantity in slices from the same reader
+        std::vector< std::vector<float> > data(numThreads, std::vector<float>(parser.records(), 0.0f));
+        std::vector<std::thread> threads;
+        for(size_t t=0; t<numThreads; ++t)
+        {
+            threads.push_back(std::thread([&parser, &data, t]() {
+                const size_t step = 10000;
+                for(size_t from=0; from<parser.records(); from+=step)
+                    parser.read(t+1, from, step, reinterpret_cast<uint8_t*>(data[t].data() + from),
+                                (parser.records()-from)*sizeof(float));
+            }));
+        }
+        for(std::thread& t: threads)
+            t.join();
+
+        for(size_t t=0; t<numThreads; ++t)
+        {
+            std::vector<float> expected(parser.records(), 0.0f);
+            parser.read(t+1, reinterpret_cast<uint8_t*>(expected.data()), expected.size()*sizeof(float));
+            ASSERT_TRUE(expected==data[t]);
+        }
+    }
+}
+
+TEST(Reader, Backend)
+{
+    erg::Reader mapped;
+    ASSERT_NO_THROW(mapped.open(ERG_1_FILENAME, erg::Backend::Auto));
+    erg::Reader stream;
+    ASSERT_NO_THROW(stream.open(ERG_1_FILENAME, erg::Backend::Stream));
+    ASSERT_EQ(stream.backend(), erg::Backend::Stream);
+    ASSERT_EQ(mapped.records(), stream.records());
+
+    const size_t speedIndex = mapped.index("Vhcl.v");
+    std::vector<float> v0(mapped.records(), 0.0f);
+    std::vector<float> v1(stream.records(), 0.0f);
+    ASSERT_EQ(mapped.read(speedIndex, reinterpret_cast<uint8_t*>(v0.data()), v0.size()*sizeof(float)), mapped.records());
+    ASSERT_EQ(stream.read(speedIndex, reinterpret_cast<uint8_t*>(v1.data()), v1.size()*sizeof(float)), stream.records());
+    ASSERT_TRUE(v0==v1);
+
+    // Ranges past the end of the file are truncated by both backends
+    std::vector<float> t0(100, 0.0f);
+    std::vector<float> t1(100, 0.0f);
+    size_t from = mapped.records() - 10;
+    ASSERT_EQ(mapped.read(speedIndex, from, 100, reinterpret_cast<uint8_t*>(t0.data()), t0.size()*sizeof(float)), 10);
+    ASSERT_EQ(stream.read(speedIndex, from, 100, reinterpret_cast<uint8_t*>(t1.data()), t1.size()*sizeof(float)), 10);
+    ASSERT_TRUE(t0==t1);
+
+    // Both backends transpose the whole file in the same way
+    std::vector< std::vector<uint8_t> > d0(mapped.numQuanities());
+    std::vector< std::vector<uint8_t> > d1(stream.numQuanities());
+    std::vector<uint8_t*> p0, p1;
+    std::vector<size_t> s0, s1;
+    for(size_t i=0; i<mapped.numQuanities(); ++i)
+    {
+        d0[i].assign(mapped.quantitySize(i), 0);
+        d1[i].assign(stream.quantitySize(i), 1);
+        p0.push_back(d0[i].data());
+        p1.push_back(d1[i].data());
+        s0.push_back(d0[i].size());
+        s1.push_back(d1[i].size());
+    }
+    ASSERT_EQ(mapped.readAll(p0, s0), mapped.records());
+    ASSERT_EQ(stream.readAll(p1, s1), stream.records());
+    ASSERT_TRUE(d0==d1);
+}
+
+TEST(Reader, MappedData)
+{
+    erg::Reader parser;
+    ASSERT_NO_THROW(parser.open(ERG_1_FILENAME, erg::Backend::Stream));
+    ASSERT_FALSE(parser.mappedData());
+
+    ASSERT_NO_THROW(parser.open(ERG_1_FILENAME, erg::Backend::Mmap));
+    std::shared_ptr<const uint8_t> data = parser.mappedData();
+    ASSERT_TRUE(data!=nullptr);
+
+    const size_t speedIndex = parser.index("Vhcl.v");
+    const size_t records = parser.records();
+    const size_t recordSize = parser.recordSize();
+    const size_t offset = parser.quantityOffset(speedIndex);
+    std::vector<float> v(records, 0.0f);
+    parser.read(speedIndex, reinterpret_cast<uint8_t*>(v.data()), v.size()*sizeof(float));
+
+    // The mapping outlives the reader
+    parser.close();
+    for(size_t i=0; i<records; ++i)
+    {
+        float value = 0.0f;
+        std::memcpy(&value, data.get() + i*recordSize + offset, sizeof(float));
+        ASSERT_EQ(value, v[i]);
+    }
+}
+
+TEST(Reader, Chunks)
+{
+    erg::Reader parser;
+    ASSERT_NO_THROW(parser.open(ERG_1_FILENAME));
+    const size_t timeIndex = parser.index("Time");
+    const size_t speedIndex = parser.index("Vhcl.v");
+    std::vector<double> t(parser.records(), 0.0);
+    std::vector<float> v(parser.records(), 0.0f);
+    parser.read(timeIndex, reinterpret_cast<uint8_t*>(t.data()), t.size()*sizeof(double));
+    parser.read(speedIndex, reinterpret_cast<uint8_t*>(v.data()), v.size()*sizeof(float));
+
+    ASSERT_THROW(parser.chunks(0), std::runtime_error);
+    ASSERT_THROW(parser.chunks(10, std::vector<std::string>{"NotExists"}), std::runtime_error);
+
+    erg::Chunks chunks = parser.chunks(1000, std::vector<std::string>{"Time", "Vhcl.v"});
+    size_t rows = 0;
+    while(chunks.next())
+    {
+        ASSERT_EQ(chunks.from(), rows);
+        ASSERT_LE(chunks.rows(), 1000);
+        const double* ct = reinterpret_cast<const double*>(chunks.data(0));
+        const float* cv = reinterpret_cast<const float*>(chunks.data(1));
+        for(size_t i=0; i<chunks.rows(); ++i)
+        {
+            ASSERT_EQ(ct[i], t[rows+i]);
+            ASSERT_EQ(cv[i], v[rows+i]);
+        }
+        rows += chunks.rows();
+    }
+    ASSERT_EQ(rows, parser.records());
+    ASSERT_FALSE(chunks.next());
+
+    chunks.rewind();
+    ASSERT_TRUE(chunks.next());
+    ASSERT_EQ(chunks.from(), 0);
+    ASSERT_EQ(parser.chunks(1).quantities().size(), parser.numQuanities());
+}
+
+TEST_F(ReaderFiles, Follow)
+{
+    const std::string filename = path("follow.erg");
+
+    // Simulation still writing the file: start with the header and a partial record
+    std::ifstream srcInfo(ERG_1_FILENAME+".info");
+    std::ofstream info(filename+".info");
+    info << srcInfo.rdbuf();
+    info.close();
+
+    erg::Reader full;
+    ASSERT_NO_THROW(full.open(ERG_1_FILENAME));
+    const size_t recordSize = full.recordSize();
+    const size_t speedIndex = full.index("Vhcl.v");
+    std::vector<float> v(full.records(), 0.0f);
+    full.read(speedIndex, reinterpret_cast<uint8_t*>(v.data()), v.size()*sizeof(float));
+
+    std::ifstream src(ERG_1_FILENAME, std::ios_base::binary);
+    std::vector<char> content(16 + 200*recordSize, 0);
+    src.read(content.data(), content.size());
+
+    std::ofstream out(filename, std::ios_base::binary);
+    out.write(content.data(), 16 + recordSize/2);
+    out.flush();
+
+    erg::Reader parser;
+    ASSERT_NO_THROW(parser.open(filename));
+    ASSERT_EQ(parser.records(), 0);
+    ASSERT_FALSE(parser.waitForGrowth(10));
+    erg::Chunks chunks = parser.chunks(64, std::vector<std::string>{"Vhcl.v"});
+    ASSERT_FALSE(chunks.next());
+
+    // Complete the first record and append 99 more
+    out.write(content.data() + 16 + recordSize/2, 100*recordSize - recordSize/2);
+    out.flush();
+    ASSERT_TRUE(parser.waitForGrowth(1000));
+    ASSERT_EQ(parser.refresh(), 100);
+    ASSERT_EQ(parser.newRecords(), 100);
+
+    std::vector<size_t> qindices(1, speedIndex);
+    std::vector<float> chunk(100, 0.0f);
+    std::vector<uint8_t*> values(1, reinterpret_cast<uint8_t*>(chunk.data()));
+    std::vector<size_t> sizes(1, chunk.size()*sizeof(float));
+    ASSERT_EQ(parser.readNew(qindices, values, sizes), 100);
+    ASSERT_TRUE(std::equal(chunk.begin(), chunk.end(), v.begin()));
+    ASSERT_EQ(parser.readNew(qindices, values, sizes), 0);
+
+    // The chunk buffers grow with the file
+    ASSERT_TRUE(chunks.next());
+    ASSERT_EQ(chunks.rows(), 64);
+    ASSERT_TRUE(std::equal(v.begin(), v.begin()+64, reinterpret_cast<const float*>(chunks.data(0))));
+    ASSERT_TRUE(chunks.next());
+    ASSERT_EQ(chunks.rows(), 36);
+    ASSERT_FALSE(chunks.next());
+
+    // Only the appended records are returned
+    out.write(content.data() + 16 + 100*recordSize, 50*recordSize + 3);
+    out.flush();
+    ASSERT_EQ(parser.refresh(), 50);
+    ASSERT_EQ(parser.readNew(qindices, values, sizes), 50);
+    ASSERT_TRUE(std::equal(chunk.begin(), chunk.begin()+50, v.begin()+100));
+    ASSERT_TRUE(chunks.next());
+    ASSERT_EQ(chunks.from(), 100);
+    ASSERT_EQ(chunks.rows(), 50);
+    ASSERT_TRUE(std::equal(v.begin()+100, v.begin()+150, reinterpret_cast<const float*>(chunks.data(0))));
+    out.close();
+
+    parser.close();
+}
+
+TEST(Reader, Prefetch)
+{
+    erg::Reader parser;
+    ASSERT_NO_THROW(parser.open(ERG_1_FILENAME, erg::Backend::Stream));
+    const size_t speedIndex = parser.index("Vhcl.v");
+    std::vector<float> v0(parser.records(), 0.0f);
+    std::vector<float> v1(parser.records(), 1.0f);
+    parser.read(speedIndex, reinterpret_cast<uint8_t*>(v0.data()), v0.size()*sizeof(float));
+
+    parser.setPrefetch(3);
+    ASSERT_EQ(parser.prefetch(), 3);
+    ASSERT_EQ(parser.read(speedIndex, reinterpret_cast<uint8_t*>(v1.data()), v1.size()*sizeof(float)),
+              parser.records());
+    ASSERT_TRUE(v0==v1);
+
+    // Strided and truncated reads through the pipeline
+    std::vector<float> s(parser.records(), 0.0f);
+    const size_t from = 7;
+    const size_t rows = parser.read(speedIndex, from, parser.records(), 3, reinterpret_cast<uint8_t*>(s.data()),
+                                    s.size()*sizeof(float));
+    ASSERT_EQ(rows, (parser.records() - from + 2) / 3);
+    for(size_t i=0; i<rows; ++i)
+        ASSERT_EQ(s[i], v0[from + i*3]);
+
+    // Asynchronous read with a completion callback
+    std::vector<float> a(parser.records(), 0.0f);
+    std::vector<size_t> qindices(1, speedIndex);
+    std::vector<uint8_t*> values(1, reinterpret_cast<uint8_t*>(a.data()));
+    std::vector<size_t> sizes(1, a.size()*sizeof(float));
+    std::atomic<size_t> notified(0);
+    std::future<size_t> result = parser.readAsync(qindices, 0, parser.records(), 1, values, sizes,
+                                                  [&notified](size_t n) { notified = n; });
+    ASSERT_EQ(result.get(), parser.records());
+    ASSERT_EQ(notified.load(), parser.records());
+    ASSERT_TRUE(a==v0);
+
+    std::vector<uint8_t*> tooSmall(1, values[0]);
+    std::vector<size_t> small(1, 4);
+    std::future<size_t> failed = parser.readAsync(qindices, 0, parser.records(), 1, tooSmall, small);
+    ASSERT_THROW(failed.get(), std::runtime_error);
+}
+
+TEST(Reader, Access)
+{
+    erg::Reader parser;
+    ASSERT_NO_THROW(parser.open(ERG_1_FILENAME));
+    ASSERT_EQ(parser.access(), erg::Access::Normal);
+    const size_t speedIndex = parser.index("Vhcl.v");
+    std::vector<float> expected(parser.records(), 0.0f);
+    parser.read(speedIndex, reinterpret_cast<uint8_t*>(expected.data()), expected.size()*sizeof(float));
+
+    const erg::Access policies[] = {erg::Access::Sequential, erg::Access::Random, erg::Access::Once,
+                                    erg::Access::Direct, erg::Access::Normal};
+    for(const erg::Access access: policies)
+    {
+        parser.setAccess(access);
+        if(access==erg::Access::Direct) {
+            // Direct falls back to Once if the file system does not support it
+            ASSERT_EQ(parser.backend(), erg::Backend::Stream);
+            ASSERT_TRUE(parser.access()==erg::Access::Direct || parser.access()==erg::Access::Once);
+        } else {
+            ASSERT_EQ(parser.access(), access);
+        }
+
+        std::vector<float> v(parser.records(), 0.0f);
+        ASSERT_EQ(parser.read(speedIndex, reinterpret_cast<uint8_t*>(v.data()), v.size()*sizeof(float)),
+                  parser.records());
+        ASSERT_TRUE(v==expected);
+
+        // Unaligned window at the end of the file
+        std::vector<float> w(100, 0.0f);
+        ASSERT_EQ(parser.read(speedIndex, parser.records()-33, 100, reinterpret_cast<uint8_t*>(w.data()),
+                              w.size()*sizeof(float)), 33);
+        ASSERT_TRUE(std::equal(w.begin(), w.begin()+33, expected.end()-33));
+    }
+    ASSERT_EQ(parser.backend(), erg::Backend::Mmap);
+}
+
+TEST(Reader, Cache)
+{
+    erg::Reader parser;
+    ASSERT_NO_THROW(parser.open(ERG_1_FILENAME));
+    ASSERT_EQ(parser.cacheSize(), 0);
+    const size_t speedIndex = parser.index("Vhcl.v");
+    const size_t timeIndex = parser.index("Time");
+    std::vector<float> expected(parser.records(), 0.0f);
+    parser.read(speedIndex, reinterpret_cast<uint8_t*>(expected.data()), expected.size()*sizeof(float));
+    ASSERT_EQ(parser.cacheStats().columns, 0);
+
+    // Room for the speed or the time, not for both
+    parser.setCacheSize(parser.quantitySize(speedIndex) + parser.quantitySize(timeIndex) - 1);
+    std::vector<float> v(parser.records(), 0.0f);
+    parser.read(speedIndex, reinterpret_cast<uint8_t*>(v.data()), v.size()*sizeof(float));
+    erg::CacheStats stats = parser.cacheStats();
+    ASSERT_EQ(stats.misses, 1);
+    ASSERT_EQ(stats.columns, 1);
+    ASSERT_EQ(stats.bytes, parser.quantitySize(speedIndex));
+
+    std::vector<float> w(100, 0.0f);
+    ASSERT_EQ(parser.read(speedIndex, 10, 100, 3, reinterpret_cast<uint8_t*>(w.data()), w.size()*sizeof(float)), 100);
+    ASSERT_EQ(parser.cacheStats().hits, 1);
+    for(size_t i=0; i<w.size(); ++i)
+        ASSERT_EQ(w[i], expected[10 + i*3]);
+    ASSERT_EQ(parser.read(speedIndex, parser.records()-5, 100, reinterpret_cast<uint8_t*>(w.data()),
+                          w.size()*sizeof(float)), 5);
+    ASSERT_EQ(w[4], expected.back());
+
+    // The time evicts the speed
+    std::vector<double> t(parser.records(), 0.0);
+    parser.read(timeIndex, reinterpret_cast<uint8_t*>(t.data()), t.size()*sizeof(double));
+    ASSERT_EQ(parser.cacheStats().columns, 1);
+    ASSERT_EQ(parser.cacheStats().evictions, 1);
+    parser.read(speedIndex, reinterpret_cast<uint8_t*>(v.data()), v.size()*sizeof(float));
+    ASSERT_TRUE(v==expected);
+
+    // Typed reads are converted from the cached column
+    std::vector<double> d(parser.records(), 0.0);
+    const size_t hits = parser.cacheStats().hits;
+    parser.read<double>(speedIndex, 0, parser.records(), d.data());
+    ASSERT_EQ(parser.cacheStats().hits, hits + 1);
+    ASSERT_EQ(d[100], expected[100]);
+    ASSERT_EQ(parser.read<double>(speedIndex, 7, 100, 5, d.data()), 100);
+    for(size_t i=0; i<100; ++i)
+        ASSERT_EQ(d[i], expected[7 + i*5]);
+
+    // A small range of a missing column is read from the file
+    std::vector<double> u(parser.records(), 0.0);
+    ASSERT_EQ(parser.read(timeIndex, 10, 100, reinterpret_cast<uint8_t*>(u.data()), u.size()*sizeof(double)), 100);
+    ASSERT_EQ(parser.cacheStats().bytes, parser.quantitySize(speedIndex));
+    ASSERT_TRUE(std::equal(u.begin(), u.begin() + 100, t.begin() + 10));
+
+    // A range covering most of the file loads the whole column
+    const size_t rows = parser.records() - 20;
+    ASSERT_EQ(parser.read(timeIndex, 10, rows, reinterpret_cast<uint8_t*>(u.data()), u.size()*sizeof(double)), rows);
+    ASSERT_EQ(parser.cacheStats().bytes, parser.quantitySize(timeIndex));
+    ASSERT_EQ(parser.cacheStats().evictions, 3);
+    ASSERT_TRUE(std::equal(u.begin(), u.begin() + rows, t.begin() + 10));
+    const size_t misses = parser.cacheStats().misses;
+    ASSERT_EQ(parser.read(timeIndex, 20, 100, reinterpret_cast<uint8_t*>(u.data()), u.size()*sizeof(double)), 100);
+    ASSERT_EQ(parser.cacheStats().misses, misses);
+    ASSERT_TRUE(std::equal(u.begin(), u.begin() + 100, t.begin() + 20));
+
+    parser.close();
+    ASSERT_EQ(parser.cacheStats().columns, 0);
+    ASSERT_EQ(parser.cacheStats().bytes, 0);
+}
+
+TEST_F(ReaderFiles, Sidecar)
+{
+    const std::string filename = copyDataset("sidecar.erg");
+
+    erg::Reader expected(ERG_1_FILENAME);
+    const size_t speedIndex = expected.index("Vhcl.v");
+    std::vector<float> v(expected.records(), 0.0f);
+    expected.read(speedIndex, reinterpret_cast<uint8_t*>(v.data()), v.size()*sizeof(float));
+
+    erg::Reader parser;
+    ASSERT_EQ(parser.sidecar(), erg::Sidecar::Use);
+    ASSERT_NO_THROW(parser.open(filename));
+    ASSERT_FALSE(parser.hasSidecar());
+    ASSERT_NO_THROW(parser.buildSidecar());
+    ASSERT_TRUE(parser.hasSidecar());
+
+    // A valid sidecar file is used by open()
+    parser.close();
+    ASSERT_NO_THROW(parser.open(filename));
+    ASSERT_TRUE(parser.hasSidecar());
+
+    std::vector<float> s(parser.records(), 0.0f);
+    ASSERT_EQ(parser.read(speedIndex, reinterpret_cast<uint8_t*>(s.data()), s.size()*sizeof(float)), parser.records());
+    ASSERT_TRUE(s==v);
+    const size_t rows = parser.read(speedIndex, 3, parser.records(), 7, reinterpret_cast<uint8_t*>(s.data()),
+                                    s.size()*sizeof(float));
+    ASSERT_EQ(rows, (parser.records() - 3 + 6) / 7);
+    for(size_t i=0; i<rows; ++i)
+        ASSERT_EQ(s[i], v[3 + i*7]);
+    ASSERT_EQ(parser.read(speedIndex, 11, 5, 5000, reinterpret_cast<uint8_t*>(s.data()), s.size()*sizeof(float)), 5);
+    ASSERT_EQ(s[4], v[11 + 4*5000]);
+
+    // Typed and whole file reads through the sidecar file
+    std::vector<double> d(parser.records(), 0.0);
+    parser.read<double>(speedIndex, 0, parser.records(), d.data());
+    ASSERT_EQ(d[1000], v[1000]);
+
+    // The sidecar file is ignored when the source file changes
+    parser.close();
+    {
+        std::ofstream dst(filename, std::ios_base::binary | std::ios_base::app);
+        dst.write("x", 1);
+    }
+    ASSERT_NO_THROW(parser.open(filename));
+    ASSERT_FALSE(parser.hasSidecar());
+    parser.close();
+
+    parser.setSidecar(erg::Sidecar::Build);
+    ASSERT_NO_THROW(parser.open(filename));
+    ASSERT_TRUE(parser.hasSidecar());
+    parser.close();
+
+    // Also when it is rewritten with the same size right after the sidecar file
+    {
+        std::fstream dst(filename, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+        dst.seekp(16);
+        dst.write("x", 1);
+    }
+    parser.setSidecar(erg::Sidecar::Use);
+    ASSERT_NO_THROW(parser.open(filename));
+    ASSERT_FALSE(parser.hasSidecar());
+    parser.close();
+}
+
+TEST_F(ReaderFiles, TimeRange)
+{
+    const std::string filename = copyDataset("tidx.erg");
+
+    erg::Reader parser(filename);
+    ASSERT_FALSE(parser.hasTimeIndex());
+    const size_t timeIndex = parser.index("Time");
+    const size_t speedIndex = parser.index("Vhcl.v");
+    std::vector<double> t(parser.records(), 0.0);
+    parser.read<double>(timeIndex, 0, parser.records(), t.data());
+    std::vector<float> v(parser.records(), 0.0f);
+    parser.read(speedIndex, reinterpret_cast<uint8_t*>(v.data()), v.size()*sizeof(float));
+
+    const double t0 = t[1000] - 1e-9;
+    const double t1 = t[2500];
+    for(int pass=0; pass<2; ++pass)
+    {
+        ASSERT_EQ(parser.recordAt(t0), 1000);
+        ASSERT_EQ(parser.recordAt(t[0] - 1.0), 0);
+        ASSERT_EQ(parser.recordAt(t.back() + 1.0), parser.records());
+        ASSERT_EQ(parser.recordAt((t[77] + t[78]) / 2.0), 78);
+
+        size_t from = 0;
+        ASSERT_EQ(parser.timeRange(t0, t1, from), 1501);
+        ASSERT_EQ(from, 1000);
+        ASSERT_EQ(parser.timeRange(t1, t0, from), 0);
+
+        std::vector<float> s(parser.records(), 0.0f);
+        std::vector<uint8_t*> values(1, reinterpret_cast<uint8_t*>(s.data()));
+        std::vector<size_t> sizes(1, s.size()*sizeof(float));
+        ASSERT_EQ(parser.readTimeRange(std::vector<size_t>(1, speedIndex), t0, t1, values, sizes), 1501);
+        ASSERT_EQ(s[0], v[1000]);
+        ASSERT_EQ(s[1500], v[2500]);
+
+        // The same results from the time index, which is loaded by open()
+        ASSERT_NO_THROW(parser.buildTimeIndex(100));
+        parser.close();
+        ASSERT_NO_THROW(parser.open(filename));
+        ASSERT_TRUE(parser.hasTimeIndex());
+    }
+    parser.close();
+}
+
+TEST_F(ReaderFiles, Where)
+{
+    const std::string filename = copyDataset("zmap.erg");
+
+    erg::Reader parser(filename);
+    ASSERT_FALSE(parser.hasZoneMap());
+    const size_t timeIndex = parser.index("Time");
+    const size_t speedIndex = parser.index("Vhcl.v");
+    const size_t axIndex = parser.index("Car.ax");
+    std::vector<double> t(parser.records(), 0.0);
+    std::vector<double> v(parser.records(), 0.0);
+    std::vector<float> ax(parser.records(), 0.0f);
+    parser.read<double>(timeIndex, 0, parser.records(), t.data());
+    parser.read<double>(speedIndex, 0, parser.records(), v.data());
+    parser.read(axIndex, reinterpret_cast<uint8_t*>(ax.data()), ax.size()*sizeof(float));
+
+    const double tMid = t[t.size() / 2];
+    const double vMid = (*std::min_element(v.begin(), v.end()) + *std::max_element(v.begin(), v.end())) / 2.0;
+    const std::vector<erg::Predicate> predicates = {{speedIndex, erg::Compare::Greater, vMid},
+                                                    {timeIndex, erg::Compare::GreaterEqual, tMid}};
+    std::vector<size_t> expected;
+    for(size_t i=0; i<t.size(); ++i)
+    {
+        if(v[i]>vMid && t[i]>=tMid)
+            expected.push_back(i);
+    }
+
+    for(int pass=0; pass<2; ++pass)
+    {
+        ASSERT_TRUE(parser.where(predicates)==expected);
+        ASSERT_EQ(parser.where({}).size(), parser.records());
+        ASSERT_TRUE(parser.where({{timeIndex, erg::Compare::Less, t[0]}}).empty());
+        ASSERT_EQ(parser.where({{timeIndex, erg::Compare::LessEqual, t[999]}}).size(), 1000);
+        ASSERT_ANY_THROW(parser.where({{parser.numQuanities(), erg::Compare::Equal, 0.0}}));
+
+        std::vector<std::vector<uint8_t>> values;
+        ASSERT_EQ(parser.readWhere(predicates, {axIndex, speedIndex}, values), expected.size());
+        ASSERT_EQ(values[0].size(), expected.size()*sizeof(float));
+        const float* a = reinterpret_cast<const float*>(values[0].data());
+        for(size_t i=0; i<expected.size(); ++i)
+            ASSERT_EQ(a[i], ax[expected[i]]);
+
+        // The same results from the zone map, which is loaded by open()
+        ASSERT_NO_THROW(parser.buildZoneMap(256));
+        parser.close();
+        ASSERT_NO_THROW(parser.open(filename));
+        ASSERT_TRUE(parser.hasZoneMap());
+    }
+    parser.close();
+}
+
+TEST(Reader, Stats)
+{
+    erg::Reader parser(ERG_1_FILENAME);
+    const size_t speedIndex = parser.index("Vhcl.v");
+    const size_t timeIndex = parser.index("Time");
+    std::vector<double> v(parser.records(), 0.0);
+    parser.read<double>(speedIndex, 0, parser.records(), v.data());
+
+    const size_t from = 100;
+    const size_t count = parser.records() - 200;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    for(size_t i=from; i<from+count; ++i)
+    {
+        sum += v[i];
+        sumSquares += v[i] * v[i];
+    }
+    const double mean = sum / count;
+    double m2 = 0.0;
+    for(size_t i=from; i<from+count; ++i)
+        m2 += (v[i] - mean) * (v[i] - mean);
+
+    erg::StatsOptions options;
+    options.bins = 10;
+    options.low = *std::min_element(v.begin() + from, v.begin() + from + count);
+    options.high = *std::max_element(v.begin() + from, v.begin() + from + count);
+
+    for(size_t threads: {1, 4})
+    {
+        parser.setThreads(threads);
+        const std::vector<erg::Stats> stats = parser.stats({speedIndex, timeIndex}, from, count, options);
+        ASSERT_EQ(stats.size(), 2);
+        const erg::Stats& s = stats[0];
+        ASSERT_EQ(s.count, count);
+        ASSERT_EQ(s.nans, 0);
+        ASSERT_EQ(s.min, options.low);
+        ASSERT_EQ(s.max, options.high);
+        ASSERT_NEAR(s.mean, mean, 1e-9 * std::abs(mean) + 1e-12);
+        ASSERT_NEAR(s.stddev, std::sqrt(m2 / count), 1e-9 * std::sqrt(m2 / count) + 1e-12);
+        ASSERT_NEAR(s.rms, std::sqrt(sumSquares / count), 1e-9 * std::sqrt(sumSquares / count));
+        ASSERT_EQ(s.histogram.size(), 10);
+        size_t total = 0;
+        for(size_t bin: s.histogram)
+            total += bin;
+        ASSERT_EQ(total, count);
+        ASSERT_EQ(stats[1].count, count);
+    }
+
+    // Empty ranges
+    const std::vector<erg::Stats> empty = parser.stats({speedIndex}, parser.records(), 10);
+    ASSERT_EQ(empty[0].count, 0);
+    ASSERT_TRUE(empty[0].mean!=empty[0].mean);
+    ASSERT_ANY_THROW(parser.stats({parser.numQuanities()}, 0, 10));
+}
+
+TEST(Reader, Resample)
+{
+    erg::Reader parser(ERG_1_FILENAME);
+    const size_t timeIndex = parser.index("Time");
+    const size_t speedIndex = parser.index("Vhcl.v");
+    std::vector<double> t(parser.records(), 0.0);
+    std::vector<double> v(parser.records(), 0.0);
+    parser.read<double>(timeIndex, 0, parser.records(), t.data());
+    parser.read<double>(speedIndex, 0, parser.records(), v.data());
+
+    // The grid starts before the first record and ends after the last one
+    const double step = (t.back() - t.front()) / (t.size() - 1);
+    const double dt = 3.7 * step;
+    const double t0 = t.front() - 10.0 * dt;
+    const double t1 = t.back() + 10.0 * dt;
+    const size_t points = erg::Reader::gridSize(t0, t1, dt);
+    ASSERT_EQ(erg::Reader::gridSize(0.0, 1.0, 0.1), 11);
+    ASSERT_EQ(erg::Reader::gridSize(1.0, 0.0, 0.1), 0);
+
+    for(erg::Interpolation method: {erg::Interpolation::Nearest, erg::Interpolation::Linear, erg::Interpolation::Previous})
+    {
+        std::vector<double> speed(points, 0.0);
+        std::vector<double*> values(1, speed.data());
+        ASSERT_EQ(parser.resample({speedIndex}, t0, t1, dt, method, values), points);
+
+        for(size_t k=0; k<points; ++k)
+        {
+            const double g = t0 + k * dt;
+            const size_t j1 = std::upper_bound(t.begin(), t.end(), g) - t.begin();
+            double expected;
+            if(j1==0)
+                expected = v.front();
+            else if(j1==t.size())
+                expected = v.back();
+            else if(method==erg::Interpolation::Previous)
+                expected = v[j1 - 1];
+            else if(method==erg::Interpolation::Nearest)
+                expected = t[j1] - g<g - t[j1 - 1] ? v[j1] : v[j1 - 1];
+            else if(g==t[j1 - 1])
+                expected = v[j1 - 1];
+            else
+                expected = v[j1 - 1] + (g - t[j1 - 1]) / (t[j1] - t[j1 - 1]) * (v[j1] - v[j1 - 1]);
+            ASSERT_DOUBLE_EQ(speed[k], expected) << "point " << k;
+        }
+    }
+
+    std::vector<double*> values(1, nullptr);
+    ASSERT_ANY_THROW(parser.resample({speedIndex}, t0, t1, 0.0, erg::Interpolation::Linear, values));
+}
+
+TEST(Reader, MultiReader)
+{
+    erg::Reader parser(ERG_1_FILENAME);
+    const size_t speedIndex = parser.index("Vhcl.v");
+    std::vector<uint8_t> speed(parser.quantitySize(speedIndex));
+    parser.read(speedIndex, speed.data(), speed.size());
+
+    // Small chunks to split the file in many tasks stolen by the threads
+    const size_t chunkRows = parser.records() / 7 + 1;
+    std::vector<std::string> filenames(5, ERG_1_FILENAME);
+    filenames.insert(filenames.begin() + 2, "missing.erg");
+    ASSERT_ANY_THROW(erg::MultiReader(filenames, {"Vhcl.v"}, 2, 0));
+
+    erg::MultiReader batch(filenames, {"Time", "Vhcl.v"}, 3, chunkRows);
+    ASSERT_EQ(batch.size(), filenames.size());
+    ASSERT_EQ(batch.workers(), 3);
+
+    std::vector<bool> returned(filenames.size(), false);
+    erg::FileResult result;
+    while(batch.next(result))
+    {
+        ASSERT_LT(result.index, filenames.size());
+        ASSERT_FALSE(returned[result.index]);
+        returned[result.index] = true;
+        ASSERT_EQ(result.filename, filenames[result.index]);
+        if(result.index==2) {
+            ASSERT_FALSE(result.error.empty());
+            ASSERT_TRUE(result.data.empty());
+            continue;
+        }
+
+        ASSERT_TRUE(result.error.empty()) << result.error;
+        ASSERT_EQ(result.records, parser.records());
+        ASSERT_EQ(result.names, std::vector<std::string>({"Time", "Vhcl.v"}));
+        ASSERT_EQ(result.types[1], parser.quantityType(speedIndex));
+        ASSERT_EQ(result.data[1], speed);
+    }
+    ASSERT_EQ(std::count(returned.begin(), returned.end(), true), filenames.size());
+    ASSERT_FALSE(batch.next(result));
+
+    // Missing quantities are reported for each file
+    erg::MultiReader invalid({ERG_1_FILENAME}, {"Missing.Quantity"}, 1);
+    ASSERT_TRUE(invalid.next(result));
+    ASSERT_FALSE(result.error.empty());
+}
+
+TEST_F(ReaderFiles, Segmented)
+{
+    erg::Reader full(ERG_1_FILENAME);
+    const size_t recordSize = full.recordSize();
+    const size_t records = full.records();
+    const size_t timeIndex = full.index("Time");
+    const size_t speedIndex = full.index("Vhcl.v");
+    std::vector<uint8_t> speed(full.quantitySize(speedIndex));
+    full.read(speedIndex, speed.data(), speed.size());
+    std::vector<double> time(records, 0.0);
+    full.read<double>(timeIndex, 0, records, time.data());
+
+    // Split the file in segments, one of them empty
+    std::ifstream src(ERG_1_FILENAME, std::ios_base::binary);
+    std::vector<char> content(16 + records*recordSize, 0);
+    src.read(content.data(), content.size());
+    const std::vector<size_t> bounds = {0, records/3, records/3, records/2 + 1, records};
+    std::vector<std::string> filenames;
+    for(size_t s=0; s+1<bounds.size(); ++s)
+    {
+        const std::string filename = path("segment"+std::to_string(s)+".erg");
+        std::ofstream dst(filename, std::ios_base::binary);
+        dst.write(content.data(), 16);
+        dst.write(content.data() + 16 + bounds[s]*recordSize, (bounds[s + 1] - bounds[s])*recordSize);
+        std::ifstream srcInfo(ERG_1_FILENAME+".info");
+        std::ofstream info(filename+".info");
+        info << srcInfo.rdbuf();
+        filenames.push_back(filename);
+    }
+
+    erg::SegmentedReader run;
+    ASSERT_ANY_THROW(run.open({}));
+    ASSERT_ANY_THROW(run.open({filenames[0], path("missing.erg")}));
+    ASSERT_EQ(run.segments(), 0);
+    ASSERT_NO_THROW(run.open(filenames));
+    ASSERT_EQ(run.segments(), 4);
+    ASSERT_EQ(run.records(), records);
+    ASSERT_EQ(run.numQuanities(), full.numQuanities());
+    ASSERT_EQ(run.quantitySize(speedIndex), full.quantitySize(speedIndex));
+    ASSERT_EQ(run.segmentStart(3), records/2 + 1);
+
+    size_t local = 0;
+    ASSERT_EQ(run.locate(records/3, local), 2);
+    ASSERT_EQ(local, 0);
+    ASSERT_EQ(run.locate(records - 1, local), 3);
+    ASSERT_EQ(local, records - 1 - (records/2 + 1));
+    ASSERT_ANY_THROW(run.locate(records, local));
+
+    for(size_t threads: {1, 3})
+    {
+        run.setThreads(threads);
+        std::vector<uint8_t> rawSpeed(speed.size(), 0);
+        ASSERT_EQ(run.read(speedIndex, 0, records, rawSpeed.data(), rawSpeed.size()), records);
+        ASSERT_EQ(rawSpeed, speed);
+
+        // Strided range across the boundaries of the segments
+        const size_t from = records/3 - 5;
+        const size_t step = 7;
+        const size_t rows = run.rangeSize(from, records, step);
+        std::vector<double> t(records - from, 0.0);
+        ASSERT_EQ(run.read<double>(timeIndex, from, records, t.data()), records - from);
+        ASSERT_TRUE(std::equal(t.begin(), t.end(), time.begin() + from));
+        std::vector<double*> values(1, t.data());
+        ASSERT_EQ(run.read<double>({timeIndex}, from, records, step, values), rows);
+        for(size_t i=0; i<rows; ++i)
+            ASSERT_EQ(t[i], time[from + i*step]);
+    }
+
+    // The segments must have the same quantities
+    {
+        std::ofstream info(filenames[1]+".info", std::ios_base::app);
+        info << "File.At.1.Name = Extra" << std::endl;
+    }
+    ASSERT_ANY_THROW(run.open(filenames));
+}
+
+TEST_F(ReaderFiles, InfoFile)
+{
+    const std::string filename = path("info.erg");
+
+    // Keys in any order, CRLF line ends, comments, unrelated keys, a padding column and
+    // stray indices
+    {
+        std::ofstream info(filename+".info", std::ios_base::binary);
+        info << "#INFOFILE1.1 - Do not remove this line!\r\n"
+             << "Quantity.Speed.Unit = m/s # overridden below\r\n"
+             << "File.At.3.Type = Float\r\n"
+             << "File.Format = erg\r\n"
+             << "TestRun.Comment = a = b\r\n"
+             << "File.At.1.Name = Time\r\n"
+             << "# File.At.9.Name = Commented\r\n"
+             << "File.At.2.Type = 2 Bytes\r\n"
+             << "File.At.1.Type = Double\r\n"
+             << "File.At.3.Name =   Speed   \r\n"
+             << "File.At.5.Name = AfterTheGap\r\n"
+             << "File.At.5.Type = Double\r\n"
+             << "File.At.03.Type = Double\r\n"
+             << "File.At.99999999999999.Name = Stray\r\n"
+             << "File.At.184467440737095516170.Type = Double\r\n"
+             << "Description:\r\n"
+             << "\tMulti-line value\r\n"
+             << "Quantity.Speed.Unit = km/h\r\n"
+             << "File.ByteOrder = LittleEndian";
+        std::ofstream erg(filename, std::ios_base::binary);
+        const char header[16] = {'C', 'M', '-', 'E', 'R', 'G', 0, 0, 1, 0, 14, 0, 0, 0, 0, 0};
+        erg.write(header, sizeof(header));
+        const std::vector<char> records(3*14, 0);
+        erg.write(records.data(), records.size());
+    }
+
+    erg::Reader parser;
+    ASSERT_NO_THROW(parser.open(filename));
+    ASSERT_EQ(parser.records(), 3);
+    ASSERT_EQ(parser.recordSize(), 14);
+    ASSERT_EQ(parser.numQuanities(), 2);
+    ASSERT_EQ(parser.quantityName(0), "Time");
+    ASSERT_EQ(parser.quantityType(0), erg::Type::Double);
+    ASSERT_EQ(parser.quantityUnit(0), "");
+    ASSERT_EQ(parser.quantityName(1), "Speed");
+    ASSERT_EQ(parser.quantityType(1), erg::Type::Float);
+    ASSERT_EQ(parser.quantityOffset(1), 10);
+    ASSERT_EQ(parser.quantityUnit(1), "km/h");
+    ASSERT_FALSE(parser.has("AfterTheGap"));
+    ASSERT_FALSE(parser.has("Commented"));
+    ASSERT_FALSE(parser.has("Stray"));
+}
+
+TEST(Reader, Select)
+{
+    erg::Reader parser(ERG_1_FILENAME);
+    for(size_t i=0; i<parser.numQuanities(); ++i)
+    {
+        ASSERT_EQ(parser.find(parser.quantityName(i)), i);
+        ASSERT_TRUE(parser.has(parser.quantityName(i)));
+    }
+    ASSERT_EQ(parser.find("Missing.Quantity"), parser.numQuanities());
+    ASSERT_FALSE(parser.has("Missing.Quantity"));
+    ASSERT_FALSE(parser.has(""));
+    ASSERT_ANY_THROW(parser.index("Missing.Quantity"));
+
+    std::vector<size_t> expected;
+    for(size_t i=0; i<parser.numQuanities(); ++i)
+    {
+        if(parser.quantityName(i).compare(0, 4, "Car.")==0)
+            expected.push_back(i);
+    }
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(parser.select("Car.*"), expected);
+    ASSERT_EQ(parser.select(std::regex("Car\\..*")), expected);
+    ASSERT_EQ(parser.select("C?r*"), expected);
+    ASSERT_EQ(parser.select("*"), parser.select(std::regex(".*")));
+    ASSERT_EQ(parser.select("*").size(), parser.numQuanities());
+    ASSERT_EQ(parser.select("Vhcl.v"), std::vector<size_t>(1, parser.index("Vhcl.v")));
+    ASSERT_TRUE(parser.select("Vhcl.v?").empty());
+    ASSERT_TRUE(parser.select("Missing*").empty());
+
+    // The selection is usable by the read functions
+    std::vector<size_t> qindices = parser.select("Car.a[xy]");
+    ASSERT_TRUE(qindices.empty());
+    qindices = parser.select(std::regex("Car\\.a[xy]"));
+    ASSERT_EQ(qindices.size(), 2);
+    std::vector< std::vector<double> > data(qindices.size(), std::vector<double>(parser.records()));
+    std::vector<double*> values = {data[0].data(), data[1].data()};
+    ASSERT_EQ(parser.read<double>(qindices, 0, parser.records(), 1, values), parser.records());
+
+    parser.close();
+    ASSERT_FALSE(parser.has("Time"));
+    ASSERT_TRUE(parser.select("*").empty());
+}
+
+TEST_F(ReaderFiles, Probe)
+{
+    const std::string filename = path("probe.erg");
+
+    erg::Reader parser(ERG_1_FILENAME);
+    erg::ProbeInfo info;
+    ASSERT_NO_THROW(info = erg::probe(ERG_1_FILENAME));
+    ASSERT_EQ(info.format, erg::Format::Erg);
+    ASSERT_EQ(info.byteOrder, parser.byteOrder());
+    ASSERT_EQ(info.recordSize, parser.recordSize());
+    ASSERT_EQ(info.records, parser.records());
+    ASSERT_ANY_THROW(erg::probe(path("missing.erg")));
+
+    // Fortran binary data: each record is framed by its size. The last
+    // definition of a key is used.
+    {
+        std::ofstream info(filename+".info", std::ios_base::binary);
+        info << "#INFOFILE1.1 - Do not remove this line!\n"
+             << "File.Format = erg\n"
+             << "File.Format = FORTRAN_Binary_Data\n"
+             << "File.ByteOrder = LittleEndian\n"
+             << "File.At.1.Name = Time\n"
+             << "File.At.1.Type = Double\n"
+             << "File.At.2.Name = Gear\n"
+             << "File.At.2.Type = Int\n";
+        std::ofstream erg(filename, std::ios_base::binary);
+        for(int32_t i=0; i<5; ++i)
+        {
+            const uint32_t size = 12;
+            const double time = 0.5 * i;
+            erg.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            erg.write(reinterpret_cast<const char*>(&time), sizeof(time));
+            erg.write(reinterpret_cast<const char*>(&i), sizeof(i));
+            erg.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        }
+    }
+    ASSERT_NO_THROW(info = erg::probe(filename));
+    ASSERT_EQ(info.format, erg::Format::Fortran);
+    ASSERT_EQ(info.recordSize, 20);
+    ASSERT_EQ(info.records, 5);
+
+    ASSERT_NO_THROW(parser.open(filename));
+    ASSERT_EQ(parser.records(), 5);
+    ASSERT_EQ(parser.quantityOffset(1), 12);
+    std::vector<int32_t> gear(5);
+    ASSERT_EQ(parser.read(1, 0, 5, gear.data()), 5);
+    ASSERT_EQ(gear[4], 4);
+    parser.close();
+
+    // The header line of the companion file is required
+    {
+        std::ofstream info(filename+".info", std::ios_base::binary);
+        info << "File.Format = FORTRAN_Binary_Data\n"
+             << "File.ByteOrder = LittleEndian\n";
+    }
+    ASSERT_ANY_THROW(erg::probe(filename));
+}
+
+TEST_F(ReaderFiles, LazyOpen)
+{
+    const std::string filename = path("lazy.erg");
+
+    erg::Reader parser(ERG_1_FILENAME);
+    erg::Reader lazy;
+    lazy.setLazyOpen(true);
+    ASSERT_TRUE(lazy.lazyOpen());
+    ASSERT_NO_THROW(lazy.open(ERG_1_FILENAME));
+    ASSERT_EQ(lazy.records(), parser.records());
+    ASSERT_EQ(lazy.recordSize(), parser.recordSize());
+    ASSERT_TRUE(lazy.has("Time"));
+    ASSERT_EQ(lazy.numQuanities(), parser.numQuanities());
+
+    const size_t qindex = parser.numQuanities() - 1;
+    ASSERT_EQ(lazy.quantityName(qindex), parser.quantityName(qindex));
+    std::vector<double> expected(parser.records());
+    std::vector<double> values(lazy.records());
+    ASSERT_EQ(parser.read(qindex, 0, parser.records(), expected.data()), parser.records());
+
+    // The first access to the data loads the quantities
+    lazy.open(ERG_1_FILENAME);
+    ASSERT_EQ(lazy.read(qindex, 0, lazy.records(), values.data()), lazy.records());
+    ASSERT_EQ(values, expected);
+
+    // The quantity definitions are parsed by the first access
+    {
+        std::ofstream info(filename+".info", std::ios_base::binary);
+        info << "#INFOFILE1.1 - Do not remove this line!\n"
+             << "File.Format = erg\n"
+             << "File.ByteOrder = LittleEndian\n"
+             << "File.At.1.Name = Time\n"
+             << "File.At.1.Type = Double\n";
+        std::ofstream erg(filename, std::ios_base::binary);
+        const char header[16] = {'C', 'M', '-', 'E', 'R', 'G', 0, 0, 1, 0, 12, 0, 0, 0, 0, 0};
+        erg.write(header, sizeof(header));
+        const std::vector<char> records(2*12, 0);
+        erg.write(records.data(), records.size());
+    }
+    ASSERT_ANY_THROW(parser.open(filename));
+    ASSERT_NO_THROW(lazy.open(filename));
+    ASSERT_EQ(lazy.records(), 2);
+    std::string error;
+    try {
+        lazy.load();
+    } catch(std::runtime_error& e) {
+        error = e.what();
+    }
+    ASSERT_FALSE(error.empty());
+    ASSERT_EQ(lazy.numQuanities(), 0);
+    ASSERT_FALSE(lazy.has("Time"));
+
+    // The parsing error is thrown again, without reading the companion file
+    std::remove((filename+".info").c_str());
+    for(size_t i=0; i<2; ++i) {
+        try {
+            lazy.index("Time");
+            FAIL() << "The parsing error is not thrown";
+        } catch(std::runtime_error& e) {
+            ASSERT_EQ(std::string(e.what()), error);
+        }
+    }
+    ASSERT_ANY_THROW(lazy.quantityName(0));
+}
+
+TEST_F(ReaderFiles, Writer)
+{
+    const std::string filename = path("writer.erg");
+
+    std::vector<erg::Quantity> quantities(4);
+    quantities[0].name = "Time";
+    quantities[0].unit = "s";
+    quantities[0].type = erg::Type::Double;
+    quantities[1].name = "Vhcl.v";
+    quantities[1].unit = "m/s";
+    quantities[1].type = erg::Type::Float;
+    quantities[2].name = "Gear";
+    quantities[2].type = erg::Type::Int16;
+    quantities[3].name = "Flag";
+    quantities[3].type = erg::Type::Uint8;
+
+    const size_t rows = 10000;
+    std::vector<double> time(rows);
+    std::vector<float> speed(rows);
+    std::vector<int16_t> gear(rows);
+    std::vector<uint8_t> flag(rows);
+    for(size_t i=0; i<rows; ++i)
+    {
+        time[i] = 0.01 * i;
+        speed[i] = 0.5f * i;
+        gear[i] = static_cast<int16_t>(i % 7) - 1;
+        flag[i] = static_cast<uint8_t>(i);
+    }
+
+    for(const erg::ByteOrder byteOrder: {erg::ByteOrder::LittelEndian, erg::ByteOrder::BigEndian})
+    {
+        erg::Writer writer;
+        // Several flushes of the write buffer
+        writer.setBufferSize(4096);
+        ASSERT_NO_THROW(writer.open(filename, quantities, byteOrder));
+        ASSERT_EQ(writer.recordSize(), 15);
+        ASSERT_EQ(writer.quantities()[3].offset, 14);
+        // Half of the records from the columns, half packed
+        const size_t half = rows / 2;
+        ASSERT_NO_THROW(writer.writeColumns({time.data(), speed.data(), gear.data(), flag.data()}, half));
+        std::vector<uint8_t> records(half * writer.recordSize());
+        for(size_t i=0; i<half; ++i)
+        {
+            uint8_t* record = records.data() + i * writer.recordSize();
+            std::memcpy(record, &time[half + i], 8);
+            std::memcpy(record + 8, &speed[half + i], 4);
+            std::memcpy(record + 12, &gear[half + i], 2);
+            record[14] = flag[half + i];
+        }
+        ASSERT_NO_THROW(writer.writeRecords(records.data(), half));
+        ASSERT_EQ(writer.records(), rows);
+        ASSERT_NO_THROW(writer.close());
+
+        erg::Reader parser;
+        ASSERT_NO_THROW(parser.open(filename));
+        ASSERT_EQ(parser.byteOrder(), byteOrder);
+        ASSERT_EQ(parser.records(), rows);
+        ASSERT_EQ(parser.numQuanities(), 4);
+        ASSERT_EQ(parser.quantityUnit(1), "m/s");
+        ASSERT_EQ(parser.quantityUnit(2), "");
+        ASSERT_EQ(parser.quantityType(2), erg::Type::Int16);
+
+        std::vector<double> t(rows);
+        std::vector<float> v(rows);
+        std::vector<int16_t> g(rows);
+        std::vector<uint8_t> f(rows);
+        ASSERT_EQ(parser.read(0, 0, rows, t.data()), rows);
+        ASSERT_EQ(parser.read(1, 0, rows, v.data()), rows);
+        ASSERT_EQ(parser.read(2, 0, rows, g.data()), rows);
+        ASSERT_EQ(parser.read(3, 0, rows, f.data()), rows);
+        ASSERT_EQ(t, time);
+        ASSERT_EQ(v, speed);
+        ASSERT_EQ(g, gear);
+        ASSERT_EQ(f, flag);
+    }
+
+    erg::Writer writer;
+    ASSERT_ANY_THROW(writer.writeColumns({time.data()}, 1));
+    quantities[3].type = erg::Type::Void;
+    ASSERT_ANY_THROW(writer.open(filename, quantities));
+    quantities[3].type = erg::Type::Uint8;
+    quantities[3].name = "Flag # comment";
+    ASSERT_ANY_THROW(writer.open(filename, quantities));
+    quantities[3].name = quantities[0].name;
+    ASSERT_ANY_THROW(writer.open(filename, quantities));
+    ASSERT_ANY_THROW(writer.open(filename, std::vector<erg::Quantity>()));
+    ASSERT_FALSE(writer.isOpen());
+
+    // No companion file is left when the data file can't be written
+    quantities[3].name = "Flag";
+    std::string folder = path("folder-XXXXXX");
+    ASSERT_NE(mkdtemp(&folder[0]), nullptr);
+    ASSERT_ANY_THROW(writer.open(folder, quantities));
+    ASSERT_FALSE(std::ifstream(folder+".info").is_open());
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
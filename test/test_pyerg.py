@@ -29,6 +29,11 @@
 ## ---------------------------------------------------------------------------- ##
 
 import unittest
+import threading
+import ctypes
+import os
+import shutil
+import tempfile
 import pyerg
 import numpy as np
 
@@ -37,6 +42,58 @@ ERG_1_FILENAME = "../test-data/Test-Dataset-1_175937.erg"
 #ERG_3_FILENAME = "../data/test_data3.erg"
 #ERG_4_FILENAME = "../data/fortran_data.erg"
 
+try:
+    import pyarrow
+except ImportError:
+    pyarrow = None
+
+
+# Structures of the Arrow C data interface, to check the export without pyarrow
+class ArrowSchema(ctypes.Structure):
+    pass
+
+
+ArrowSchema._fields_ = [
+    ('format', ctypes.c_char_p), ('name', ctypes.c_char_p), ('metadata', ctypes.c_void_p),
+    ('flags', ctypes.c_int64), ('n_children', ctypes.c_int64),
+    ('children', ctypes.POINTER(ctypes.POINTER(ArrowSchema))),
+    ('dictionary', ctypes.POINTER(ArrowSchema)),
+    ('release', ctypes.CFUNCTYPE(None, ctypes.POINTER(ArrowSchema))),
+    ('private_data', ctypes.c_void_p)]
+
+
+class ArrowArray(ctypes.Structure):
+    pass
+
+
+ArrowArray._fields_ = [
+    ('length', ctypes.c_int64), ('null_count', ctypes.c_int64), ('offset', ctypes.c_int64),
+    ('n_buffers', ctypes.c_int64), ('n_children', ctypes.c_int64),
+    ('buffers', ctypes.POINTER(ctypes.c_void_p)),
+    ('children', ctypes.POINTER(ctypes.POINTER(ArrowArray))),
+    ('dictionary', ctypes.POINTER(ArrowArray)),
+    ('release', ctypes.CFUNCTYPE(None, ctypes.POINTER(ArrowArray))),
+    ('private_data', ctypes.c_void_p)]
+
+
+class ArrowArrayStream(ctypes.Structure):
+    pass
+
+
+ArrowArrayStream._fields_ = [
+    ('get_schema', ctypes.CFUNCTYPE(ctypes.c_int, ctypes.POINTER(ArrowArrayStream), ctypes.POINTER(ArrowSchema))),
+    ('get_next', ctypes.CFUNCTYPE(ctypes.c_int, ctypes.POINTER(ArrowArrayStream), ctypes.POINTER(ArrowArray))),
+    ('get_last_error', ctypes.CFUNCTYPE(ctypes.c_char_p, ctypes.POINTER(ArrowArrayStream))),
+    ('release', ctypes.CFUNCTYPE(None, ctypes.POINTER(ArrowArrayStream))),
+    ('private_data', ctypes.c_void_p)]
+
+
+def capsule_pointer(capsule, name, struct):
+    get_pointer = ctypes.pythonapi.PyCapsule_GetPointer
+    get_pointer.restype = ctypes.c_void_p
+    get_pointer.argtypes = [ctypes.py_object, ctypes.c_char_p]
+    return ctypes.cast(get_pointer(capsule, name), ctypes.POINTER(struct)).contents
+
 
 class TestPyergReader(unittest.TestCase):
 
@@ -220,6 +277,386 @@ class TestPyergReader(unittest.TestCase):
         self.assertEquals(len(t2), 90)
         self.assertTrue(np.all(t2 == t[10:100]))
 
+    def test_ReadNames(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        t = parser.read('Time', start=10, count=90)
+        v = parser.read('Vhcl.v', start=10, count=90)
+
+        data = parser.read(names=['Time', 'Vhcl.v'], start=10, count=90)
+        self.assertEqual(sorted(data.keys()), ['Time', 'Vhcl.v'])
+        self.assertTrue(np.all(data['Time'] == t))
+        self.assertTrue(np.all(data['Vhcl.v'] == v))
+        self.assertRaises(NameError, parser.read, names=['Time', '$none$'])
+        self.assertRaises(ValueError, parser.read, names=['Time', 'Time'])
+        self.assertRaises(ValueError, parser.readTimeRange, 0.0, 1.0, columns=['Time', 'Time'])
+
+    def test_ReadSlice(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        t = parser.read('Time')
+        self.assertTrue(np.all(parser.read('Time', start=10, count=90, step=10) == t[10:910:10]))
+        self.assertTrue(np.all(parser.read('Time', slice(5, None, 100)) == t[5::100]))
+        self.assertTrue(np.all(parser['Time'] == t))
+        self.assertTrue(np.all(parser['Time', -1000::7] == t[-1000::7]))
+        data = parser[['Time', 'Vhcl.v'], ::10]
+        self.assertTrue(np.all(data['Time'] == t[::10]))
+        self.assertRaises(ValueError, parser.read, 'Time', step=0)
+
+    def test_ReadDtype(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        v = parser.read('Vhcl.v')
+        data = parser.read('Vhcl.v', dtype=np.float64)
+        self.assertEqual(data.dtype, np.float64)
+        self.assertTrue(np.all(data == v.astype(np.float64)))
+        data = parser.readAll(dtype=np.float32)
+        self.assertTrue(all(a.dtype == np.float32 for a in data.values()))
+        self.assertRaises(TypeError, parser.read, 'Time', dtype=np.complex128)
+
+    def test_IterChunks(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        expected = parser.read(names=['Time', 'Vhcl.v'])
+        chunks = list(parser.iter_chunks(rows=1000, columns=['Time', 'Vhcl.v']))
+        self.assertTrue(all(len(c['Time']) <= 1000 for c in chunks))
+        self.assertTrue(np.all(np.concatenate([c['Vhcl.v'] for c in chunks]) == expected['Vhcl.v']))
+        self.assertRaises(ValueError, parser.iter_chunks, rows=0)
+
+    def test_ReadNew(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        recordSize = parser.recordSize()
+        expected = parser.read('Vhcl.v', count=300)
+        parser.close()
+
+        with open(ERG_1_FILENAME, 'rb') as f:
+            content = f.read(16 + 300 * recordSize)
+        folder = tempfile.mkdtemp()
+        filename = os.path.join(folder, 'follow.erg')
+        shutil.copy(ERG_1_FILENAME + '.info', filename + '.info')
+        try:
+            with open(filename, 'wb') as f:
+                f.write(content[:16 + 100 * recordSize + 5])
+            parser.open(filename)
+            self.assertTrue(np.all(parser.read_new(['Vhcl.v'])['Vhcl.v'] == expected[:100]))
+            self.assertEqual(len(parser.read_new(['Vhcl.v'])['Vhcl.v']), 0)
+            with open(filename, 'ab') as f:
+                f.write(content[16 + 100 * recordSize + 5:])
+            self.assertEqual(parser.refresh(), 200)
+            self.assertTrue(np.all(parser.read_new(['Vhcl.v'], timeout=1.0)['Vhcl.v'] == expected[100:]))
+            self.assertRaises(ValueError, parser.read_new, ['Vhcl.v', 'Vhcl.v'])
+            parser.close()
+        finally:
+            shutil.rmtree(folder)
+
+    def test_Prefetch(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        expected = parser.read('Vhcl.v')
+        parser.setPrefetch(2)
+        self.assertEqual(parser.prefetch(), 2)
+        self.assertTrue(np.all(parser.read('Vhcl.v') == expected))
+
+    def test_Access(self):
+        expected = self.parser
+        expected.open(ERG_1_FILENAME)
+        t = expected.read('Time')
+        for access in ['sequential', 'random', 'once', 'normal']:
+            parser = pyerg.Reader(ERG_1_FILENAME, access=access)
+            self.assertEqual(parser.access(), access)
+            self.assertTrue(np.all(parser.read('Time') == t))
+        parser.setAccess('direct')
+        self.assertIn(parser.access(), ['direct', 'once'])
+        self.assertTrue(np.all(parser.read('Time', start=5, count=100) == t[5:105]))
+        self.assertRaises(ValueError, parser.setAccess, 'unknown')
+
+    def test_Cache(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        parser.setCacheSize(64 * 1024 * 1024)
+        self.assertEqual(parser.cacheSize(), 64 * 1024 * 1024)
+        v = parser.read('Vhcl.v')
+        self.assertTrue(np.all(parser.read('Vhcl.v', start=10, count=100) == v[10:110]))
+        stats = parser.cacheStats()
+        self.assertEqual(stats['misses'], 1)
+        self.assertEqual(stats['hits'], 1)
+        d = parser.read('Vhcl.v', start=10, count=100, dtype=np.float64)
+        self.assertTrue(np.all(d == v[10:110]))
+        self.assertEqual(parser.cacheStats()['hits'], 2)
+        # A window of a missing dataset is read from the file, most of it loads all of it
+        parser.read('Time', start=5, count=10)
+        self.assertEqual(parser.cacheStats()['columns'], 1)
+        parser.read('Time', start=5)
+        self.assertEqual(parser.cacheStats()['columns'], 2)
+        self.assertTrue(np.all(parser.read('Time', start=50, count=10) == parser.read('Time')[50:60]))
+        self.assertEqual(parser.cacheStats()['misses'], 3)
+        parser.close()
+        self.assertEqual(parser.cacheStats()['columns'], 0)
+
+    def test_Sidecar(self):
+        folder = tempfile.mkdtemp()
+        filename = os.path.join(folder, 'sidecar.erg')
+        shutil.copy(ERG_1_FILENAME, filename)
+        shutil.copy(ERG_1_FILENAME + '.info', filename + '.info')
+        try:
+            expected = pyerg.read(filename, columns=['Vhcl.v'])['Vhcl.v']
+            parser = pyerg.Reader(filename, sidecar='build')
+            self.assertTrue(parser.hasSidecar())
+            self.assertTrue(np.all(parser.read('Vhcl.v') == expected))
+            parser.close()
+            parser = pyerg.Reader(filename, sidecar='ignore')
+            self.assertFalse(parser.hasSidecar())
+            parser.close()
+        finally:
+            shutil.rmtree(folder)
+
+    def test_TimeRange(self):
+        folder = tempfile.mkdtemp()
+        filename = os.path.join(folder, 'tidx.erg')
+        shutil.copy(ERG_1_FILENAME, filename)
+        shutil.copy(ERG_1_FILENAME + '.info', filename + '.info')
+        try:
+            parser = pyerg.Reader(filename)
+            time = parser.read('Time')
+            speed = parser.read('Vhcl.v')
+            t0, t1 = time[1000], time[2500]
+            self.assertEqual(parser.recordAt(t0), 1000)
+            self.assertEqual(parser.recordAt(time[-1] + 1.0), parser.records())
+            data = parser.readTimeRange(t0, t1, columns=['Vhcl.v'])
+            self.assertTrue(np.all(data['Vhcl.v'] == speed[1000:2501]))
+            self.assertEqual(len(parser.readTimeRange(t1, t0, columns=['Vhcl.v'])['Vhcl.v']), 0)
+
+            self.assertFalse(parser.hasTimeIndex())
+            parser.buildTimeIndex(block=100)
+            parser.close()
+            parser = pyerg.Reader(filename)
+            self.assertTrue(parser.hasTimeIndex())
+            self.assertEqual(parser.recordAt(t0), 1000)
+            data = parser.readTimeRange(t0, t1, columns=['Time'], dtype=np.float32)
+            self.assertEqual(data['Time'].dtype, np.float32)
+            self.assertEqual(len(data['Time']), 1501)
+            parser.close()
+        finally:
+            shutil.rmtree(folder)
+
+    def test_Where(self):
+        folder = tempfile.mkdtemp()
+        filename = os.path.join(folder, 'zmap.erg')
+        shutil.copy(ERG_1_FILENAME, filename)
+        shutil.copy(ERG_1_FILENAME + '.info', filename + '.info')
+        try:
+            parser = pyerg.Reader(filename)
+            data = parser.read(names=['Time', 'Vhcl.v', 'Car.ax'])
+            limit = (data['Vhcl.v'].min() + data['Vhcl.v'].max()) / 2.0
+            mid = data['Time'][len(data['Time']) // 2]
+            conditions = [('Vhcl.v', '>', limit), ('Time', '>=', mid)]
+            mask = (data['Vhcl.v'] > limit) & (data['Time'] >= mid)
+
+            self.assertFalse(parser.hasZoneMap())
+            for _ in range(2):
+                self.assertTrue(np.all(parser.where(conditions) == np.nonzero(mask)[0]))
+                result = parser.readWhere(conditions, columns=['Car.ax'])
+                self.assertTrue(np.all(result['Car.ax'] == data['Car.ax'][mask]))
+                result = parser.readWhere(conditions, columns=['Car.ax'], dtype=np.float64)
+                self.assertEqual(result['Car.ax'].dtype, np.float64)
+                parser.buildZoneMap(block=256)
+            self.assertTrue(parser.hasZoneMap())
+
+            self.assertRaises(ValueError, parser.where, [('Time', '<>', 0.0)])
+            self.assertRaises(TypeError, parser.where, [('Time', '<')])
+            self.assertRaises(NameError, parser.where, [('NotExists', '<', 0.0)])
+            parser.close()
+        finally:
+            shutil.rmtree(folder)
+
+    def test_Stats(self):
+        parser = self.parser
+        parser.open(ERG_1_FILENAME)
+        speed = parser.read('Vhcl.v').astype(np.float64)
+        for threads in (1, 4):
+            parser.setThreads(threads)
+            stats = parser.stats(columns=['Vhcl.v', 'Time'], bins=8, range=(speed.min(), speed.max()))
+            s = stats['Vhcl.v']
+            self.assertEqual(s['count'], len(speed))
+            self.assertEqual(s['nan'], 0)
+            self.assertEqual(s['min'], speed.min())
+            self.assertEqual(s['max'], speed.max())
+            self.assertAlmostEqual(s['mean'], speed.mean(), delta=1e-9 * abs(speed.mean()) + 1e-12)
+            self.assertAlmostEqual(s['std'], speed.std(), delta=1e-9 * speed.std() + 1e-12)
+            self.assertAlmostEqual(s['rms'], np.sqrt(np.mean(speed ** 2)), delta=1e-9 * s['rms'])
+            histogram, _ = np.histogram(speed, bins=8, range=(speed.min(), speed.max()))
+            self.assertTrue(np.all(s['histogram'] == histogram))
+        s = parser.stats(columns=['Vhcl.v'], start=10, count=100)['Vhcl.v']
+        self.assertEqual(s['count'], 100)
+        self.assertAlmostEqual(s['mean'], speed[10:110].mean())
+        self.assertRaises(ValueError, parser.stats, columns=['Vhcl.v'], bins=4)
+
+    def test_Resample(self):
+        parser = self.parser
+        parser.open(ERG_1_FILENAME)
+        data = parser.read(names=['Time', 'Vhcl.v'])
+        time = data['Time']
+        speed = data['Vhcl.v'].astype(np.float64)
+        dt = (time[-1] - time[0]) / (len(time) - 1) * 2.5
+        t0, t1 = time[0] - 3 * dt, time[-1] + 3 * dt
+        grid = t0 + np.arange(int(np.floor((t1 - t0) / dt + 1e-9)) + 1) * dt
+
+        linear = parser.resample(t0, t1, dt, columns=['Vhcl.v'])['Vhcl.v']
+        self.assertEqual(linear.dtype, np.float64)
+        self.assertTrue(np.allclose(linear, np.interp(grid, time, speed), rtol=1e-12, atol=1e-12))
+        previous = parser.resample(t0, t1, dt, columns=['Vhcl.v'], method='previous')['Vhcl.v']
+        index = np.clip(np.searchsorted(time, grid, side='right') - 1, 0, len(time) - 1)
+        self.assertTrue(np.all(previous == speed[index]))
+        self.assertRaises(ValueError, parser.resample, t0, t1, dt, method='cubic')
+        self.assertRaises(ValueError, parser.resample, t0, t1, 0.0)
+        self.assertRaises(ValueError, parser.resample, t0, t1, dt, columns=['Vhcl.v', 'Vhcl.v'])
+
+    def test_Select(self):
+        parser = self.parser
+        parser.open(ERG_1_FILENAME)
+        names = [parser.quantityName(i) for i in range(parser.numQuanities())]
+        expected = [i for i, name in enumerate(names) if name.startswith('Car.')]
+        self.assertEqual(parser.select('Car.*'), expected)
+        self.assertEqual(parser.select(r'Car\..*', regex=True), expected)
+        self.assertEqual(parser.select('Vhcl.v'), [parser.index('Vhcl.v')])
+        self.assertEqual(parser.select('Missing*'), [])
+        self.assertFalse(parser.has('Missing'))
+        self.assertRaises(ValueError, parser.select, '(', regex=True)
+        data = parser.read(names=parser.select('Car.a?'))
+        self.assertEqual(sorted(data.keys()), ['Car.ax', 'Car.ay', 'Car.az'])
+
+    def test_LazyOpen(self):
+        parser = self.parser
+        parser.open(ERG_1_FILENAME)
+        lazy = pyerg.Reader(ERG_1_FILENAME, lazy=True)
+        self.assertEqual(lazy.records(), parser.records())
+        self.assertEqual(lazy.numQuanities(), parser.numQuanities())
+        self.assertTrue(np.all(lazy.read('Vhcl.v') == parser.read('Vhcl.v')))
+
+        # The parsing error is reported by each access to the quantities
+        folder = tempfile.mkdtemp()
+        filename = os.path.join(folder, 'lazy.erg')
+        shutil.copy(ERG_1_FILENAME, filename)
+        with open(filename + '.info', 'w') as info:
+            info.write('#INFOFILE1.1 - Do not remove this line!\n'
+                       'File.Format = erg\n'
+                       'File.ByteOrder = LittleEndian\n'
+                       'File.At.1.Name = Time\n'
+                       'File.At.1.Type = Double\n')
+        try:
+            lazy = pyerg.Reader(filename, lazy=True)
+            with self.assertRaises(NameError) as error:
+                lazy['Time']
+            self.assertNotIn('does not exists', str(error.exception))
+            self.assertRaises(RuntimeError, lazy.has, 'Time')
+            self.assertRaises(RuntimeError, lazy.select, 'T*')
+            self.assertRaises(RuntimeError, lazy.select, 'T.*', regex=True)
+            self.assertRaises(RuntimeError, lazy.numQuanities)
+            lazy.close()
+        finally:
+            shutil.rmtree(folder)
+
+    def test_View(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        expected = parser.read(names=['Time', 'Vhcl.v'])
+        view = parser.view('Vhcl.v')
+        self.assertFalse(view.flags.writeable)
+        self.assertEqual(view.strides[0], parser.recordSize())
+        views = parser.view(['Time', 'Vhcl.v'])
+        # The views keep the mapping alive
+        parser.close()
+        self.assertTrue(np.all(view == expected['Vhcl.v']))
+        self.assertTrue(np.all(views['Time'] == expected['Time']))
+
+    def test_ConcurrentRead(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        names = ['Time', 'Vhcl.v', 'Car.ax', 'Car.ay']
+        expected = parser.read(names=names)
+        results = {}
+
+        def worker(name):
+            results[name] = parser.read(name)
+
+        threads = [threading.Thread(target=worker, args=(n,)) for n in names]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        for name in names:
+            self.assertTrue(np.all(results[name] == expected[name]))
+
+    def test_Arrow(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        names = ['Time', 'Vhcl.v']
+        expected = parser.read(names=names)
+        batch = parser.arrow(names, start=10, count=100)
+        self.assertEqual(len(batch), 100)
+        self.assertRaises(ValueError, parser.arrow, start=-1)
+        self.assertRaises(NameError, parser.arrow, ['Missing'])
+
+        schema_capsule, array_capsule = batch.__arrow_c_array__()
+        schema = capsule_pointer(schema_capsule, b'arrow_schema', ArrowSchema)
+        array = capsule_pointer(array_capsule, b'arrow_array', ArrowArray)
+        self.assertEqual(schema.format, b'+s')
+        self.assertEqual(schema.n_children, 2)
+        self.assertEqual(array.length, 100)
+        self.assertEqual(array.n_children, 2)
+        for i, name in enumerate(names):
+            field = schema.children[i].contents
+            self.assertEqual(field.name, name.encode())
+            self.assertEqual(field.format, b'g' if expected[name].dtype == np.float64 else b'f')
+            self.assertTrue(field.metadata)
+            column = array.children[i].contents
+            self.assertEqual(column.null_count, 0)
+            self.assertEqual(column.n_buffers, 2)
+            values = np.ctypeslib.as_array(
+                ctypes.cast(column.buffers[1], ctypes.POINTER(np.ctypeslib.as_ctypes_type(expected[name].dtype))),
+                shape=(100,))
+            self.assertTrue(np.all(values == expected[name][10:110]))
+
+        # A consumer moves the children and releases the parent
+        array.release(ctypes.pointer(array))
+        self.assertFalse(array.release)
+
+        stream_capsule = parser.__arrow_c_stream__()
+        stream = capsule_pointer(stream_capsule, b'arrow_array_stream', ArrowArrayStream)
+        schema = ArrowSchema()
+        self.assertEqual(stream.get_schema(ctypes.pointer(stream), ctypes.pointer(schema)), 0)
+        self.assertEqual(schema.n_children, parser.numQuanities())
+        schema.release(ctypes.pointer(schema))
+        array = ArrowArray()
+        self.assertEqual(stream.get_next(ctypes.pointer(stream), ctypes.pointer(array)), 0)
+        self.assertEqual(array.length, parser.records())
+        array.release(ctypes.pointer(array))
+        self.assertEqual(stream.get_next(ctypes.pointer(stream), ctypes.pointer(array)), 0)
+        self.assertFalse(array.release)
+
+    @unittest.skipIf(pyarrow is None, "pyarrow is not available")
+    def test_ArrowTable(self):
+        parser = self.parser
+
+        parser.open(ERG_1_FILENAME)
+        table = pyarrow.table(parser)
+        self.assertEqual(table.num_rows, parser.records())
+        self.assertTrue(np.all(table.column('Vhcl.v').to_numpy() == parser.read('Vhcl.v')))
+        unit = table.schema.field('Vhcl.v').metadata[b'unit'].decode()
+        self.assertEqual(unit, parser.quantityUnit(parser.index('Vhcl.v')))
+
 
 class TestPyerg(unittest.TestCase):
 
@@ -233,12 +670,111 @@ class TestPyerg(unittest.TestCase):
         t1 = data['Data_8']
         self.assertTrue(np.all(t0 == t1))
 
+    def test_read_columns(self):
+        data = pyerg.read(ERG_1_FILENAME, columns=['Time'])
+        self.assertEqual(list(data.keys()), ['Time'])
+
+    def test_read_many(self):
+        expected = pyerg.read(ERG_1_FILENAME, columns=['Time', 'Vhcl.v'])
+        paths = [ERG_1_FILENAME] * 4
+        seen = 0
+        for filename, data in pyerg.read_many(paths, columns=['Time', 'Vhcl.v'], workers=2, chunk=1000):
+            self.assertEqual(filename, ERG_1_FILENAME)
+            self.assertEqual(sorted(data.keys()), ['Time', 'Vhcl.v'])
+            self.assertEqual(data['Vhcl.v'].dtype, expected['Vhcl.v'].dtype)
+            self.assertTrue(np.all(data['Vhcl.v'] == expected['Vhcl.v']))
+            seen += 1
+        self.assertEqual(seen, len(paths))
+
+        batch = pyerg.read_many(['missing.erg'])
+        self.assertRaises(RuntimeError, next, batch)
+        self.assertRaises(StopIteration, next, batch)
+        self.assertRaises(ValueError, pyerg.read_many, paths, chunk=0)
+        self.assertRaises(ValueError, pyerg.read_many, paths, workers=100000)
+
+    def test_read_segments(self):
+        parser = pyerg.Reader()
+        parser.open(ERG_1_FILENAME)
+        recordSize = parser.recordSize()
+        records = parser.records()
+        expected = parser.read(names=['Time', 'Vhcl.v'])
+        parser.close()
+
+        with open(ERG_1_FILENAME, 'rb') as f:
+            content = f.read()
+        folder = tempfile.mkdtemp()
+        try:
+            paths = []
+            bounds = [0, records // 4, records // 2, records]
+            for i in range(len(bounds) - 1):
+                filename = os.path.join(folder, 'segment%d.erg' % i)
+                with open(filename, 'wb') as f:
+                    f.write(content[:16])
+                    f.write(content[16 + bounds[i] * recordSize:16 + bounds[i + 1] * recordSize])
+                shutil.copy(ERG_1_FILENAME + '.info', filename + '.info')
+                paths.append(filename)
+
+            data = pyerg.read_segments(paths, columns=['Time', 'Vhcl.v'], threads=2)
+            self.assertTrue(np.all(data['Time'] == expected['Time']))
+            self.assertTrue(np.all(data['Vhcl.v'] == expected['Vhcl.v']))
+            start = records // 4 - 10
+            data = pyerg.read_segments(paths, columns=['Vhcl.v'], start=start, count=records // 2,
+                                       dtype=np.float64)
+            self.assertEqual(data['Vhcl.v'].dtype, np.float64)
+            self.assertTrue(np.all(data['Vhcl.v'] == expected['Vhcl.v'][start:start + records // 2]))
+            self.assertRaises(NameError, pyerg.read_segments, paths, columns=['Missing'])
+            self.assertRaises(ValueError, pyerg.read_segments, paths, columns=['Time', 'Time'])
+            self.assertRaises(NameError, pyerg.read_segments, paths + ['missing.erg'])
+        finally:
+            shutil.rmtree(folder)
+
+    def test_write(self):
+        data = {
+            'Time': np.arange(1000) * 0.01,
+            'Vhcl.v': np.linspace(0, 30, 1000, dtype=np.float32),
+            'Gear': (np.arange(1000) % 6).astype(np.int16)[::-1],
+            'Flag': np.arange(1000) % 2 == 0,
+        }
+        folder = tempfile.mkdtemp()
+        try:
+            for byteorder in ['little', 'big']:
+                filename = os.path.join(folder, 'write_%s.erg' % byteorder)
+                pyerg.write(filename, data, units={'Time': 's', 'Vhcl.v': 'm/s'}, byteorder=byteorder)
+                self.assertEqual(pyerg.probe(filename)['byteOrder'], byteorder)
+
+                parser = pyerg.Reader(filename)
+                self.assertEqual(parser.records(), 1000)
+                self.assertEqual(parser.quantityUnit(parser.index('Vhcl.v')), 'm/s')
+                self.assertEqual(parser.quantityUnit(parser.index('Gear')), '')
+                written = parser.readAll()
+                for name, values in data.items():
+                    self.assertTrue(np.all(written[name] == values))
+                self.assertEqual(written['Vhcl.v'].dtype, np.float32)
+                self.assertEqual(written['Flag'].dtype, np.uint8)
+
+            filename = os.path.join(folder, 'error.erg')
+            self.assertRaises(ValueError, pyerg.write, filename, {'a': np.zeros(2), 'b': np.zeros(3)})
+            self.assertRaises(TypeError, pyerg.write, filename, {'a': np.array(['x'])})
+            self.assertRaises(ValueError, pyerg.write, filename, data, byteorder='middle')
+            self.assertRaises(NameError, pyerg.write, filename, {'a#b': np.zeros(2)})
+        finally:
+            shutil.rmtree(folder)
+
     def test_CanRead(self):
         self.assertTrue(pyerg.can_read(ERG_1_FILENAME))
         #self.assertTrue(pyerg.can_read(ERG_2_FILENAME))
         #self.assertFalse(pyerg.can_read(ERG_3_FILENAME))
         #self.assertTrue(pyerg.can_read(ERG_4_FILENAME))
 
+    def test_probe(self):
+        info = pyerg.probe(ERG_1_FILENAME)
+        parser = pyerg.Reader(ERG_1_FILENAME)
+        self.assertEqual(info['format'], 'erg')
+        self.assertEqual(info['recordSize'], parser.recordSize())
+        self.assertEqual(info['records'], parser.records())
+        self.assertRaises(NameError, pyerg.probe, 'missing.erg')
+        self.assertFalse(pyerg.can_read('missing.erg'))
+
     def test_version(self):
         self.assertTrue(isinstance(pyerg.__version__, str))
 